@@ -2,12 +2,23 @@
 #include <ddraw.h>
 #include <dsound.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <intrin.h>
 #include "math/math.h"
 #include "font/font.h"
 #include "ui/ui.h"
+#include "draw/draw.h"
+#include "draw/span.h"
+#include "draw/drawlist.h"
+#include "draw/raster.h"
+#include "draw/damage.h"
+#include "utils/clock.h"
+#include "utils/threads.h"
+#include "utils/inputqueue.h"
+#include "utils/inputrecord.h"
+#include "bench.h"
 
 LPDIRECTDRAW7 lpDD=NULL;
 LPDIRECTDRAWSURFACE7 lpDDSFront=NULL;
@@ -17,6 +28,7 @@ HWND hWnd=NULL;
 char *szAppName="DirectDraw";
 
 uint32_t Width=512, Height=512;
+uint32_t BytesPerPixel=4;
 
 bool Done=false, Key[256];
 bool MouseClicked=false;
@@ -26,8 +38,70 @@ double fTimeStep, fTime=0.0;
 
 float X=0.0f, Y=0.0f;
 
+// The window procedure only queues input, each frame takes all of it at once from Input
+InputQueue_t InputQueue;
+InputSnapshot_t Input;
+
 UI_t UI;
 
+// Frame is recorded into the draw list, then binned into tiles and rasterized across all cores
+DrawList_t DrawList;
+Raster_t Raster;
+
+// Only the parts of the back buffer that changed get redrawn and presented, it keeps its contents between frames
+Damage_t Damage;
+Damage_Region_t TextRegion, PhysicsRegion, CursorRegion;
+
+// Where the part LateLatch can record again starts in the frame's draw list
+size_t LateMark=0;
+
+void DamageAll(void)
+{
+	Damage_Add(&Damage, (DrawRect_t){ 0, 0, (int32_t)Width-1, (int32_t)Height-1 });
+}
+
+// Idle mode sleeps in the message loop until something could change the picture, -continuous renders nonstop instead.
+// FramesRendered only counts frames that actually drew, so it stays put while idle.
+bool IdleMode=true;
+bool Invalidated=true;
+bool SimulationActive=true;
+uint64_t FramesRendered=0;
+
+// -latelatch samples the cursor again just before presenting and redraws only what follows it (the dragged slider and
+// a cursor marker). -latency measures from the newest input a frame used to when it was presented, see latency_output.txt.
+bool LateLatchMode=false;
+bool LatencyMode=false;
+double InputTime=0.0;
+double LatencySum=0.0, LatencyMax=0.0;
+uint64_t LatencyFrames=0;
+
+// -record [file] writes every frame's input and time step to input_record.bin (or the file given). -replay [file] plays
+// one back headless at a fixed time step and writes per-frame timings and framebuffer hashes to replay_output.txt, so
+// two builds can be compared on the exact same mouse path.
+#define REPLAY_TIMESTEP (1.0/60.0)
+
+bool RecordMode=false;
+InputRecord_t Recording;
+
+// Set while replaying, frames are drawn into it instead of the back buffer
+RenderTarget_t *ReplayTarget=NULL;
+
+// Button messages are cleared by a window timer, so they wake an idle loop when they run out
+#define MESSAGE_TIMEOUT 2000
+
+enum
+{
+	TIMER_MESSAGE1=1,
+	TIMER_MESSAGE2
+};
+
+bool Message1=false, Message2=false;
+
+bool FrameNeeded(void)
+{
+	return Invalidated||SimulationActive||!InputQueue_IsEmpty(&InputQueue)||UI_IsInvalidated(&UI)||UI_HasPendingEvents(&UI)||!Damage_IsEmpty(&Damage);
+}
+
 typedef struct
 {
 	vec2 Position;
@@ -96,25 +170,56 @@ Stick_t Sticks[6];
 
 LRESULT CALLBACK WndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
 void Render(void);
+void RecordLateLayer(RenderTarget_t *Recorder, Damage_t *Damage);
+void DrawDamageTo(RenderTarget_t *Target, const Damage_t *Damage);
+void DrawDamage(const Damage_t *Damage);
+void LateLatch(void);
+void WriteLatency(const char *Filename);
+void GetOptionValue(const char *CmdLine, const char *Option, char *Value, size_t Size, const char *Default);
+bool Replay(const char *Filename, const char *OutputFilename);
 int Init(void);
 int Create(void);
 void Destroy(void);
 
-double GetClock(void)
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int iCmdShow)
 {
-	static uint64_t Frequency=0;
-	uint64_t Count;
+	// Pick the fastest row kernels this CPU supports
+	Span_Init();
 
-	if(!Frequency)
-		QueryPerformanceFrequency((LARGE_INTEGER *)&Frequency);
+	// Headless benchmark mode, no window or DirectDraw needed
+	if(lpCmdLine&&strstr(lpCmdLine, "-bench"))
+		return Bench_Run("bench_output.txt")?0:-1;
 
-	QueryPerformanceCounter((LARGE_INTEGER *)&Count);
+	// Headless replay of a recorded session, no window or DirectDraw either
+	if(lpCmdLine&&strstr(lpCmdLine, "-replay"))
+	{
+		char Filename[MAX_PATH];
 
-	return (double)Count/Frequency;
-}
+		GetOptionValue(lpCmdLine, "-replay", Filename, sizeof(Filename), "input_record.bin");
+
+		return Replay(Filename, "replay_output.txt")?0:-1;
+	}
+
+	if(lpCmdLine&&strstr(lpCmdLine, "-continuous"))
+		IdleMode=false;
+
+	if(lpCmdLine&&strstr(lpCmdLine, "-latelatch"))
+		LateLatchMode=true;
+
+	if(lpCmdLine&&strstr(lpCmdLine, "-latency"))
+		LatencyMode=true;
+
+	char RecordFilename[MAX_PATH];
+
+	if(lpCmdLine&&strstr(lpCmdLine, "-record"))
+	{
+		GetOptionValue(lpCmdLine, "-record", RecordFilename, sizeof(RecordFilename), "input_record.bin");
+		RecordMode=true;
+
+		// Late latched positions never go through the input queue, a replay couldn't reproduce them
+		LateLatchMode=false;
+	}
 
-int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int iCmdShow)
-{
 	WNDCLASS wc;
 	wc.style=CS_VREDRAW|CS_HREDRAW|CS_OWNDC;
 	wc.lpfnWndProc=WndProc;
@@ -155,6 +260,14 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 		return -1;
 	}
 
+	if(RecordMode&&!InputRecord_Create(&Recording, RecordFilename, Width, Height))
+	{
+		MessageBox(hWnd, "InputRecord_Create failed.", "Error", MB_OK);
+		Destroy();
+		DestroyWindow(hWnd);
+		return -1;
+	}
+
 	MSG msg={ 0 };
 	while(!Done)
 	{
@@ -168,33 +281,89 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 			{
 				TranslateMessage(&msg);
 				DispatchMessage(&msg);
+
+				// Input (or a timer) gets at least one frame, which only draws if it changed anything
+				Invalidated=true;
 			}
 		}
+		else if(IdleMode&&!FrameNeeded())
+		{
+			// Nothing can change until a message arrives, sleeping doesn't count as simulation time
+			MsgWaitForMultipleObjects(0, NULL, FALSE, INFINITE, QS_ALLINPUT);
+			continue;
+		}
 		else
 		{
-			RECT RectSrc, RectDst;
+			RECT RectSrc, RectDst, Client;
 			POINT Point={ 0, 0 };
 
+			// Restored surfaces have lost their contents, so everything needs redrawing
 			if(IDirectDrawSurface7_IsLost(lpDDSBack)==DDERR_SURFACELOST)
+			{
 				IDirectDrawSurface7_Restore(lpDDSBack);
+				DamageAll();
+			}
 
 			if(IDirectDrawSurface7_IsLost(lpDDSFront)==DDERR_SURFACELOST)
+			{
 				IDirectDrawSurface7_Restore(lpDDSFront);
+				DamageAll();
+			}
 
 			Render();
+			LateLatch();
 
 			ClientToScreen(hWnd, &Point);
-			GetClientRect(hWnd, &RectDst);
-			OffsetRect(&RectDst, Point.x, Point.y);
-			SetRect(&RectSrc, 0, 0, Width, Height);
+			GetClientRect(hWnd, &Client);
+
+			if(Client.right-Client.left==(LONG)Width&&Client.bottom-Client.top==(LONG)Height)
+			{
+				// 1:1 with the window, so just present the damaged rects
+				for(uint32_t i=0;i<Damage.NumRects;i++)
+				{
+					const DrawRect_t *Rect=&Damage.Rects[i];
 
-			IDirectDrawSurface7_Blt(lpDDSFront, &RectDst, lpDDSBack, &RectSrc, DDBLT_WAIT, NULL);
+					SetRect(&RectSrc, Rect->MinX, Rect->MinY, Rect->MaxX+1, Rect->MaxY+1);
+					RectDst=RectSrc;
+					OffsetRect(&RectDst, Point.x, Point.y);
+
+					IDirectDrawSurface7_Blt(lpDDSFront, &RectDst, lpDDSBack, &RectSrc, DDBLT_WAIT, NULL);
+				}
+			}
+			else if(!Damage_IsEmpty(&Damage))
+			{
+				// Stretched, damaged rects don't map to whole pixels on screen, present all of it
+				RectDst=Client;
+				OffsetRect(&RectDst, Point.x, Point.y);
+				SetRect(&RectSrc, 0, 0, Width, Height);
+
+				IDirectDrawSurface7_Blt(lpDDSFront, &RectDst, lpDDSBack, &RectSrc, DDBLT_WAIT, NULL);
+			}
+
+			// Only frames that showed something count, input that changed nothing has nothing to be late for
+			if(LatencyMode&&InputTime>0.0&&!Damage_IsEmpty(&Damage))
+			{
+				const double Latency=GetClock()-InputTime;
+
+				LatencySum+=Latency;
+				LatencyMax=max(LatencyMax, Latency);
+				LatencyFrames++;
+			}
+
+			InputTime=0.0;
+			Damage_Clear(&Damage);
 		}
 
 		fTimeStep=(float)(GetClock()-StartTime);
 		fTime+=fTimeStep;
 	}
 
+	if(LatencyMode)
+		WriteLatency("latency_output.txt");
+
+	if(RecordMode)
+		InputRecord_Close(&Recording);
+
 	Destroy();
 	DestroyWindow(hWnd);
 
@@ -203,8 +372,6 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 
 #include <windowsx.h>
 
-uint32_t ActiveID=UINT32_MAX;
-
 LRESULT CALLBACK WndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 {
 	switch(uMsg)
@@ -219,424 +386,524 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 	case WM_DESTROY:
 		break;
 
+	// Anything uncovering or moving the window needs the whole back buffer presented again
+	case WM_PAINT:
 	case WM_SIZE:
+	case WM_MOVE:
+		DamageAll();
 		break;
 
+	// Input is only queued here, ProcessInput handles it at the start of the next frame
 	case WM_LBUTTONDOWN:
 	case WM_MBUTTONDOWN:
 	case WM_RBUTTONDOWN:
-		ShowCursor(FALSE);
-
-		X=(float)GET_X_LPARAM(lParam);
-		Y=(float)GET_Y_LPARAM(lParam);
-
-		MouseClicked=true;
-		ActiveID=UI_TestHit(&UI, Vec2(X, Y));
+		InputQueue_Push(&InputQueue, INPUT_BUTTON_DOWN, uMsg==WM_LBUTTONDOWN?0:uMsg==WM_RBUTTONDOWN?1:2, (float)GET_X_LPARAM(lParam), (float)GET_Y_LPARAM(lParam));
 		break;
 
 	case WM_LBUTTONUP:
 	case WM_MBUTTONUP:
 	case WM_RBUTTONUP:
-		ShowCursor(TRUE);
-		MouseClicked=false;
-
-		ActiveID=UINT32_MAX;
+		InputQueue_Push(&InputQueue, INPUT_BUTTON_UP, uMsg==WM_LBUTTONUP?0:uMsg==WM_RBUTTONUP?1:2, (float)GET_X_LPARAM(lParam), (float)GET_Y_LPARAM(lParam));
 		break;
 
 	case WM_MOUSEMOVE:
-		if(MouseClicked)
-		{
-			X=(float)GET_X_LPARAM(lParam);
-			Y=(float)GET_Y_LPARAM(lParam);
-
-			if(ActiveID!=UINT32_MAX)
-				UI_ProcessControl(&UI, ActiveID, Vec2(X, Y));
-		}
+		InputQueue_Push(&InputQueue, INPUT_MOVE, 0, (float)GET_X_LPARAM(lParam), (float)GET_Y_LPARAM(lParam));
 		break;
 
 	case WM_KEYDOWN:
-		Key[wParam]=true;
-
-		switch(wParam)
-		{
-		case VK_SPACE:
-			Points[0].Locked=!Points[0].Locked;
-			break;
-
-		case VK_ESCAPE:
-			PostQuitMessage(0);
-			break;
-
-		default:
-			break;
-		}
+		InputQueue_Push(&InputQueue, INPUT_KEY_DOWN, (uint16_t)(wParam&0xFF), 0.0f, 0.0f);
 		break;
 
 	case WM_KEYUP:
-		Key[wParam]=false;
+		InputQueue_Push(&InputQueue, INPUT_KEY_UP, (uint16_t)(wParam&0xFF), 0.0f, 0.0f);
+		break;
+
+	case WM_TIMER:
+		KillTimer(hWnd, wParam);
+
+		if(wParam==TIMER_MESSAGE1)
+			Message1=false;
+		else if(wParam==TIMER_MESSAGE2)
+			Message2=false;
 		break;
 	}
 
 	return DefWindowProc(hWnd, uMsg, wParam, lParam);
 }
 
-void Clear(LPDIRECTDRAWSURFACE7 lpDDS)
+vec2 SpherePointCollision(vec2 Point, vec2 Collider, float Radius)
 {
-	DDBLTFX ddbltfx;
+	vec2 SphereDistance=Vec2_Subv(Point, Collider);
 
-	ddbltfx.dwSize=sizeof(DDBLTFX);
-	ddbltfx.dwFillColor=0x00000000;
+	if(Vec2_Dot(SphereDistance, SphereDistance)<Radius*Radius)
+	{
+		Vec2_Normalize(&SphereDistance);
 
-	if(IDirectDrawSurface7_Blt(lpDDS, NULL, NULL, NULL, DDBLT_COLORFILL, &ddbltfx)!=DD_OK)
-		return;
+		return Vec2(Collider.x+SphereDistance.x*Radius, Collider.y+SphereDistance.y*Radius);
+	}
+
+	return Point;
 }
 
-void point(DDSURFACEDESC2 ddsd, uint32_t x, uint32_t y, float c[3])
+void KeepInsideView(Point_t *Point, int windowWidth, int windowHeight)
 {
-	if(x<1)
-		return;
-	if(x>ddsd.dwWidth-1)
-		return;
-	if(y<1)
-		return;
-	if(y>ddsd.dwHeight-1)
-		return;
+	if(Point->Position.x>windowWidth)
+	{
+		Point->Position.x=(float)windowWidth;
+		Point->PrevPosition.x=Point->Position.x;
+	}
+	else if(Point->Position.x<0.0f)
+	{
+		Point->Position.x=0.0f;
+		Point->PrevPosition.x=Point->Position.x;
+	}
 
-	int i=(y*ddsd.lPitch+x*(ddsd.ddpfPixelFormat.dwRGBBitCount>>3));
+	if(Point->Position.y>windowHeight)
+	{
+		Point->Position.y=(float)windowHeight;
+		Point->PrevPosition.y=Point->Position.y;
+	}
+	else if(Point->Position.y<0.0f)
+	{
+		Point->Position.y=0.0f;
+		Point->PrevPosition.y=Point->Position.y;
+	}
+}
 
-	((uint8_t *)ddsd.lpSurface)[i+0]=(unsigned char)(c[2]*255.0f)&0xFF;
-	((uint8_t *)ddsd.lpSurface)[i+1]=(unsigned char)(c[1]*255.0f)&0xFF;
-	((uint8_t *)ddsd.lpSurface)[i+2]=(unsigned char)(c[0]*255.0f)&0xFF;
+bool SphereSphereIntersect(vec2 PositionA, float RadiusA, vec2 PositionB, float RadiusB)
+{
+	float RadSum=RadiusA+RadiusB;
+	return Vec2_Dot(PositionA, PositionB)<=RadSum*RadSum;
 }
 
-void line(DDSURFACEDESC2 ddsd, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, float c[3])
+// Bound to the controls, input writes straight into these and they're only redrawn when they change
+float BargraphValue=1.0f;
+bool CheckboxValue=true;
+vec3 BargraphColor={ 1.0f, 1.0f, 1.0f };
+
+uint32_t CheckboxID=UINT32_MAX;
+uint32_t BargraphID=UINT32_MAX;
+uint32_t BargraphROID=UINT32_MAX;
+uint32_t RedID=UINT32_MAX;
+uint32_t GreenID=UINT32_MAX;
+uint32_t BlueID=UINT32_MAX;
+uint32_t ColorPanelID=UINT32_MAX;
+
+// Takes everything queued since the last frame and applies it in order, so the UI and physics see one consistent snapshot.
+// Moves arrive already merged, a fast mouse costs one hover test or drag per frame instead of one per message.
+void ProcessInput(void)
 {
-	int32_t dx=abs(x1-x0), sx=x0<x1?1:-1;
-	int32_t dy=abs(y1-y0), sy=y0<y1?1:-1;
+	InputQueue_Drain(&InputQueue, &Input);
 
-	int32_t err=(dx>dy?dx:-dy)/2;
+	if(Input.NumEvents)
+		InputTime=Input.Time;
 
-	while(point(ddsd, x0, y0, c), x0!=x1||y0!=y1)
+	for(uint32_t i=0;i<Input.NumEvents;i++)
 	{
-		int32_t e2=err;
+		const InputEvent_t *Event=&Input.Events[i];
 
-		if(e2>-dx)
+		switch(Event->Type)
 		{
-			err-=dy;
-			x0+=sx;
-		}
+		case INPUT_BUTTON_DOWN:
+			ShowCursor(FALSE);
 
-		if(e2<dy)
-		{
-			err+=dx;
-			y0+=sy;
+			X=Event->X;
+			Y=Event->Y;
+
+			// Whatever this hits takes the drag until the button comes up
+			MouseClicked=true;
+			UI_TestHit(&UI, Vec2(X, Y));
+			break;
+
+		case INPUT_BUTTON_UP:
+			ShowCursor(TRUE);
+			MouseClicked=false;
+
+			UI_ReleaseCapture(&UI);
+			break;
+
+		case INPUT_MOVE:
+			if(MouseClicked)
+			{
+				X=Event->X;
+				Y=Event->Y;
+
+				UI_ProcessCapture(&UI, Vec2(X, Y));
+			}
+			else
+				UI_UpdateHover(&UI, Vec2(Event->X, Event->Y));
+			break;
+
+		case INPUT_KEY_DOWN:
+			Key[Event->Code]=true;
+
+			switch(Event->Code)
+			{
+			case VK_SPACE:
+				Points[0].Locked=!Points[0].Locked;
+				break;
+
+			case VK_ESCAPE:
+				Done=true;
+				break;
+
+			default:
+				break;
+			}
+			break;
+
+		case INPUT_KEY_UP:
+			Key[Event->Code]=false;
+			break;
 		}
 	}
 }
 
-void hline(DDSURFACEDESC2 ddsd, uint32_t x0, uint32_t x1, uint32_t y, float c[3])
+void Render(void)
 {
-	uint32_t minX=x0<x1?x0:x1;
-	uint32_t maxX=x0<x1?x1:x0;
+	ProcessInput();
 
-	for(uint32_t i=minX;i<=maxX;i++)
-		point(ddsd, i, y, c);
-}
+	// Exactly what this frame ran on, a replay feeds it back at the same point
+	if(RecordMode)
+		InputRecord_WriteFrame(&Recording, fTimeStep, &Input);
 
-void vline(DDSURFACEDESC2 ddsd, uint32_t x, uint32_t y0, uint32_t y1, float c[3])
-{
-	uint32_t minY=y0<y1?y0:y1;
-	uint32_t maxY=y0<y1?y1:y0;
+	// Button callbacks clicked since the last frame, before anything reads what they change.
+	// A replay runs all of them, how many fit a time budget would depend on the machine and the frame wouldn't reproduce.
+	UI_DispatchEvents(&UI, ReplayTarget!=NULL?0.0:UI_EVENT_BUDGET);
+
+	// Update the first point's position to the mouse movement
+	if(MouseClicked)
+		Points[1].Position=Vec2(X, Y);
+
+	VerletIntegration(4, Points, 6, Sticks, (float)fTimeStep, 10);
+
+	vec2 Collider={ (float)Width/2, (float)Height };
+	float Radius=(float)Height/6;
+
+	for(uint32_t i=0;i<4;i++)
+	{
+		Points[i].Position=SpherePointCollision(Points[i].Position, Collider, Radius);
+		KeepInsideView(&Points[i], Width, Height);
+	}
+
+	// Settled once nothing moves faster than a pixel a second, until the mouse or a key disturbs it again
+	SimulationActive=MouseClicked;
+
+	for(uint32_t i=0;i<4;i++)
+	{
+		if(!Points[i].Locked&&Vec2_Distance(Points[i].Position, Points[i].PrevPosition)>(float)fTimeStep)
+			SimulationActive=true;
+	}
+
+	Invalidated=false;
+
+	// Record the whole frame first, what it recorded decides how much of it needs drawing
+	RenderTarget_t Recorder={ .BytesPerPixel=BytesPerPixel, .Width=Width, .Height=Height, .List=&DrawList };
+	size_t Mark;
+
+	DrawList_Clear(&DrawList);
+
+	Mark=DrawList_GetSize(&DrawList);
+	Font_Print(&Recorder, 0, 0,
+			   "%s\n%s\nCheckbox: %s\nBargraph: %0.5f",
+			   Message1?"Button 1 clicked~!":"",
+			   Message2?"Button 2 clicked~!":"",
+			   CheckboxValue?"true":"false",
+			   BargraphValue
+	);
+	Damage_TrackRegion(&Damage, &TextRegion, &DrawList, Mark);
+
+	const uint32_t White=Draw_PackColor(Vec3b(1.0f));
+
+	Mark=DrawList_GetSize(&DrawList);
+	circle(&Recorder, (int32_t)Collider.x, (int32_t)Collider.y, (int32_t)Radius, White);
 
-	for(uint32_t i=minY;i<=maxY;i++)
-		point(ddsd, x, i, c);
+	// Draw sticks as white lines
+	for(uint32_t i=0;i<6;i++)
+	{
+		line(&Recorder,
+			 (int)Sticks[i].PointA->Position.x, (int)Sticks[i].PointA->Position.y,
+			 (int)Sticks[i].PointB->Position.x, (int)Sticks[i].PointB->Position.y,
+			 White
+		);
+	}
+	Damage_TrackRegion(&Damage, &PhysicsRegion, &DrawList, Mark);
+
+	// Everything from here on follows the cursor, LateLatch can record it again
+	LateMark=DrawList_GetSize(&DrawList);
+	RecordLateLayer(&Recorder, &Damage);
+
+	Damage_Clip(&Damage, (DrawRect_t){ 0, 0, (int32_t)Width-1, (int32_t)Height-1 });
+
+	// Nothing changed, the back buffer (and the screen) already has this frame
+	if(Damage_IsEmpty(&Damage))
+		return;
+
+	FramesRendered++;
+
+	DrawDamage(&Damage);
 }
 
-void rect(DDSURFACEDESC2 ddsd, uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2, float c[3])
+// Records the UI and the cursor marker, adding what changed to Damage
+void RecordLateLayer(RenderTarget_t *Recorder, Damage_t *Damage)
 {
-	vline(ddsd, x1, y1, y2, c);
-	vline(ddsd, x2, y1, y2, c);
-	hline(ddsd, x1, x2, y1, c);
-	hline(ddsd, x1, x2, y2, c);
+	UI_Draw(&UI, Recorder);
+
+	Damage_AddDamage(Damage, &UI.Damage);
+	Damage_Clear(&UI.Damage);
+
+	// The system cursor is hidden while dragging, this stands in for it so the latched position shows
+	size_t Mark=DrawList_GetSize(&DrawList);
+
+	if(LateLatchMode&&MouseClicked)
+		circle(Recorder, (int32_t)X, (int32_t)Y, 4, Draw_PackColor(Vec3b(1.0f)));
+
+	Damage_TrackRegion(Damage, &CursorRegion, &DrawList, Mark);
 }
 
-void fillrect(DDSURFACEDESC2 ddsd, uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2, float c[3])
+// Clears and redraws the damaged parts of Target from the frame's draw list
+void DrawDamageTo(RenderTarget_t *Target, const Damage_t *Damage)
 {
-	uint32_t minX=x1<x2?x1:x2;
-	uint32_t maxX=x1<x2?x2:x1;
-
-	for(uint32_t i=minX;i<=maxX;i++)
-		vline(ddsd, i, y1, y2, c);
+	// Clear and replay only inside each damaged rect, clipping keeps it pixel exact with a full redraw.
+	// Binned once for all the rects, each tile only does the rects that touch it.
+	Raster_FlushRects(&Raster, &DrawList, Target, Damage->Rects, Damage->NumRects);
 }
 
-void roundedrect(DDSURFACEDESC2 ddsd, uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2, uint32_t r, float c[3])
+// Same, for the back buffer (or the replay's target)
+void DrawDamage(const Damage_t *Damage)
 {
-	float f=1.0f-(float)r;
-	float ddF_x=0.0f;
-	float ddF_y=-2.0f*r;
-	uint32_t x=0, y=r;
-
-	line(ddsd, x1+r, y1, x2-r, y1, c);
-	line(ddsd, x1+r, y2, x2-r, y2, c);
-	line(ddsd, x1, y1+r, x1, y2-r, c);
-	line(ddsd, x2, y1+r, x2, y2-r, c);
-	uint32_t cx1=x1+r;
-	uint32_t cx2=x2-r;
-	uint32_t cy1=y1+r;
-	uint32_t cy2=y2-r;
-
-	while(x<y)
-	{
-		if(f>=0.0f)
-		{
-			y--;
-			ddF_y+=2.0f;
-			f+=ddF_y;
-		}
-		x++;
-		ddF_x+=2.0f;
-		f+=ddF_x+1.0f;
-
-		point(ddsd, cx2+x, cy2+y, c);
-		point(ddsd, cx1-x, cy2+y, c);
-		point(ddsd, cx2+x, cy1-y, c);
-		point(ddsd, cx1-x, cy1-y, c);
-		point(ddsd, cx2+y, cy2+x, c);
-		point(ddsd, cx1-y, cy2+x, c);
-		point(ddsd, cx2+y, cy1-x, c);
-		point(ddsd, cx1-y, cy1-x, c);
+	DDSURFACEDESC2 ddsd;
+	RenderTarget_t Target;
+	HRESULT ret=DDERR_WASSTILLDRAWING;
+
+	if(ReplayTarget!=NULL)
+	{
+		DrawDamageTo(ReplayTarget, Damage);
+		return;
 	}
+
+	memset(&ddsd, 0, sizeof(DDSURFACEDESC2));
+	ddsd.dwSize=sizeof(ddsd);
+
+	while(ret==DDERR_WASSTILLDRAWING)
+		ret=IDirectDrawSurface7_Lock(lpDDSBack, NULL, &ddsd, 0, NULL);
+
+	if(ret!=DD_OK)
+		return;
+
+	// Describe the locked surface once, everything below draws through this
+	RenderTarget_Init(&Target, ddsd.lpSurface, ddsd.lPitch, ddsd.ddpfPixelFormat.dwRGBBitCount>>3, ddsd.dwWidth, ddsd.dwHeight);
+	DrawDamageTo(&Target, Damage);
+
+	IDirectDrawSurface7_Unlock(lpDDSBack, NULL);
 }
 
-void fillroundedrect(DDSURFACEDESC2 ddsd, uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2, uint32_t r, float c[3])
+// Runs between Render and the present. Takes the newest cursor position straight from the system rather than the
+// frame's input, and redraws only what's attached to the cursor in the small area it damages. The physics (and
+// everything else) stays at the position the frame started with.
+void LateLatch(void)
 {
-	float f=1.0f-(float)r;
-	float ddF_x=0.0f;
-	float ddF_y=-2.0f*r;
-	uint32_t x=0, y=r;
+	if(!LateLatchMode||!MouseClicked)
+		return;
 
-	fillrect(ddsd, x1+r, y1, x2-r, y2, c);
+	POINT Cursor;
+	MSG Msg;
 
-	uint32_t cx1=x1+r;
-	uint32_t cx2=x2-r;
-	uint32_t cy1=y1+r;
-	uint32_t cy2=y2-r;
+	// Moves that arrived during the frame are still waiting in the message queue, queue them so they have a time.
+	// They're applied again next frame, which changes nothing since they're where the cursor already is.
+	while(PeekMessage(&Msg, hWnd, WM_MOUSEMOVE, WM_MOUSEMOVE, PM_REMOVE))
+		DispatchMessage(&Msg);
 
-	while(x<y)
-	{
-		if(f>=0.0f)
-		{
-			y--;
-			ddF_y+=2.0f;
-			f+=ddF_y;
-		}
+	if(!GetCursorPos(&Cursor)||!ScreenToClient(hWnd, &Cursor))
+		return;
 
-		x++;
-		ddF_x+=2.0f;
-		f+=ddF_x+1.0f;
+	if((float)Cursor.x==X&&(float)Cursor.y==Y)
+		return;
 
-		line(ddsd, cx1-x, cy1-y, cx1-x, cy2+y, c);
-		line(ddsd, cx1-y, cy1-x, cx1-y, cy2+x, c);
-		line(ddsd, cx2+x, cy1-y, cx2+x, cy2+y, c);
-		line(ddsd, cx2+y, cy1-x, cx2+y, cy2+x, c);
-	}
+	X=(float)Cursor.x;
+	Y=(float)Cursor.y;
+
+	// Shows input as new as the newest queued since the frame started. Without any, the cursor moved on before its
+	// message arrived and the frame's own input time stands, so the latency is never measured from the sample itself.
+	const InputEvent_t *Newest=InputQueue_PeekNewest(&InputQueue);
+
+	if(Newest!=NULL)
+		InputTime=max(InputTime, Newest->Time);
+
+	UI_ProcessCapture(&UI, Vec2(X, Y));
+
+	RenderTarget_t Recorder={ .BytesPerPixel=BytesPerPixel, .Width=Width, .Height=Height, .List=&DrawList };
+	Damage_t Late;
+
+	Damage_Clear(&Late);
+	DrawList_Truncate(&DrawList, LateMark);
+	RecordLateLayer(&Recorder, &Late);
+	Damage_Clip(&Late, (DrawRect_t){ 0, 0, (int32_t)Width-1, (int32_t)Height-1 });
+
+	if(Damage_IsEmpty(&Late))
+		return;
+
+	DrawDamage(&Late);
+
+	// Presented along with the rest of the frame
+	Damage_AddDamage(&Damage, &Late);
 }
 
-void circle(DDSURFACEDESC2 ddsd, uint32_t x, uint32_t y, uint32_t r, float c[3])
+void WriteLatency(const char *Filename)
 {
-	int32_t d;
-	uint32_t curx, cury;
+	FILE *Stream=fopen(Filename, "w");
 
-	if(!r)
+	if(Stream==NULL)
 		return;
 
-	d=3-(r<<1);
-	curx=0;
-	cury=r;
+	fprintf(Stream, "Input to present latency (late latch %s)\n", LateLatchMode?"on":"off");
+	fprintf(Stream, "  %-32s %9llu\n", "frames", (unsigned long long)LatencyFrames);
 
-	while(curx<=cury)
+	if(LatencyFrames)
 	{
-		point(ddsd, x+curx, y-cury, c);
-		point(ddsd, x-curx, y-cury, c);
-		point(ddsd, x+cury, y-curx, c);
-		point(ddsd, x-cury, y-curx, c);
-		point(ddsd, x+curx, y+cury, c);
-		point(ddsd, x-curx, y+cury, c);
-		point(ddsd, x+cury, y+curx, c);
-		point(ddsd, x-cury, y+curx, c);
-
-		if(d<0)
-			d+=(curx<<2)+6;
-		else
-		{
-			d+=((curx-cury)<<2)+10;
-			cury--;
-		}
-
-		curx++;
+		fprintf(Stream, "  %-32s %9.3f ms\n", "average", LatencySum/LatencyFrames*1000.0);
+		fprintf(Stream, "  %-32s %9.3f ms\n", "worst", LatencyMax*1000.0);
 	}
+
+	fclose(Stream);
 }
 
-void fillcircle(DDSURFACEDESC2 ddsd, uint32_t x0, uint32_t y0, uint32_t r, float c[3])
+// Copies the word after Option on the command line into Value, or Default when Option is the last thing or another
+// option follows it
+void GetOptionValue(const char *CmdLine, const char *Option, char *Value, size_t Size, const char *Default)
 {
-	int32_t x=r, y=0;
-	int32_t xChange=1-(r<<1), yChange=0;
-	int32_t radiusError=0;
+	const char *Arg=strstr(CmdLine, Option);
+	size_t Length=0;
 
-	while(x>=y)
+	if(Arg!=NULL)
 	{
-		for(uint32_t i=x0-x; i<=x0+x; i++)
-		{
-			point(ddsd, i, y0+y, c);
-			point(ddsd, i, y0-y, c);
-		}
-		for(uint32_t i=x0-y; i<=x0+y; i++)
-		{
-			point(ddsd, i, y0+x, c);
-			point(ddsd, i, y0-x, c);
-		}
+		Arg+=strlen(Option);
 
-		y++;
-		radiusError+=yChange;
-		yChange+=2;
-		if(((radiusError<<1)+xChange)>0)
+		while(*Arg==' '||*Arg=='\t')
+			Arg++;
+
+		if(*Arg!='-')
 		{
-			x--;
-			radiusError+=xChange;
-			xChange+=2;
+			while(Arg[Length]!='\0'&&Arg[Length]!=' '&&Arg[Length]!='\t')
+				Length++;
 		}
 	}
-}
 
-vec2 SpherePointCollision(vec2 Point, vec2 Collider, float Radius)
-{
-	vec2 SphereDistance=Vec2_Subv(Point, Collider);
-
-	if(Vec2_Dot(SphereDistance, SphereDistance)<Radius*Radius)
+	if(Length==0||Length>=Size)
 	{
-		Vec2_Normalize(&SphereDistance);
-
-		return Vec2(Collider.x+SphereDistance.x*Radius, Collider.y+SphereDistance.y*Radius);
+		Arg=Default;
+		Length=strlen(Default);
 	}
 
-	return Point;
+	memcpy(Value, Arg, Length);
+	Value[Length]='\0';
 }
 
-void KeepInsideView(Point_t *Point, int windowWidth, int windowHeight)
+// FNV-1a over the whole frame, equal pictures hash equal between builds and machines
+uint64_t HashFrame(const uint32_t *Buffer, size_t NumPixels)
 {
-	if(Point->Position.x>windowWidth)
-	{
-		Point->Position.x=(float)windowWidth;
-		Point->PrevPosition.x=Point->Position.x;
-	}
-	else if(Point->Position.x<0.0f)
-	{
-		Point->Position.x=0.0f;
-		Point->PrevPosition.x=Point->Position.x;
-	}
+	uint64_t Hash=14695981039346656037ull;
 
-	if(Point->Position.y>windowHeight)
+	for(size_t i=0;i<NumPixels;i++)
 	{
-		Point->Position.y=(float)windowHeight;
-		Point->PrevPosition.y=Point->Position.y;
-	}
-	else if(Point->Position.y<0.0f)
-	{
-		Point->Position.y=0.0f;
-		Point->PrevPosition.y=Point->Position.y;
+		Hash^=Buffer[i];
+		Hash*=1099511628211ull;
 	}
+
+	return Hash;
 }
 
-bool SphereSphereIntersect(vec2 PositionA, float RadiusA, vec2 PositionB, float RadiusB)
+// Runs a recording back through the same Render as the window, one frame per recorded frame, drawing into memory.
+// The time step is fixed instead of the recorded one and button callbacks all run without a time budget, so the physics
+// and the UI land in the same place however fast the build is.
+// Button messages stay up, their timers are never delivered without a message loop.
+bool Replay(const char *Filename, const char *OutputFilename)
 {
-	float RadSum=RadiusA+RadiusB;
-	return Vec2_Dot(PositionA, PositionB)<=RadSum*RadSum;
-}
+	InputRecord_t Playback;
 
-float Message1Time=0.0f;
-float Message2Time=0.0f;
-float BargraphValue=0.0f;
+	if(!InputRecord_Open(&Playback, Filename))
+		return false;
 
-uint32_t CheckboxID=UINT32_MAX;
-uint32_t BargraphID=UINT32_MAX;
-uint32_t BargraphROID=UINT32_MAX;
-uint32_t RedID=UINT32_MAX;
-uint32_t GreenID=UINT32_MAX;
-uint32_t BlueID=UINT32_MAX;
+	Width=Playback.Width;
+	Height=Playback.Height;
+	BytesPerPixel=sizeof(uint32_t);
 
-void Render(void)
-{
-	DDSURFACEDESC2 ddsd;
-	HRESULT ret=DDERR_WASSTILLDRAWING;
+	const size_t NumPixels=(size_t)Width*Height;
+	uint32_t *Buffer=(uint32_t *)calloc(NumPixels, sizeof(uint32_t));
+	FILE *Stream=fopen(OutputFilename, "w");
 
-	// Update the first point's position to the mouse movement
-	if(MouseClicked)
-		Points[1].Position=Vec2(X, Y);
+	if(Buffer==NULL||Stream==NULL||!Init())
+	{
+		free(Buffer);
 
-	VerletIntegration(4, Points, 6, Sticks, (float)fTimeStep, 10);
+		if(Stream!=NULL)
+			fclose(Stream);
 
-	vec2 Collider={ (float)Width/2, (float)Height };
-	float Radius=(float)Height/6;
+		InputRecord_Close(&Playback);
+		Destroy();
 
-	for(uint32_t i=0;i<4;i++)
-	{
-		Points[i].Position=SpherePointCollision(Points[i].Position, Collider, Radius);
-		KeepInsideView(&Points[i], Width, Height);
+		return false;
 	}
 
-	Clear(lpDDSBack);
+	RenderTarget_t Target;
 
-	memset(&ddsd, 0, sizeof(DDSURFACEDESC2));
-	ddsd.dwSize=sizeof(ddsd);
+	RenderTarget_Init(&Target, Buffer, Width*sizeof(uint32_t), sizeof(uint32_t), Width, Height);
+	ReplayTarget=&Target;
 
-	while(ret==DDERR_WASSTILLDRAWING)
-		ret=IDirectDrawSurface7_Lock(lpDDSBack, NULL, &ddsd, 0, NULL);
+	fprintf(Stream, "Replay of %s (%ux%u, %.3f ms time step, %u CPUs)\n", Filename, Width, Height, REPLAY_TIMESTEP*1000.0, Thread_GetCPUCount());
+	fprintf(Stream, "  %6s %12s %12s %16s\n", "frame", "replay", "recorded", "hash");
 
-	BargraphValue=UI_GetBarGraphValue(&UI, BargraphID);
+	double TimeStep=0.0, Total=0.0, Worst=0.0, RecordedTotal=0.0;
+	uint64_t Hash=HashFrame(Buffer, NumPixels);
+	uint32_t NumFrames=0;
 
-	Font_Print(ddsd, 0, 0,
-			   "%s\n%s\nCheckbox: %s\nBargraph: %0.5f",
-			   Message1Time>0.0f?"Button 1 clicked~!":"",
-			   Message2Time>0.0f?"Button 2 clicked~!":"",
-			   UI_GetCheckBoxValue(&UI, CheckboxID)?"true":"false",
-			   BargraphValue
-	);
+	fTimeStep=REPLAY_TIMESTEP;
 
-	if(Message1Time>0.0f)
-		Message1Time-=(float)fTimeStep;
+	while(!Done&&InputRecord_ReadFrame(&Playback, &TimeStep, &InputQueue))
+	{
+		const double Start=GetClock();
 
-	if(Message2Time>0.0f)
-		Message2Time-=(float)fTimeStep;
+		Render();
 
-	UI_UpdateBarGraphValue(&UI, BargraphROID, BargraphValue);
+		const double Time=GetClock()-Start;
 
-	vec3 Color=Vec3(
-		UI_GetBarGraphValue(&UI, RedID),
-		UI_GetBarGraphValue(&UI, GreenID),
-		UI_GetBarGraphValue(&UI, BlueID)
-	);
+		// Nothing to present, the frame is finished once it's drawn
+		InputTime=0.0;
+		Damage_Clear(&Damage);
+		fTime+=fTimeStep;
 
-	UI_UpdateBarGraphColor(&UI, BargraphID, Color);
-	UI_UpdateBarGraphColor(&UI, BargraphROID, Color);
+		Hash=HashFrame(Buffer, NumPixels);
 
-	circle(ddsd, (uint32_t)Collider.x, (uint32_t)Collider.y, (uint32_t)Radius, (float[])
-	{
-		1.0f, 1.0f, 1.0f
-	});
+		fprintf(Stream, "  %6u %9.3f ms %9.3f ms %016llx\n", NumFrames, Time*1000.0, TimeStep*1000.0, (unsigned long long)Hash);
 
-	// Draw sticks as white lines
-	for(uint32_t i=0;i<6;i++)
+		Total+=Time;
+		Worst=max(Worst, Time);
+		RecordedTotal+=TimeStep;
+		NumFrames++;
+	}
+
+	fprintf(Stream, "\n");
+	fprintf(Stream, "  %-32s %9u\n", "frames", NumFrames);
+	fprintf(Stream, "  %-32s %9llu\n", "frames drawn", (unsigned long long)FramesRendered);
+
+	if(NumFrames)
 	{
-		line(ddsd,
-			 (int)Sticks[i].PointA->Position.x, (int)Sticks[i].PointA->Position.y,
-			 (int)Sticks[i].PointB->Position.x, (int)Sticks[i].PointB->Position.y,
-			 (float[]) { 1.0f, 1.0f, 1.0f }
-		);
+		fprintf(Stream, "  %-32s %9.3f ms\n", "total", Total*1000.0);
+		fprintf(Stream, "  %-32s %9.3f ms\n", "average", Total/NumFrames*1000.0);
+		fprintf(Stream, "  %-32s %9.3f ms\n", "worst", Worst*1000.0);
+		fprintf(Stream, "  %-32s %9.3f ms\n", "recorded average", RecordedTotal/NumFrames*1000.0);
 	}
 
-	UI_Draw(&UI, ddsd);
+	fprintf(Stream, "  %-32s %016llx\n", "final hash", (unsigned long long)Hash);
 
-	IDirectDrawSurface7_Unlock(lpDDSBack, NULL);
+	ReplayTarget=NULL;
+
+	fclose(Stream);
+	free(Buffer);
+	InputRecord_Close(&Playback);
+	Destroy();
+
+	return true;
 }
 
 void SetStick(Stick_t *Stick, Point_t *PointA, Point_t *PointB)
@@ -656,13 +923,15 @@ void SetPoint(Point_t *Point, float x, float y, bool Locked)
 void Callback1(void *arg)
 {
 	UI_UpdateCheckBoxTitleText(&UI, CheckboxID, ":D");
-	Message1Time=2.0f;
+	Message1=true;
+	SetTimer(hWnd, TIMER_MESSAGE1, MESSAGE_TIMEOUT, NULL);
 }
 
 void Callback2(void *arg)
 {
 	UI_UpdateCheckBoxTitleText(&UI, CheckboxID, ":(");
-	Message2Time=2.0f;
+	Message2=true;
+	SetTimer(hWnd, TIMER_MESSAGE2, MESSAGE_TIMEOUT, NULL);
 }
 
 void CallbackExit(void *arg)
@@ -690,8 +959,20 @@ int Init(void)
 	SetStick(&Sticks[4], &Points[0], &Points[2]);
 	SetStick(&Sticks[5], &Points[1], &Points[3]);
 
+	if(!DrawList_Init(&DrawList))
+		return 0;
+
+	if(!Raster_Init(&Raster, Thread_GetCPUCount()))
+		return 0;
+
+	InputQueue_Init(&InputQueue);
+
 	UI_Init(&UI, Vec2b(0.0f), Vec2((float)Width, (float)Height));
 
+	// First frame draws everything
+	Damage_Clear(&Damage);
+	DamageAll();
+
 	UI_AddButton(&UI,
 				 Vec2((float)Width/2.0f, (float)Height/4.0f),
 				 Vec2(100.0f, 50.0f),
@@ -735,8 +1016,16 @@ int Init(void)
 								-1.0f, 1.0f, 0.0f
 	);
 
+	// The color sliders sit in a panel, positioned relative to it
+	ColorPanelID=UI_AddPanel(&UI,
+							 Vec2(5.0f, (float)Height/4.0f-20.0f),
+							 Vec2(210.0f, 100.0f),
+							 Vec3(0.1f, 0.1f, 0.1f),
+							 "Color"
+	);
+
 	RedID=UI_AddBarGraph(&UI,
-						 Vec2((float)10.0f, (float)Height/4.0f),
+						 Vec2(5.0f, 20.0f),
 						 Vec2(200.0f, 25.0f),
 						 Vec3(1.0f, 0.0f, 0.0f),
 						 "Red value",
@@ -744,7 +1033,7 @@ int Init(void)
 						 0.0f, 1.0f, 1.0f
 	);
 	GreenID=UI_AddBarGraph(&UI,
-						   Vec2((float)10.0f, (float)Height/4.0f+25.0f),
+						   Vec2(5.0f, 45.0f),
 						   Vec2(200.0f, 25.0f),
 						   Vec3(0.0f, 1.0f, 0.0f),
 						   "Green value",
@@ -752,7 +1041,7 @@ int Init(void)
 						   0.0f, 1.0f, 1.0f
 	);
 	BlueID=UI_AddBarGraph(&UI,
-						  Vec2((float)10.0f, (float)Height/4.0f+50.0f),
+						  Vec2(5.0f, 70.0f),
 						  Vec2(200.0f, 25.0f),
 						  Vec3(0.0f, 0.0f, 1.0f),
 						  "Blue value",
@@ -760,6 +1049,20 @@ int Init(void)
 						  0.0f, 1.0f, 1.0f
 	);
 
+	UI_SetControlParent(&UI, RedID, ColorPanelID);
+	UI_SetControlParent(&UI, GreenID, ColorPanelID);
+	UI_SetControlParent(&UI, BlueID, ColorPanelID);
+
+	// Both bar graphs show the same value and the color mixed by the three sliders
+	UI_BindCheckBoxValue(&UI, CheckboxID, &CheckboxValue);
+	UI_BindBarGraphValue(&UI, BargraphID, &BargraphValue);
+	UI_BindBarGraphValue(&UI, BargraphROID, &BargraphValue);
+	UI_BindBarGraphValue(&UI, RedID, &BargraphColor.x);
+	UI_BindBarGraphValue(&UI, GreenID, &BargraphColor.y);
+	UI_BindBarGraphValue(&UI, BlueID, &BargraphColor.z);
+	UI_BindControlColor(&UI, BargraphID, &BargraphColor);
+	UI_BindControlColor(&UI, BargraphROID, &BargraphColor);
+
 	return 1;
 }
 
@@ -802,6 +1105,19 @@ BOOL Create(void)
 		return FALSE;
 	}
 
+	// Colors get packed to whatever format the back buffer ended up with
+	memset(&ddsd, 0, sizeof(ddsd));
+	ddsd.dwSize=sizeof(ddsd);
+
+	if(IDirectDrawSurface7_GetSurfaceDesc(lpDDSBack, &ddsd)!=DD_OK)
+	{
+		MessageBox(hWnd, "IDirectDrawSurface7_GetSurfaceDesc failed.", "Error", MB_OK);
+		return FALSE;
+	}
+
+	Draw_SetPixelFormat(ddsd.ddpfPixelFormat.dwRBitMask, ddsd.ddpfPixelFormat.dwGBitMask, ddsd.ddpfPixelFormat.dwBBitMask);
+	BytesPerPixel=ddsd.ddpfPixelFormat.dwRGBBitCount>>3;
+
 	if(IDirectDraw7_CreateClipper(lpDD, 0, &lpClipper, NULL)!=DD_OK)
 	{
 		MessageBox(hWnd, "IDirectDraw7_CreateClipper failed.", "Error", MB_OK);
@@ -831,6 +1147,9 @@ BOOL Create(void)
 
 void Destroy(void)
 {
+	Raster_Destroy(&Raster);
+	DrawList_Destroy(&DrawList);
+
 	if(lpDDSBack!=NULL)
 	{
 		IDirectDrawSurface7_Release(lpDDSBack);
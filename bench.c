@@ -0,0 +1,1140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "math/math.h"
+#include "draw/draw.h"
+#include "draw/span.h"
+#include "draw/drawlist.h"
+#include "draw/raster.h"
+#include "draw/damage.h"
+#include "font/font.h"
+#include "ui/ui.h"
+#include "utils/clock.h"
+#include "bench.h"
+
+// 1440p, the size of our biggest dashboards
+#define BENCH_WIDTH 2560
+#define BENCH_HEIGHT 1440
+#define BENCH_ITERATIONS 200
+#define BENCH_SCALING_ITERATIONS 50
+
+typedef struct
+{
+	RenderTarget_t Target;
+	uint32_t *Buffer;
+} Bench_Surface_t;
+
+static bool Bench_CreateSurface(Bench_Surface_t *Surface, uint32_t Width, uint32_t Height)
+{
+	Surface->Buffer=(uint32_t *)calloc((size_t)Width*Height, sizeof(uint32_t));
+
+	if(Surface->Buffer==NULL)
+		return false;
+
+	RenderTarget_Init(&Surface->Target, Surface->Buffer, Width*sizeof(uint32_t), sizeof(uint32_t), Width, Height);
+
+	return true;
+}
+
+static void Bench_DestroySurface(Bench_Surface_t *Surface)
+{
+	free(Surface->Buffer);
+	Surface->Buffer=NULL;
+}
+
+static void Bench_Report(FILE *Stream, const char *Name, double Time, uint32_t Iterations, double Bytes)
+{
+	double PerIteration=Time/Iterations;
+
+	fprintf(Stream, "  %-32s %9.3f ms/iter %9.2f GB/s\n", Name, PerIteration*1000.0, Bytes/PerIteration/1e9);
+}
+
+// Times every compiled in span kernel on full surface clears, panel sized fills and translucent overlays.
+static void Bench_SpanKernels(FILE *Stream, Bench_Surface_t *Surface)
+{
+	const Span_Kernel_t *Active=Span_GetActiveKernel();
+	RenderTarget_t *Target=&Surface->Target;
+	double FrameBytes=(double)Target->Width*Target->Height*Target->BytesPerPixel;
+
+	fprintf(Stream, "Span kernels (%ux%u, %u iterations, active: %s)\n", Target->Width, Target->Height, BENCH_ITERATIONS, Active->Name);
+
+	for(uint32_t Type=0;Type<SPAN_NUM_KERNEL;Type++)
+	{
+		const Span_Kernel_t *Kernel=Span_GetKernel((Span_KernelType)Type);
+		char Name[64];
+
+		if(Kernel==NULL||!Span_SetKernel((Span_KernelType)Type))
+			continue;
+
+		double Start=GetClock();
+
+		for(uint32_t i=0;i<BENCH_ITERATIONS;i++)
+			Clear(Target);
+
+		snprintf(Name, sizeof(Name), "%s clear", Kernel->Name);
+		Bench_Report(Stream, Name, GetClock()-Start, BENCH_ITERATIONS, FrameBytes);
+
+		// Odd sized, unaligned panels to exercise the heads and tails
+		Start=GetClock();
+
+		for(uint32_t i=0;i<BENCH_ITERATIONS;i++)
+		{
+			for(uint32_t y=0;y<Target->Height;y+=61)
+			{
+				for(uint32_t x=0;x<Target->Width;x+=203)
+					Span_FillRect(Target, x+1, y+1, x+199, y+57, 0x00404040);
+			}
+		}
+
+		snprintf(Name, sizeof(Name), "%s panel fill", Kernel->Name);
+		Bench_Report(Stream, Name, GetClock()-Start, BENCH_ITERATIONS, FrameBytes*(199.0/203.0)*(57.0/61.0));
+
+		Start=GetClock();
+
+		for(uint32_t i=0;i<BENCH_ITERATIONS;i++)
+			Span_BlendRect(Target, 0, 0, Target->Width-1, Target->Height-1, 0x00FF8000, 96);
+
+		snprintf(Name, sizeof(Name), "%s blend", Kernel->Name);
+		Bench_Report(Stream, Name, GetClock()-Start, BENCH_ITERATIONS, FrameBytes*2.0);
+	}
+
+	// Put back whatever was picked by CPUID
+	Span_Init();
+
+	fprintf(Stream, "\n");
+}
+
+// Counts the pixels that ended up non-black, the shapes are drawn onto a cleared surface.
+static uint64_t Bench_CountCovered(const Bench_Surface_t *Surface)
+{
+	const RenderTarget_t *Target=&Surface->Target;
+	uint64_t Covered=0;
+
+	for(uint32_t i=0;i<Target->Width*Target->Height;i++)
+	{
+		if(Surface->Buffer[i])
+			Covered++;
+	}
+
+	return Covered;
+}
+
+// Checks a filled circle against every row of it drawn in full, what the clip rect cuts off included. Row dy spans
+// |dx|<=hw where hw is the widest with hw*hw+dy*dy<=r*r+r, the same rule fillcircle walks.
+static bool Bench_CircleExact(const Bench_Surface_t *Surface, int32_t x0, int32_t y0, int32_t r)
+{
+	const RenderTarget_t *Target=&Surface->Target;
+
+	for(int32_t y=0;y<(int32_t)Target->Height;y++)
+	{
+		for(int32_t x=0;x<(int32_t)Target->Width;x++)
+		{
+			const int32_t dx=x-x0, dy=y-y0;
+			const bool Inside=dx*dx+dy*dy<=r*r+r;
+
+			if(Inside!=(Surface->Buffer[y*Target->Width+x]!=0))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+// Pixels written vs pixels covered for the filled shapes, 1.00 means no overdraw.
+// Circles cut off by the surface edge skip the rows above (or below) it entirely, they're checked against the full scanlines.
+static void Bench_Overdraw(FILE *Stream, Bench_Surface_t *Surface)
+{
+	RenderTarget_t *Target=&Surface->Target;
+	const uint32_t Color=Draw_PackColor(Vec3b(1.0f));
+	const struct
+	{
+		const char *Name;
+		int32_t x1, y1, x2, y2, r;
+		bool Circle;
+	} Shapes[]=
+	{
+		{ "fillcircle r=5", 100, 100, 0, 0, 5, true },
+		{ "fillcircle r=300", 700, 700, 0, 0, 300, true },
+		{ "fillcircle r=300 clipped top", 700, -200, 0, 0, 300, true },
+		{ "fillcircle r=300 clipped bottom", 700, BENCH_HEIGHT+200, 0, 0, 300, true },
+		{ "fillroundedrect 100x50 r=5", 100, 100, 200, 150, 5, false },
+		{ "fillroundedrect 400x300 r=40", 100, 100, 500, 400, 40, false },
+		{ "fillroundedrect 6x6 r=5", 100, 100, 106, 106, 5, false },
+	};
+
+	fprintf(Stream, "Overdraw (pixels written / pixels covered)\n");
+
+	for(uint32_t i=0;i<sizeof(Shapes)/sizeof(Shapes[0]);i++)
+	{
+		Clear(Target);
+		Target->PixelsWritten=0;
+
+		if(Shapes[i].Circle)
+			fillcircle(Target, Shapes[i].x1, Shapes[i].y1, Shapes[i].r, Color);
+		else
+			fillroundedrect(Target, Shapes[i].x1, Shapes[i].y1, Shapes[i].x2, Shapes[i].y2, Shapes[i].r, Color);
+
+		uint64_t Covered=Bench_CountCovered(Surface);
+
+		fprintf(Stream, "  %-32s %9llu / %9llu = %.2f", Shapes[i].Name, (unsigned long long)Target->PixelsWritten, (unsigned long long)Covered, (double)Target->PixelsWritten/Covered);
+
+		if(Shapes[i].Circle)
+			fprintf(Stream, " %s", Bench_CircleExact(Surface, Shapes[i].x1, Shapes[i].y1, Shapes[i].r)?"exact":"MISMATCH");
+
+		fprintf(Stream, "\n");
+	}
+
+	fprintf(Stream, "\n");
+}
+
+// Dashboard-like frame: a grid of panels with borders, titles, bar graphs and translucent overlays, plus some lines and circles.
+static void Bench_DrawDashboard(RenderTarget_t *Target)
+{
+	const uint32_t White=Draw_PackColor(Vec3b(1.0f));
+	const uint32_t Gray=Draw_PackColor(Vec3b(0.25f));
+	const uint32_t Orange=Draw_PackColor(Vec3(1.0f, 0.5f, 0.2f));
+
+	Clear(Target);
+
+	for(int32_t y=0, i=0;y+100<=(int32_t)Target->Height;y+=110)
+	{
+		for(int32_t x=0;x+200<=(int32_t)Target->Width;x+=210, i++)
+		{
+			fillroundedrect(Target, x+5, y+5, x+200, y+100, 10, Gray);
+			roundedrect(Target, x+5, y+5, x+200, y+100, 10, White);
+			Font_Print(Target, x+15, y+12, "Panel %d\nValue: %d.%02d", i, i*7%100, i*13%100);
+			fillrect(Target, x+15, y+60, x+15+(i*37%170), y+85, Orange);
+			blendrect(Target, x+15, y+60, x+185, y+85, White, 64);
+			circle(Target, x+175, y+30, 12, White);
+		}
+	}
+
+	for(int32_t i=0;i<64;i++)
+		line(Target, 0, i*23, (int32_t)Target->Width-1, (int32_t)Target->Height-1-i*23, White);
+
+	fillcircle(Target, Target->Width/2, Target->Height/2, 300, Orange);
+	blendrect(Target, 0, 0, Target->Width-1, Target->Height-1, Gray, 32);
+}
+
+// Number of times consecutive commands change primitive type, a rough measure of how branchy replay is
+static uint32_t Bench_CountTypeSwitches(const DrawList_t *List)
+{
+	uint32_t Switches=0, Last=DRAW_NUM_CMD;
+
+	for(size_t Offset=0;Offset<DrawList_GetSize(List);)
+	{
+		const DrawCmdHeader_t *Cmd=DrawList_GetCommand(List, Offset);
+
+		if(Cmd->Type!=Last)
+			Switches++;
+
+		Last=Cmd->Type;
+		Offset+=Cmd->Size;
+	}
+
+	return Switches;
+}
+
+// Captures a dashboard frame into a command buffer, then compares drawing it directly with replaying the capture
+// as recorded and sorted by primitive type. Both replays are checked against the direct draw.
+static void Bench_DrawList(FILE *Stream, Bench_Surface_t *Surface)
+{
+	RenderTarget_t *Target=&Surface->Target;
+	size_t FrameSize=(size_t)Target->Width*Target->Height*sizeof(uint32_t);
+	uint32_t *Reference=(uint32_t *)malloc(FrameSize);
+	DrawList_t List;
+
+	if(Reference==NULL)
+		return;
+
+	if(!DrawList_Init(&List))
+	{
+		free(Reference);
+		return;
+	}
+
+	double Start=GetClock();
+
+	for(uint32_t i=0;i<BENCH_SCALING_ITERATIONS;i++)
+	{
+		DrawList_Clear(&List);
+		Target->List=&List;
+		Bench_DrawDashboard(Target);
+		Target->List=NULL;
+	}
+
+	double Record=(GetClock()-Start)/BENCH_SCALING_ITERATIONS;
+
+	fprintf(Stream, "Command buffer (%u commands, %zu bytes, %.1f bytes/command, %u iterations)\n", DrawList_GetCount(&List), DrawList_GetSize(&List), (double)DrawList_GetSize(&List)/DrawList_GetCount(&List), BENCH_SCALING_ITERATIONS);
+	fprintf(Stream, "  %-32s %9.3f ms/frame\n", "record", Record*1000.0);
+
+	Start=GetClock();
+
+	for(uint32_t i=0;i<BENCH_SCALING_ITERATIONS;i++)
+		Bench_DrawDashboard(Target);
+
+	fprintf(Stream, "  %-32s %9.3f ms/frame\n", "direct", (GetClock()-Start)/BENCH_SCALING_ITERATIONS*1000.0);
+
+	memcpy(Reference, Surface->Buffer, FrameSize);
+
+	for(uint32_t Sorted=0;Sorted<2;Sorted++)
+	{
+		char Name[64];
+
+		if(Sorted)
+		{
+			Start=GetClock();
+			DrawList_Sort(&List);
+			fprintf(Stream, "  %-32s %9.3f ms\n", "sort", (GetClock()-Start)*1000.0);
+		}
+
+		memset(Surface->Buffer, 0, FrameSize);
+
+		Start=GetClock();
+
+		for(uint32_t i=0;i<BENCH_SCALING_ITERATIONS;i++)
+			DrawList_Execute(&List, Target);
+
+		double Time=(GetClock()-Start)/BENCH_SCALING_ITERATIONS;
+
+		snprintf(Name, sizeof(Name), "replay%s (%u type switches)", Sorted?" sorted":"", Bench_CountTypeSwitches(&List));
+		fprintf(Stream, "  %-32s %9.3f ms/frame %s\n", Name, Time*1000.0, memcmp(Reference, Surface->Buffer, FrameSize)==0?"exact":"MISMATCH");
+	}
+
+	DrawList_Destroy(&List);
+	free(Reference);
+
+	fprintf(Stream, "\n");
+}
+
+// Records one dashboard frame and replays it through the tile binner with 1 to 16 threads.
+// Immediate is the plain single threaded path, every binned run is checked against it pixel for pixel.
+static void Bench_TileScaling(FILE *Stream, Bench_Surface_t *Surface)
+{
+	RenderTarget_t *Target=&Surface->Target;
+	size_t FrameSize=(size_t)Target->Width*Target->Height*sizeof(uint32_t);
+	uint32_t *Reference=(uint32_t *)malloc(FrameSize);
+	DrawList_t List;
+
+	if(Reference==NULL)
+		return;
+
+	if(!DrawList_Init(&List))
+	{
+		free(Reference);
+		return;
+	}
+
+	Target->List=&List;
+	Bench_DrawDashboard(Target);
+	Target->List=NULL;
+
+	fprintf(Stream, "Tile binned rasterizer (%ux%u, %u commands, %dx%d tiles, %u iterations, %u CPUs)\n", Target->Width, Target->Height, DrawList_GetCount(&List), RASTER_TILE_WIDTH, RASTER_TILE_HEIGHT, BENCH_SCALING_ITERATIONS, Thread_GetCPUCount());
+
+	double Start=GetClock();
+
+	for(uint32_t i=0;i<BENCH_SCALING_ITERATIONS;i++)
+		DrawList_Execute(&List, Target);
+
+	double Immediate=(GetClock()-Start)/BENCH_SCALING_ITERATIONS;
+
+	memcpy(Reference, Surface->Buffer, FrameSize);
+
+	fprintf(Stream, "  %-32s %9.3f ms/frame\n", "immediate", Immediate*1000.0);
+
+	for(uint32_t NumThreads=1;NumThreads<=16;NumThreads*=2)
+	{
+		Raster_t Raster;
+		char Name[64];
+
+		if(!Raster_Init(&Raster, NumThreads))
+			continue;
+
+		memset(Surface->Buffer, 0, FrameSize);
+
+		Start=GetClock();
+
+		for(uint32_t i=0;i<BENCH_SCALING_ITERATIONS;i++)
+			Raster_Flush(&Raster, &List, Target);
+
+		double Time=(GetClock()-Start)/BENCH_SCALING_ITERATIONS;
+		bool Exact=memcmp(Reference, Surface->Buffer, FrameSize)==0;
+
+		snprintf(Name, sizeof(Name), "binned, %u threads", Raster_GetNumThreads(&Raster));
+		fprintf(Stream, "  %-32s %9.3f ms/frame %6.2fx %s\n", Name, Time*1000.0, Immediate/Time, Exact?"exact":"MISMATCH");
+
+		Raster_Destroy(&Raster);
+	}
+
+	DrawList_Destroy(&List);
+	free(Reference);
+
+	fprintf(Stream, "\n");
+}
+
+// Redraws a scatter of small damage rects from one recorded dashboard frame. Per rect flushes the whole list through the
+// binner once for every rect (clear and flush, the way the demo used to), Raster_FlushRects bins it once for all of them.
+// Both are checked against drawing each rect directly.
+static void Bench_DamageFlush(FILE *Stream, Bench_Surface_t *Surface)
+{
+	RenderTarget_t *Target=&Surface->Target;
+	size_t FrameSize=(size_t)Target->Width*Target->Height*sizeof(uint32_t);
+	uint32_t *Reference=(uint32_t *)malloc(FrameSize);
+	DrawRect_t Rects[DAMAGE_MAX_RECTS];
+	DrawList_t List;
+	Raster_t Raster;
+
+	if(Reference==NULL)
+		return;
+
+	if(!DrawList_Init(&List))
+	{
+		free(Reference);
+		return;
+	}
+
+	if(!Raster_Init(&Raster, Thread_GetCPUCount()))
+	{
+		DrawList_Destroy(&List);
+		free(Reference);
+		return;
+	}
+
+	Target->List=&List;
+	Bench_DrawDashboard(Target);
+	Target->List=NULL;
+
+	// Spread over the screen, about what a few changed controls and a cursor leave behind
+	for(uint32_t i=0;i<DAMAGE_MAX_RECTS;i++)
+	{
+		int32_t x=(int32_t)((i*397)%(Target->Width-120)), y=(int32_t)((i*211)%(Target->Height-50));
+
+		Rects[i]=(DrawRect_t){ x, y, x+119, y+49 };
+	}
+
+	fprintf(Stream, "Damage redraw (%ux%u, %u commands, %u rects of 120x50, %u threads, %u iterations)\n", Target->Width, Target->Height, DrawList_GetCount(&List), DAMAGE_MAX_RECTS, Raster_GetNumThreads(&Raster), BENCH_SCALING_ITERATIONS);
+
+	memset(Surface->Buffer, 0x55, FrameSize);
+
+	double Start=GetClock();
+
+	for(uint32_t i=0;i<BENCH_SCALING_ITERATIONS;i++)
+	{
+		for(uint32_t j=0;j<DAMAGE_MAX_RECTS;j++)
+		{
+			RenderTarget_SetClip(Target, Rects[j].MinX, Rects[j].MinY, Rects[j].MaxX, Rects[j].MaxY);
+			Clear(Target);
+			DrawList_Execute(&List, Target);
+		}
+	}
+
+	double Immediate=(GetClock()-Start)/BENCH_SCALING_ITERATIONS;
+
+	RenderTarget_ResetClip(Target);
+	memcpy(Reference, Surface->Buffer, FrameSize);
+
+	fprintf(Stream, "  %-32s %9.3f ms/frame\n", "immediate per rect", Immediate*1000.0);
+
+	for(uint32_t Once=0;Once<2;Once++)
+	{
+		memset(Surface->Buffer, 0x55, FrameSize);
+
+		Start=GetClock();
+
+		for(uint32_t i=0;i<BENCH_SCALING_ITERATIONS;i++)
+		{
+			if(Once)
+				Raster_FlushRects(&Raster, &List, Target, Rects, DAMAGE_MAX_RECTS);
+			else
+			{
+				for(uint32_t j=0;j<DAMAGE_MAX_RECTS;j++)
+				{
+					RenderTarget_SetClip(Target, Rects[j].MinX, Rects[j].MinY, Rects[j].MaxX, Rects[j].MaxY);
+					Clear(Target);
+					Raster_Flush(&Raster, &List, Target);
+				}
+
+				RenderTarget_ResetClip(Target);
+			}
+		}
+
+		double Time=(GetClock()-Start)/BENCH_SCALING_ITERATIONS;
+
+		fprintf(Stream, "  %-32s %9.3f ms/frame %6.2fx %s\n", Once?"binned once":"binned per rect", Time*1000.0, Immediate/Time, memcmp(Reference, Surface->Buffer, FrameSize)==0?"exact":"MISMATCH");
+	}
+
+	Raster_Destroy(&Raster);
+	DrawList_Destroy(&List);
+	free(Reference);
+
+	fprintf(Stream, "\n");
+}
+
+// The dashboard frame with a row of live bar graphs over it, only one value changes per frame.
+// Full replays the whole frame every time, damaged only replays it inside what the UI reports changed.
+// Both end on the same frame, which is checked pixel for pixel.
+static void Bench_DirtyRects(FILE *Stream, Bench_Surface_t *Surface)
+{
+	RenderTarget_t *Target=&Surface->Target;
+	RenderTarget_t Recorder={ .BytesPerPixel=Target->BytesPerPixel, .Width=Target->Width, .Height=Target->Height };
+	size_t FrameSize=(size_t)Target->Width*Target->Height*sizeof(uint32_t);
+	const DrawRect_t Screen={ 0, 0, (int32_t)Target->Width-1, (int32_t)Target->Height-1 };
+	uint32_t *Reference=(uint32_t *)malloc(FrameSize);
+	uint32_t BarGraphs[8];
+	DrawList_t List;
+	UI_t UI;
+
+	if(Reference==NULL)
+		return;
+
+	if(!DrawList_Init(&List))
+	{
+		free(Reference);
+		return;
+	}
+
+	Recorder.List=&List;
+
+	UI_Init(&UI, Vec2b(0.0f), Vec2((float)Target->Width, (float)Target->Height));
+
+	for(uint32_t i=0;i<8;i++)
+		BarGraphs[i]=UI_AddBarGraph(&UI, Vec2(20.0f+i*300.0f, 20.0f), Vec2(280.0f, 25.0f), Vec3(1.0f, 0.5f, 0.2f), "Channel", true, 0.0f, 1.0f, 0.5f);
+
+	fprintf(Stream, "Dirty rects (%ux%u, dashboard with 8 bar graphs, one changing per frame, %u iterations)\n", Target->Width, Target->Height, BENCH_SCALING_ITERATIONS);
+
+	for(uint32_t Damaged=0;Damaged<2;Damaged++)
+	{
+		uint64_t Area=0;
+		Damage_t Damage;
+
+		// Same fully drawn starting frame for both
+		for(uint32_t i=0;i<8;i++)
+			UI_UpdateBarGraphValue(&UI, BarGraphs[i], 0.5f);
+
+		DrawList_Clear(&List);
+		Bench_DrawDashboard(&Recorder);
+		UI_Draw(&UI, &Recorder);
+		DrawList_Execute(&List, Target);
+		Damage_Clear(&UI.Damage);
+
+		Target->PixelsWritten=0;
+
+		double Start=GetClock();
+
+		for(uint32_t i=0;i<BENCH_SCALING_ITERATIONS;i++)
+		{
+			UI_UpdateBarGraphValue(&UI, BarGraphs[(i*3)%8], (float)(i%10)/10.0f);
+
+			DrawList_Clear(&List);
+			Bench_DrawDashboard(&Recorder);
+			UI_Draw(&UI, &Recorder);
+
+			Damage_Clear(&Damage);
+
+			if(Damaged)
+				Damage_AddDamage(&Damage, &UI.Damage);
+			else
+				Damage_Add(&Damage, Screen);
+
+			Damage_Clear(&UI.Damage);
+			Damage_Clip(&Damage, Screen);
+
+			Area+=Damage_GetArea(&Damage);
+
+			for(uint32_t j=0;j<Damage.NumRects;j++)
+			{
+				const DrawRect_t *Rect=&Damage.Rects[j];
+
+				RenderTarget_SetClip(Target, Rect->MinX, Rect->MinY, Rect->MaxX, Rect->MaxY);
+				DrawList_Execute(&List, Target);
+			}
+
+			RenderTarget_ResetClip(Target);
+		}
+
+		double Time=(GetClock()-Start)/BENCH_SCALING_ITERATIONS;
+
+		if(!Damaged)
+			memcpy(Reference, Surface->Buffer, FrameSize);
+
+		fprintf(Stream, "  %-32s %9.3f ms/frame %12llu px written/frame %8.3f%% redrawn%s\n", Damaged?"damaged":"full", Time*1000.0,
+				(unsigned long long)(Target->PixelsWritten/BENCH_SCALING_ITERATIONS), 100.0*Area/BENCH_SCALING_ITERATIONS/((double)Target->Width*Target->Height),
+				!Damaged?"":memcmp(Reference, Surface->Buffer, FrameSize)==0?" exact":" MISMATCH");
+	}
+
+	UI_Destroy(&UI);
+	DrawList_Destroy(&List);
+	free(Reference);
+
+	fprintf(Stream, "\n");
+}
+
+// A screen of buttons and bar graphs drawn straight from the UI's retained list, with and without the control cache.
+// Static replays the unchanged UI, changing updates one bar graph per frame so one control is rendered again.
+static void Bench_ControlCache(FILE *Stream, Bench_Surface_t *Surface)
+{
+	RenderTarget_t *Target=&Surface->Target;
+	size_t FrameSize=(size_t)Target->Width*Target->Height*sizeof(uint32_t);
+	uint32_t *Reference=(uint32_t *)malloc(FrameSize);
+	uint32_t BarGraphs[10];
+	UI_t UI;
+
+	if(Reference==NULL)
+		return;
+
+	UI_Init(&UI, Vec2b(0.0f), Vec2((float)Target->Width, (float)Target->Height));
+
+	for(uint32_t i=0;i<10;i++)
+	{
+		UI_AddButton(&UI, Vec2(40.0f+(i%5)*500.0f, 40.0f+(i/5)*700.0f), Vec2(200.0f, 50.0f), Vec3b(0.25f), "Cached button", NULL);
+		BarGraphs[i]=UI_AddBarGraph(&UI, Vec2(40.0f+(i%5)*500.0f, 400.0f+(i/5)*700.0f), Vec2(200.0f, 25.0f), Vec3(1.0f, 0.5f, 0.2f), "Cached bar graph", true, 0.0f, 1.0f, 0.5f);
+	}
+
+	fprintf(Stream, "Control cache (%ux%u, 20 controls, %u iterations)\n", Target->Width, Target->Height, BENCH_SCALING_ITERATIONS);
+
+	for(uint32_t Changing=0;Changing<2;Changing++)
+	{
+		char Name[64];
+
+		for(uint32_t Cached=0;Cached<2;Cached++)
+		{
+			UI_SetCacheBudget(&UI, Cached?UI_CACHE_BUDGET:0);
+
+			for(uint32_t i=0;i<10;i++)
+				UI_UpdateBarGraphValue(&UI, BarGraphs[i], 0.5f);
+
+			// Warm up, so static measures only replays
+			Clear(Target);
+			UI_Draw(&UI, Target);
+			Damage_Clear(&UI.Damage);
+
+			double Time=0.0;
+
+			// Only the UI is timed, not clearing the frame under it
+			for(uint32_t i=0;i<BENCH_SCALING_ITERATIONS;i++)
+			{
+				if(Changing)
+					UI_UpdateBarGraphValue(&UI, BarGraphs[i%10], (float)(i%9)/10.0f);
+
+				Clear(Target);
+
+				double Start=GetClock();
+
+				UI_Draw(&UI, Target);
+				Time+=GetClock()-Start;
+
+				Damage_Clear(&UI.Damage);
+			}
+
+			Time/=BENCH_SCALING_ITERATIONS;
+
+			if(!Cached)
+				memcpy(Reference, Surface->Buffer, FrameSize);
+
+			snprintf(Name, sizeof(Name), "%s, %s", Cached?"cached":"uncached", Changing?"changing":"static");
+			fprintf(Stream, "  %-32s %9.3f ms/frame%s\n", Name, Time*1000.0, !Cached?"":memcmp(Reference, Surface->Buffer, FrameSize)==0?" exact":" MISMATCH");
+		}
+	}
+
+	BitmapCache_Stats_t Stats=UI_GetCacheStats(&UI);
+
+	fprintf(Stream, "  %llu hits, %llu misses, %llu evictions, %u entries, %.1f of %.1f MB\n",
+			(unsigned long long)Stats.Hits, (unsigned long long)Stats.Misses, (unsigned long long)Stats.Evictions, Stats.NumEntries, Stats.Bytes/1048576.0, Stats.Budget/1048576.0);
+
+	UI_Destroy(&UI);
+	free(Reference);
+
+	fprintf(Stream, "\n");
+}
+
+// Adds far more controls than any one screen, the control list reallocates many times along the way.
+// Every ID is then looked up again in a scattered order and checked against the value it was created with.
+static void Bench_ControlLookup(FILE *Stream)
+{
+	const uint32_t NumControls=131072;
+	uint32_t *IDs=(uint32_t *)malloc(NumControls*sizeof(uint32_t));
+	uint32_t Found=0;
+	UI_t UI;
+
+	if(IDs==NULL)
+		return;
+
+	UI_Init(&UI, Vec2b(0.0f), Vec2((float)BENCH_WIDTH, (float)BENCH_HEIGHT));
+
+	double Start=GetClock();
+
+	for(uint32_t i=0;i<NumControls;i++)
+		IDs[i]=UI_AddBarGraph(&UI, Vec2((float)(i%2560), (float)(i/2560)), Vec2(10.0f, 10.0f), Vec3b(1.0f), "", true, 0.0f, (float)NumControls, (float)i);
+
+	double Add=(GetClock()-Start)/NumControls;
+
+	Start=GetClock();
+
+	for(uint32_t i=0;i<NumControls;i++)
+	{
+		// Odd stride, so consecutive lookups land far apart
+		uint32_t j=(i*40503u)%NumControls;
+
+		if(UI_GetBarGraphValue(&UI, IDs[j])==(float)j)
+			Found++;
+	}
+
+	double Lookup=(GetClock()-Start)/NumControls;
+	bool AllFound=Found==NumControls;
+
+	// Tear down every other control, half one at a time and half as a group, then fill the slots back up
+	uint32_t Removed=0, Stale=0;
+
+	for(uint32_t i=0;i<NumControls;i+=4)
+		UI_SetControlGroup(&UI, IDs[i], 1);
+
+	Start=GetClock();
+
+	for(uint32_t i=2;i<NumControls;i+=4)
+		Removed+=UI_RemoveControl(&UI, IDs[i]);
+
+	Removed+=UI_RemoveGroup(&UI, 1);
+
+	double Remove=(GetClock()-Start)/Removed;
+
+	for(uint32_t i=0;i<NumControls;i+=2)
+		UI_AddBarGraph(&UI, Vec2b(0.0f), Vec2(10.0f, 10.0f), Vec3b(1.0f), "", true, 0.0f, 1.0f, -1.0f);
+
+	// Removed IDs must stay dead even though their slots are back in use, the rest must still find their own control
+	Found=0;
+
+	for(uint32_t i=0;i<NumControls;i++)
+	{
+		if(i%2==0)
+			Stale+=UI_FindControlByID(&UI, IDs[i])==NULL;
+		else
+			Found+=UI_GetBarGraphValue(&UI, IDs[i])==(float)i;
+	}
+
+	fprintf(Stream, "Control lookup (%u controls)\n", NumControls);
+	fprintf(Stream, "  %-32s %9.1f ns/control\n", "add", Add*1e9);
+	fprintf(Stream, "  %-32s %9.1f ns/control %s\n", "lookup", Lookup*1e9, AllFound?"all found":"MISSING");
+	fprintf(Stream, "  %-32s %9.1f ns/control %s\n", "remove (half, slots reused)", Remove*1e9, Stale==NumControls/2&&Found==NumControls/2?"stale IDs rejected, rest found":"MISMATCH");
+
+	UI_Destroy(&UI);
+	free(IDs);
+
+	fprintf(Stream, "\n");
+}
+
+// What UI_TestHit did before the hit grid, every control in list order
+static uint32_t Bench_LinearHit(UI_t *UI, vec2 Position)
+{
+	for(uint32_t i=0;i<List_GetCount(&UI->Controls);i++)
+	{
+		UI_Control_t *Control=List_GetPointer(&UI->Controls, i);
+
+		if(Position.x>=Control->Position.x&&Position.x<=Control->Position.x+Control->Size.x&&
+		   Position.y>=Control->Position.y&&Position.y<=Control->Position.y+Control->Size.y)
+			return Control->ID;
+	}
+
+	return UINT32_MAX;
+}
+
+// Hit test cost against the number of controls, buttons scattered over the screen and clicks at random spots.
+static void Bench_HitTest(FILE *Stream)
+{
+	const uint32_t NumClicks=4096;
+	vec2 *Clicks=(vec2 *)malloc(NumClicks*sizeof(vec2));
+	uint32_t *Expected=(uint32_t *)malloc(NumClicks*sizeof(uint32_t));
+
+	if(Clicks==NULL||Expected==NULL)
+	{
+		free(Clicks);
+		free(Expected);
+		return;
+	}
+
+	// Fixed seed, every run tests the same layout
+	uint32_t Seed=1;
+
+	for(uint32_t i=0;i<NumClicks;i++)
+	{
+		Seed=Seed*1664525u+1013904223u;
+		Clicks[i].x=(float)(Seed>>16)*BENCH_WIDTH/65536.0f;
+		Seed=Seed*1664525u+1013904223u;
+		Clicks[i].y=(float)(Seed>>16)*BENCH_HEIGHT/65536.0f;
+	}
+
+	fprintf(Stream, "Hit testing (%u clicks)\n", NumClicks);
+	fprintf(Stream, "  %-32s %12s %12s\n", "controls", "linear", "grid");
+
+	for(uint32_t NumControls=10;NumControls<=100000;NumControls*=10)
+	{
+		UI_t UI;
+
+		UI_Init(&UI, Vec2b(0.0f), Vec2((float)BENCH_WIDTH, (float)BENCH_HEIGHT));
+
+		for(uint32_t i=0;i<NumControls;i++)
+		{
+			Seed=Seed*1664525u+1013904223u;
+			float x=(float)(Seed>>16)*BENCH_WIDTH/65536.0f;
+			Seed=Seed*1664525u+1013904223u;
+			float y=(float)(Seed>>16)*BENCH_HEIGHT/65536.0f;
+
+			UI_AddButton(&UI, Vec2(x, y), Vec2(40.0f, 20.0f), Vec3b(1.0f), "", NULL);
+		}
+
+		// Fewer passes as the linear scan gets slower, enough to time either way
+		const uint32_t Passes=max(1, 10000/NumControls);
+		bool Match=true;
+
+		double Start=GetClock();
+
+		for(uint32_t Pass=0;Pass<Passes;Pass++)
+		{
+			for(uint32_t i=0;i<NumClicks;i++)
+				Expected[i]=Bench_LinearHit(&UI, Clicks[i]);
+		}
+
+		double Linear=(GetClock()-Start)/((double)Passes*NumClicks);
+
+		Start=GetClock();
+
+		for(uint32_t Pass=0;Pass<Passes;Pass++)
+		{
+			for(uint32_t i=0;i<NumClicks;i++)
+				Match&=UI_TestHit(&UI, Clicks[i])==Expected[i];
+		}
+
+		double Grid=(GetClock()-Start)/((double)Passes*NumClicks);
+
+		fprintf(Stream, "  %-32u %9.1f ns %9.1f ns %s\n", NumControls, Linear*1e9, Grid*1e9, Match?"same hits":"MISMATCH");
+
+		UI_Destroy(&UI);
+	}
+
+	free(Clicks);
+	free(Expected);
+
+	fprintf(Stream, "\n");
+}
+
+// Per control cost of walking the whole control list, for hit testing (a click that misses everything) and rebuilding
+// the draw list (uncached, so every control records its primitives).
+static void Bench_ControlIteration(FILE *Stream)
+{
+	const uint32_t NumControls=100000;
+	RenderTarget_t Recorder={ .BytesPerPixel=sizeof(uint32_t), .Width=BENCH_WIDTH, .Height=BENCH_HEIGHT };
+	DrawList_t List;
+	UI_t UI;
+
+	if(!DrawList_Init(&List))
+		return;
+
+	Recorder.List=&List;
+
+	UI_Init(&UI, Vec2b(0.0f), Vec2((float)BENCH_WIDTH, (float)BENCH_HEIGHT));
+	UI_SetCacheBudget(&UI, 0);
+
+	for(uint32_t i=0;i<NumControls;i++)
+		UI_AddBarGraph(&UI, Vec2((float)(i%100)*25.0f, (float)(i/100%100)*14.0f), Vec2(20.0f, 10.0f), Vec3b(1.0f), "", false, 0.0f, 1.0f, 0.5f);
+
+	double Start=GetClock();
+	uint32_t Misses=0;
+
+	for(uint32_t i=0;i<BENCH_ITERATIONS;i++)
+		Misses+=Bench_LinearHit(&UI, Vec2b(-1.0f))==UINT32_MAX;
+
+	double Scan=(GetClock()-Start)/((double)BENCH_ITERATIONS*NumControls);
+	double Rebuild=0.0;
+
+	for(uint32_t i=0;i<BENCH_ITERATIONS/10;i++)
+	{
+		DrawList_Clear(&List);
+		UI.DrawListDirty=true;
+
+		Start=GetClock();
+		UI_Draw(&UI, &Recorder);
+		Rebuild+=GetClock()-Start;
+
+		Damage_Clear(&UI.Damage);
+	}
+
+	Rebuild/=(double)(BENCH_ITERATIONS/10)*NumControls;
+
+	fprintf(Stream, "Control iteration (%u controls, %u bytes each)\n", NumControls, (uint32_t)sizeof(UI_Control_t));
+	fprintf(Stream, "  %-32s %9.2f ns/control %s\n", "hit test scan", Scan*1e9, Misses==BENCH_ITERATIONS?"all missed":"UNEXPECTED HIT");
+	fprintf(Stream, "  %-32s %9.2f ns/control\n", "draw list rebuild", Rebuild*1e9);
+	fprintf(Stream, "\n");
+
+	UI_Destroy(&UI);
+	DrawList_Destroy(&List);
+}
+
+// Telemetry style updates, a value and a color for every bar graph each frame in no particular order, set one call
+// at a time and through a batch.
+static void Bench_BatchUpdates(FILE *Stream, uint32_t NumControls, uint32_t NumFrames)
+{
+	uint32_t *Order=(uint32_t *)malloc(NumControls*sizeof(uint32_t));
+	uint32_t *IDs[2]={ (uint32_t *)malloc(NumControls*sizeof(uint32_t)), (uint32_t *)malloc(NumControls*sizeof(uint32_t)) };
+	double Time[2]={ 0.0, 0.0 };
+	bool Match=true;
+	UI_t UI[2];
+
+	if(Order==NULL||IDs[0]==NULL||IDs[1]==NULL)
+	{
+		free(Order);
+		free(IDs[0]);
+		free(IDs[1]);
+		return;
+	}
+
+	for(uint32_t Batched=0;Batched<2;Batched++)
+	{
+		UI_Init(&UI[Batched], Vec2b(0.0f), Vec2((float)BENCH_WIDTH, (float)BENCH_HEIGHT));
+
+		for(uint32_t i=0;i<NumControls;i++)
+			IDs[Batched][i]=UI_AddBarGraph(&UI[Batched], Vec2((float)(i%40)*64.0f, (float)(i/40)*32.0f), Vec2(60.0f, 28.0f), Vec3b(1.0f), "", true, 0.0f, 1.0f, 0.0f);
+	}
+
+	// Fixed seed shuffle, both sides see the same order
+	uint32_t Seed=1;
+
+	for(uint32_t i=0;i<NumControls;i++)
+		Order[i]=i;
+
+	for(uint32_t i=NumControls-1;i>0;i--)
+	{
+		Seed=Seed*1664525u+1013904223u;
+
+		uint32_t j=(Seed>>8)%(i+1), Swap=Order[i];
+
+		Order[i]=Order[j];
+		Order[j]=Swap;
+	}
+
+	for(uint32_t Frame=0;Frame<NumFrames;Frame++)
+	{
+		for(uint32_t Batched=0;Batched<2;Batched++)
+		{
+			double Start=GetClock();
+
+			if(Batched)
+				UI_BeginBatch(&UI[Batched]);
+
+			for(uint32_t i=0;i<NumControls;i++)
+			{
+				const uint32_t ID=IDs[Batched][Order[i]];
+				const float Value=(float)((Order[i]+Frame)%100)/100.0f;
+				const vec3 Color=Vec3(Value, 1.0f-Value, 0.5f);
+
+				if(Batched)
+				{
+					UI_BatchSetFloat(&UI[Batched], ID, UI_PROPERTY_VALUE, Value);
+					UI_BatchSetVec3(&UI[Batched], ID, UI_PROPERTY_COLOR, Color);
+				}
+				else
+				{
+					UI_UpdateBarGraphValue(&UI[Batched], ID, Value);
+					UI_UpdateBarGraphColor(&UI[Batched], ID, Color);
+				}
+			}
+
+			if(Batched)
+				UI_CommitBatch(&UI[Batched]);
+
+			Time[Batched]+=GetClock()-Start;
+		}
+	}
+
+	for(uint32_t i=0;i<NumControls;i++)
+	{
+		Match&=UI_GetBarGraphValue(&UI[0], IDs[0][i])==UI_GetBarGraphValue(&UI[1], IDs[1][i]);
+		Match&=UI_FindControlByID(&UI[0], IDs[0][i])->PackedColor==UI_FindControlByID(&UI[1], IDs[1][i])->PackedColor;
+	}
+
+	Match&=Damage_GetArea(&UI[0].Damage)==Damage_GetArea(&UI[1].Damage);
+
+	const double Writes=(double)NumFrames*NumControls*2;
+
+	fprintf(Stream, "Batched updates (%u bar graphs, value and color each, %u frames)\n", NumControls, NumFrames);
+	fprintf(Stream, "  %-32s %9.1f ns/write\n", "one call per write", Time[0]/Writes*1e9);
+	fprintf(Stream, "  %-32s %9.1f ns/write %s\n", "batched", Time[1]/Writes*1e9, Match?"same result":"MISMATCH");
+	fprintf(Stream, "\n");
+
+	UI_Destroy(&UI[0]);
+	UI_Destroy(&UI[1]);
+	free(Order);
+	free(IDs[0]);
+	free(IDs[1]);
+}
+
+// Telemetry feeding every bar graph, but only a few values change each frame. Pushed with an update call per control,
+// against bound to the telemetry array and picked up by UI_SyncBindings.
+static void Bench_BoundValues(FILE *Stream)
+{
+	const uint32_t NumControls=10000, Changes=NumControls/100;
+	float *Values=(float *)malloc(NumControls*sizeof(float));
+	uint32_t *IDs[2]={ (uint32_t *)malloc(NumControls*sizeof(uint32_t)), (uint32_t *)malloc(NumControls*sizeof(uint32_t)) };
+	double Time[2]={ 0.0, 0.0 };
+	bool Match=true;
+	UI_t UI[2];
+
+	if(Values==NULL||IDs[0]==NULL||IDs[1]==NULL)
+	{
+		free(Values);
+		free(IDs[0]);
+		free(IDs[1]);
+		return;
+	}
+
+	for(uint32_t i=0;i<NumControls;i++)
+		Values[i]=0.0f;
+
+	for(uint32_t Bound=0;Bound<2;Bound++)
+	{
+		UI_Init(&UI[Bound], Vec2b(0.0f), Vec2((float)BENCH_WIDTH, (float)BENCH_HEIGHT));
+
+		for(uint32_t i=0;i<NumControls;i++)
+			IDs[Bound][i]=UI_AddBarGraph(&UI[Bound], Vec2((float)(i%40)*64.0f, (float)(i/40%40)*32.0f), Vec2(60.0f, 28.0f), Vec3b(1.0f), "", true, 0.0f, 1.0f, 0.0f);
+	}
+
+	for(uint32_t i=0;i<NumControls;i++)
+		UI_BindBarGraphValue(&UI[1], IDs[1][i], &Values[i]);
+
+	uint32_t Seed=1;
+
+	for(uint32_t Frame=0;Frame<BENCH_ITERATIONS;Frame++)
+	{
+		for(uint32_t i=0;i<Changes;i++)
+		{
+			Seed=Seed*1664525u+1013904223u;
+			Values[(Seed>>8)%NumControls]=(float)(Frame%100)/100.0f;
+		}
+
+		double Start=GetClock();
+
+		for(uint32_t i=0;i<NumControls;i++)
+			UI_UpdateBarGraphValue(&UI[0], IDs[0][i], Values[i]);
+
+		Time[0]+=GetClock()-Start;
+
+		Start=GetClock();
+		UI_SyncBindings(&UI[1]);
+		Time[1]+=GetClock()-Start;
+
+		// Each frame draws its damage and starts over, both sides have to have damaged the same
+		Match&=Damage_GetArea(&UI[0].Damage)==Damage_GetArea(&UI[1].Damage);
+
+		for(uint32_t Bound=0;Bound<2;Bound++)
+		{
+			for(uint32_t i=0;i<NumControls;i++)
+				UI_FindControlByID(&UI[Bound], IDs[Bound][i])->Flags&=~UI_CONTROL_DIRTY;
+
+			Damage_Clear(&UI[Bound].Damage);
+		}
+	}
+
+	const double Controls=(double)BENCH_ITERATIONS*NumControls;
+
+	fprintf(Stream, "Bound values (%u bar graphs, %u changed a frame, %u frames)\n", NumControls, Changes, BENCH_ITERATIONS);
+	fprintf(Stream, "  %-32s %9.2f ns/control\n", "update call per control", Time[0]/Controls*1e9);
+	fprintf(Stream, "  %-32s %9.2f ns/control %s\n", "bound, synced", Time[1]/Controls*1e9, Match?"same damage":"MISMATCH");
+	fprintf(Stream, "\n");
+
+	UI_Destroy(&UI[0]);
+	UI_Destroy(&UI[1]);
+	free(Values);
+	free(IDs[0]);
+	free(IDs[1]);
+}
+
+static void Bench_SlowCallback(void *Arg)
+{
+	const double Start=GetClock();
+
+	while(GetClock()-Start<0.001);
+
+	(*(uint32_t *)Arg)++;
+}
+
+// Clicks on a button with a 1ms callback. The clicks only queue it, dispatching once a frame keeps to the budget.
+static void Bench_DeferredCallbacks(FILE *Stream)
+{
+	const uint32_t NumClicks=100;
+	uint32_t Calls=0, Frames=0;
+	double WorstClick=0.0, WorstFrame=0.0;
+	UI_t UI;
+
+	UI_Init(&UI, Vec2b(0.0f), Vec2((float)BENCH_WIDTH, (float)BENCH_HEIGHT));
+
+	uint32_t ID=UI_AddButton(&UI, Vec2(10.0f, 10.0f), Vec2(100.0f, 50.0f), Vec3b(0.25f), "", Bench_SlowCallback);
+
+	UI_UpdateButtonCallbackData(&UI, ID, &Calls);
+
+	for(uint32_t i=0;i<NumClicks;i++)
+	{
+		const double Start=GetClock();
+
+		UI_TestHit(&UI, Vec2(20.0f, 20.0f));
+
+		const double Time=GetClock()-Start;
+
+		WorstClick=max(WorstClick, Time);
+	}
+
+	while(UI_HasPendingEvents(&UI))
+	{
+		const double Start=GetClock();
+
+		UI_DispatchEvents(&UI, UI_EVENT_BUDGET);
+
+		const double Time=GetClock()-Start;
+
+		WorstFrame=max(WorstFrame, Time);
+		Frames++;
+	}
+
+	fprintf(Stream, "Deferred callbacks (%u clicks, 1 ms callback, %.1f ms budget)\n", NumClicks, UI_EVENT_BUDGET*1000.0);
+	fprintf(Stream, "  %-32s %9.2f us\n", "worst click", WorstClick*1e6);
+	fprintf(Stream, "  %-32s %9.2f ms %s\n", "worst frame dispatching", WorstFrame*1000.0, Calls==NumClicks?"all ran":"MISSED CALLS");
+	fprintf(Stream, "  %-32s %9u\n", "frames to drain", Frames);
+	fprintf(Stream, "\n");
+
+	UI_Destroy(&UI);
+}
+
+bool Bench_Run(const char *Filename)
+{
+	Bench_Surface_t Surface;
+	FILE *Stream=fopen(Filename, "w");
+
+	if(Stream==NULL)
+		return false;
+
+	if(!Bench_CreateSurface(&Surface, BENCH_WIDTH, BENCH_HEIGHT))
+	{
+		fclose(Stream);
+		return false;
+	}
+
+	Bench_SpanKernels(Stream, &Surface);
+	Bench_Overdraw(Stream, &Surface);
+	Bench_DrawList(Stream, &Surface);
+	Bench_TileScaling(Stream, &Surface);
+	Bench_DamageFlush(Stream, &Surface);
+	Bench_DirtyRects(Stream, &Surface);
+	Bench_ControlCache(Stream, &Surface);
+	Bench_ControlLookup(Stream);
+	Bench_HitTest(Stream);
+	Bench_ControlIteration(Stream);
+	// Small enough to stay in cache, and big enough that it doesn't
+	Bench_BatchUpdates(Stream, 1000, BENCH_ITERATIONS);
+	Bench_BatchUpdates(Stream, 100000, BENCH_ITERATIONS/10);
+	Bench_BoundValues(Stream);
+	Bench_DeferredCallbacks(Stream);
+
+	Bench_DestroySurface(&Surface);
+	fclose(Stream);
+
+	return true;
+}
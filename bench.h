@@ -0,0 +1,10 @@
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <stdbool.h>
+
+// Runs the headless micro benchmarks against in-memory render targets and writes the results to Filename.
+// Returns false if the output couldn't be opened or a buffer couldn't be allocated.
+bool Bench_Run(const char *Filename);
+
+#endif
@@ -0,0 +1,321 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../math/math.h"
+#include "../utils/list.h"
+#include "draw.h"
+#include "drawlist.h"
+#include "bitmapcache.h"
+
+#define BITMAPCACHE_END UINT32_MAX
+
+bool BitmapCache_Init(BitmapCache_t *Cache, size_t Budget)
+{
+	if(Cache==NULL)
+		return false;
+
+	memset(Cache, 0, sizeof(BitmapCache_t));
+
+	Cache->Free=BITMAPCACHE_END;
+	Cache->Head=BITMAPCACHE_END;
+	Cache->Tail=BITMAPCACHE_END;
+	Cache->Stats.Budget=Budget;
+
+	return List_Init(&Cache->Entries, sizeof(BitmapCache_Entry_t), 0, NULL);
+}
+
+void BitmapCache_Destroy(BitmapCache_t *Cache)
+{
+	if(Cache==NULL)
+		return;
+
+	for(uint32_t i=0;i<List_GetCount(&Cache->Entries);i++)
+	{
+		BitmapCache_Entry_t *Entry=List_GetPointer(&Cache->Entries, i);
+
+		free(Entry->Pixels);
+		free(Entry->Mask);
+	}
+
+	List_Destroy(&Cache->Entries);
+	free(Cache->Scratch);
+
+	memset(Cache, 0, sizeof(BitmapCache_t));
+}
+
+void BitmapCache_SetBudget(BitmapCache_t *Cache, size_t Budget)
+{
+	if(Cache==NULL)
+		return;
+
+	Cache->Stats.Budget=Budget;
+}
+
+BitmapCache_Stats_t BitmapCache_GetStats(const BitmapCache_t *Cache)
+{
+	if(Cache==NULL)
+		return (BitmapCache_Stats_t) { 0 };
+
+	return Cache->Stats;
+}
+
+void BitmapCache_BeginFrame(BitmapCache_t *Cache)
+{
+	if(Cache==NULL)
+		return;
+
+	// Frame 0 is never current, so fresh entries can't look pinned after a wrap
+	if(++Cache->Frame==0)
+		Cache->Frame=1;
+}
+
+static BitmapCache_Entry_t *BitmapCache_GetEntry(BitmapCache_t *Cache, uint32_t Index)
+{
+	return (BitmapCache_Entry_t *)List_GetPointer(&Cache->Entries, Index);
+}
+
+static void BitmapCache_Unlink(BitmapCache_t *Cache, uint32_t Index)
+{
+	BitmapCache_Entry_t *Entry=BitmapCache_GetEntry(Cache, Index);
+
+	if(Entry->Prev!=BITMAPCACHE_END)
+		BitmapCache_GetEntry(Cache, Entry->Prev)->Next=Entry->Next;
+	else
+		Cache->Head=Entry->Next;
+
+	if(Entry->Next!=BITMAPCACHE_END)
+		BitmapCache_GetEntry(Cache, Entry->Next)->Prev=Entry->Prev;
+	else
+		Cache->Tail=Entry->Prev;
+}
+
+static void BitmapCache_LinkHead(BitmapCache_t *Cache, uint32_t Index)
+{
+	BitmapCache_Entry_t *Entry=BitmapCache_GetEntry(Cache, Index);
+
+	Entry->Prev=BITMAPCACHE_END;
+	Entry->Next=Cache->Head;
+
+	if(Cache->Head!=BITMAPCACHE_END)
+		BitmapCache_GetEntry(Cache, Cache->Head)->Prev=Index;
+	else
+		Cache->Tail=Index;
+
+	Cache->Head=Index;
+}
+
+// Unlinks and frees an entry's bitmap, the entry goes on the free list for reuse
+static void BitmapCache_FreeEntry(BitmapCache_t *Cache, uint32_t Index)
+{
+	BitmapCache_Entry_t *Entry=BitmapCache_GetEntry(Cache, Index);
+
+	BitmapCache_Unlink(Cache, Index);
+
+	Cache->Stats.Bytes-=Entry->Bytes;
+	Cache->Stats.NumEntries--;
+
+	free(Entry->Pixels);
+	free(Entry->Mask);
+	memset(Entry, 0, sizeof(BitmapCache_Entry_t));
+
+	Entry->Next=Cache->Free;
+	Cache->Free=Index;
+}
+
+// Evicts from the cold end until Bytes more would fit, stops at the first pinned entry since everything after it is newer
+static bool BitmapCache_MakeRoom(BitmapCache_t *Cache, size_t Bytes)
+{
+	while(Cache->Stats.Bytes+Bytes>Cache->Stats.Budget)
+	{
+		if(Cache->Tail==BITMAPCACHE_END||BitmapCache_GetEntry(Cache, Cache->Tail)->Frame==Cache->Frame)
+			return false;
+
+		BitmapCache_FreeEntry(Cache, Cache->Tail);
+		Cache->Stats.Evictions++;
+	}
+
+	return true;
+}
+
+void BitmapCache_Trim(BitmapCache_t *Cache)
+{
+	if(Cache==NULL)
+		return;
+
+	BitmapCache_MakeRoom(Cache, 0);
+}
+
+static BitmapCache_Entry_t *BitmapCache_Find(BitmapCache_t *Cache, uint32_t Handle, uint32_t Key)
+{
+	if(Handle==BITMAPCACHE_NONE||Handle>List_GetCount(&Cache->Entries))
+		return NULL;
+
+	BitmapCache_Entry_t *Entry=BitmapCache_GetEntry(Cache, Handle-1);
+
+	// Evicted, or the slot has been reused by someone else since
+	if(Entry->Pixels==NULL||Entry->Key!=Key)
+		return NULL;
+
+	return Entry;
+}
+
+const BitmapCache_Entry_t *BitmapCache_Lookup(BitmapCache_t *Cache, uint32_t Handle, uint32_t Key, uint32_t BytesPerPixel)
+{
+	if(Cache==NULL)
+		return NULL;
+
+	BitmapCache_Entry_t *Entry=BitmapCache_Find(Cache, Handle, Key);
+
+	// Not counted as a miss here, that's when it has to be stored (rendered) again
+	if(Entry==NULL||Entry->BytesPerPixel!=BytesPerPixel)
+		return NULL;
+
+	BitmapCache_Unlink(Cache, Handle-1);
+	BitmapCache_LinkHead(Cache, Handle-1);
+	Entry->Frame=Cache->Frame;
+	Cache->Stats.Hits++;
+
+	return Entry;
+}
+
+void BitmapCache_Release(BitmapCache_t *Cache, uint32_t Handle, uint32_t Key)
+{
+	if(Cache==NULL)
+		return;
+
+	if(BitmapCache_Find(Cache, Handle, Key))
+		BitmapCache_FreeEntry(Cache, Handle-1);
+}
+
+// Replays the commands into a Width by Height bitmap whose top left pixel is Bounds.Min
+static void BitmapCache_Render(const DrawList_t *List, size_t Start, size_t End, DrawRect_t Bounds, uint8_t *Pixels, int32_t Pitch, uint32_t BytesPerPixel)
+{
+	RenderTarget_t Target;
+
+	// Offset the base so the commands land in the bitmap at their screen coordinates, the clip keeps every write inside it
+	RenderTarget_Init(&Target, Pixels-(intptr_t)Bounds.MinY*Pitch-(intptr_t)Bounds.MinX*BytesPerPixel, Pitch, BytesPerPixel, Bounds.MaxX+1, Bounds.MaxY+1);
+	RenderTarget_SetClip(&Target, Bounds.MinX, Bounds.MinY, Bounds.MaxX, Bounds.MaxY);
+
+	for(size_t Offset=Start;Offset<End;)
+	{
+		const DrawCmdHeader_t *Cmd=DrawList_GetCommand(List, Offset);
+
+		DrawList_ExecuteCommand(&Target, Cmd);
+		Offset+=Cmd->Size;
+	}
+}
+
+const BitmapCache_Entry_t *BitmapCache_Store(BitmapCache_t *Cache, uint32_t *Handle, uint32_t Key, const DrawList_t *List, size_t Start, size_t End, DrawRect_t Bounds, uint32_t BytesPerPixel)
+{
+	if(Cache==NULL||Handle==NULL||List==NULL||BytesPerPixel==0)
+		return NULL;
+
+	Cache->Stats.Misses++;
+
+	// Anything left of or above the surface can never be seen
+	Bounds.MinX=max(Bounds.MinX, 0);
+	Bounds.MinY=max(Bounds.MinY, 0);
+
+	if(Bounds.MinX>Bounds.MaxX||Bounds.MinY>Bounds.MaxY)
+		return NULL;
+
+	// Blends depend on what's underneath, which the bitmap doesn't have
+	for(size_t Offset=Start;Offset<End;)
+	{
+		const DrawCmdHeader_t *Cmd=DrawList_GetCommand(List, Offset);
+
+		if(Cmd->Type==DRAW_CMD_BLENDRECT)
+		{
+			Cache->Stats.Rejects++;
+			return NULL;
+		}
+
+		Offset+=Cmd->Size;
+	}
+
+	const int32_t Width=Bounds.MaxX-Bounds.MinX+1;
+	const int32_t Height=Bounds.MaxY-Bounds.MinY+1;
+	const int32_t Pitch=Width*BytesPerPixel;
+	const size_t PixelSize=(size_t)Pitch*Height;
+	const size_t MaskSize=(size_t)Width*Height;
+	const size_t Bytes=PixelSize+MaskSize;
+
+	if(!BitmapCache_MakeRoom(Cache, Bytes))
+	{
+		Cache->Stats.Rejects++;
+		return NULL;
+	}
+
+	if(Cache->ScratchSize<PixelSize)
+	{
+		uint8_t *Scratch=(uint8_t *)realloc(Cache->Scratch, PixelSize);
+
+		if(Scratch==NULL)
+			return NULL;
+
+		Cache->Scratch=Scratch;
+		Cache->ScratchSize=PixelSize;
+	}
+
+	uint8_t *Pixels=(uint8_t *)malloc(PixelSize);
+	uint8_t *Mask=(uint8_t *)malloc(MaskSize);
+
+	if(Pixels==NULL||Mask==NULL)
+	{
+		free(Pixels);
+		free(Mask);
+		return NULL;
+	}
+
+	// Drawn over two different backgrounds, a pixel that comes out the same on both was written by the commands
+	memset(Pixels, 0x00, PixelSize);
+	memset(Cache->Scratch, 0xFF, PixelSize);
+	BitmapCache_Render(List, Start, End, Bounds, Pixels, Pitch, BytesPerPixel);
+	BitmapCache_Render(List, Start, End, Bounds, Cache->Scratch, Pitch, BytesPerPixel);
+
+	for(size_t i=0;i<MaskSize;i++)
+		Mask[i]=memcmp(Pixels+i*BytesPerPixel, Cache->Scratch+i*BytesPerPixel, BytesPerPixel)==0;
+
+	uint32_t Index=Cache->Free;
+
+	if(Index!=BITMAPCACHE_END)
+		Cache->Free=BitmapCache_GetEntry(Cache, Index)->Next;
+	else
+	{
+		BitmapCache_Entry_t Empty={ 0 };
+
+		if(!List_Add(&Cache->Entries, &Empty))
+		{
+			free(Pixels);
+			free(Mask);
+			return NULL;
+		}
+
+		Index=(uint32_t)List_GetCount(&Cache->Entries)-1;
+	}
+
+	BitmapCache_Entry_t *Entry=BitmapCache_GetEntry(Cache, Index);
+
+	Entry->Key=Key;
+	Entry->Frame=Cache->Frame;
+	Entry->Bounds=Bounds;
+	Entry->Width=Width;
+	Entry->Height=Height;
+	Entry->BytesPerPixel=BytesPerPixel;
+	Entry->Pitch=Pitch;
+	Entry->MaskPitch=Width;
+	Entry->Pixels=Pixels;
+	Entry->Mask=Mask;
+	Entry->Bytes=Bytes;
+
+	BitmapCache_LinkHead(Cache, Index);
+
+	Cache->Stats.Bytes+=Bytes;
+	Cache->Stats.NumEntries++;
+
+	*Handle=Index+1;
+
+	return Entry;
+}
@@ -0,0 +1,74 @@
+#ifndef __BITMAPCACHE_H__
+#define __BITMAPCACHE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../utils/list.h"
+#include "draw.h"
+#include "drawlist.h"
+
+// Handle value for "not cached", handles are entry index+1 so zero initialized owners start out empty
+#define BITMAPCACHE_NONE 0
+
+// A run of recorded commands rendered once into an offscreen bitmap, with a byte per pixel mask of what it covered
+typedef struct
+{
+	uint32_t Key;
+	uint32_t Frame;
+
+	DrawRect_t Bounds;
+	int32_t Width, Height;
+	uint32_t BytesPerPixel;
+	int32_t Pitch, MaskPitch;
+	uint8_t *Pixels, *Mask;
+	size_t Bytes;
+
+	// LRU order (most recent at the head), or the free list when Pixels is NULL
+	uint32_t Prev, Next;
+} BitmapCache_Entry_t;
+
+// Misses count every store, Rejects the stores that couldn't be cached
+typedef struct
+{
+	uint64_t Hits, Misses, Evictions, Rejects;
+	size_t Bytes, Budget;
+	uint32_t NumEntries;
+} BitmapCache_Stats_t;
+
+typedef struct
+{
+	List_t Entries;
+	uint32_t Free, Head, Tail;
+
+	// Entries used since the last BitmapCache_BeginFrame are pinned, something recorded may still point at them
+	uint32_t Frame;
+
+	// Second render target for working out the mask
+	uint8_t *Scratch;
+	size_t ScratchSize;
+
+	BitmapCache_Stats_t Stats;
+} BitmapCache_t;
+
+bool BitmapCache_Init(BitmapCache_t *Cache, size_t Budget);
+void BitmapCache_Destroy(BitmapCache_t *Cache);
+
+// Takes effect as entries get stored or trimmed, nothing pinned is ever evicted
+void BitmapCache_SetBudget(BitmapCache_t *Cache, size_t Budget);
+BitmapCache_Stats_t BitmapCache_GetStats(const BitmapCache_t *Cache);
+
+// Starts a new recording pass, every entry from the last one becomes evictable
+void BitmapCache_BeginFrame(BitmapCache_t *Cache);
+// Evicts least recently used entries that aren't pinned until the cache fits its budget
+void BitmapCache_Trim(BitmapCache_t *Cache);
+
+// Returns the entry Handle refers to if it still belongs to Key and matches the format, and pins it
+const BitmapCache_Entry_t *BitmapCache_Lookup(BitmapCache_t *Cache, uint32_t Handle, uint32_t Key, uint32_t BytesPerPixel);
+// Renders the commands between Start and End (clipped to Bounds) into a new pinned entry and sets Handle to it.
+// Returns NULL when it can't be cached: it blends with what's under it, it's bigger than the budget, or out of memory.
+const BitmapCache_Entry_t *BitmapCache_Store(BitmapCache_t *Cache, uint32_t *Handle, uint32_t Key, const DrawList_t *List, size_t Start, size_t End, DrawRect_t Bounds, uint32_t BytesPerPixel);
+// Frees the entry if Handle still belongs to Key, for when what it drew has changed
+void BitmapCache_Release(BitmapCache_t *Cache, uint32_t Handle, uint32_t Key);
+
+#endif
@@ -0,0 +1,186 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "../math/math.h"
+#include "draw.h"
+#include "drawlist.h"
+#include "damage.h"
+
+static inline bool Damage_RectEmpty(DrawRect_t Rect)
+{
+	return Rect.MinX>Rect.MaxX||Rect.MinY>Rect.MaxY;
+}
+
+static inline uint64_t Damage_RectArea(DrawRect_t Rect)
+{
+	if(Damage_RectEmpty(Rect))
+		return 0;
+
+	return (uint64_t)((int64_t)Rect.MaxX-Rect.MinX+1)*(uint64_t)((int64_t)Rect.MaxY-Rect.MinY+1);
+}
+
+static inline DrawRect_t Damage_RectUnion(DrawRect_t a, DrawRect_t b)
+{
+	return (DrawRect_t) { min(a.MinX, b.MinX), min(a.MinY, b.MinY), max(a.MaxX, b.MaxX), max(a.MaxY, b.MaxY) };
+}
+
+// Overlapping or touching edge to edge
+static inline bool Damage_RectTouches(DrawRect_t a, DrawRect_t b)
+{
+	return a.MinX<=b.MaxX+1&&b.MinX<=a.MaxX+1&&a.MinY<=b.MaxY+1&&b.MinY<=a.MaxY+1;
+}
+
+void Damage_Clear(Damage_t *Damage)
+{
+	if(Damage==NULL)
+		return;
+
+	Damage->NumRects=0;
+}
+
+bool Damage_IsEmpty(const Damage_t *Damage)
+{
+	return Damage==NULL||Damage->NumRects==0;
+}
+
+uint64_t Damage_GetArea(const Damage_t *Damage)
+{
+	uint64_t Area=0;
+
+	if(Damage==NULL)
+		return 0;
+
+	for(uint32_t i=0;i<Damage->NumRects;i++)
+		Area+=Damage_RectArea(Damage->Rects[i]);
+
+	return Area;
+}
+
+static void Damage_Remove(Damage_t *Damage, uint32_t Index)
+{
+	Damage->Rects[Index]=Damage->Rects[--Damage->NumRects];
+}
+
+void Damage_Add(Damage_t *Damage, DrawRect_t Rect)
+{
+	if(Damage==NULL||Damage_RectEmpty(Rect))
+		return;
+
+	// Fold in anything it touches, or that costs no extra pixels to cover together.
+	// The grown rect can reach new neighbours, so keep going until nothing merges.
+	bool Merged=true;
+
+	while(Merged)
+	{
+		Merged=false;
+
+		for(uint32_t i=0;i<Damage->NumRects;i++)
+		{
+			DrawRect_t Union=Damage_RectUnion(Rect, Damage->Rects[i]);
+
+			if(Damage_RectTouches(Rect, Damage->Rects[i])||Damage_RectArea(Union)<=Damage_RectArea(Rect)+Damage_RectArea(Damage->Rects[i]))
+			{
+				Rect=Union;
+				Damage_Remove(Damage, i);
+				Merged=true;
+				break;
+			}
+		}
+	}
+
+	// Out of slots, merge with whichever rect grows the least
+	if(Damage->NumRects==DAMAGE_MAX_RECTS)
+	{
+		uint32_t Best=0;
+		uint64_t BestGrowth=UINT64_MAX;
+
+		for(uint32_t i=0;i<Damage->NumRects;i++)
+		{
+			uint64_t Growth=Damage_RectArea(Damage_RectUnion(Rect, Damage->Rects[i]))-Damage_RectArea(Damage->Rects[i]);
+
+			if(Growth<BestGrowth)
+			{
+				BestGrowth=Growth;
+				Best=i;
+			}
+		}
+
+		Rect=Damage_RectUnion(Rect, Damage->Rects[Best]);
+		Damage_Remove(Damage, Best);
+
+		// Bigger now, may have run into others
+		Damage_Add(Damage, Rect);
+		return;
+	}
+
+	Damage->Rects[Damage->NumRects++]=Rect;
+}
+
+void Damage_AddDamage(Damage_t *Damage, const Damage_t *Other)
+{
+	if(Damage==NULL||Other==NULL)
+		return;
+
+	for(uint32_t i=0;i<Other->NumRects;i++)
+		Damage_Add(Damage, Other->Rects[i]);
+}
+
+void Damage_Clip(Damage_t *Damage, DrawRect_t Bounds)
+{
+	if(Damage==NULL)
+		return;
+
+	for(uint32_t i=0;i<Damage->NumRects;)
+	{
+		DrawRect_t *Rect=&Damage->Rects[i];
+
+		Rect->MinX=max(Rect->MinX, Bounds.MinX);
+		Rect->MinY=max(Rect->MinY, Bounds.MinY);
+		Rect->MaxX=min(Rect->MaxX, Bounds.MaxX);
+		Rect->MaxY=min(Rect->MaxY, Bounds.MaxY);
+
+		if(Damage_RectEmpty(*Rect))
+			Damage_Remove(Damage, i);
+		else
+			i++;
+	}
+}
+
+bool Damage_TrackRegion(Damage_t *Damage, Damage_Region_t *Region, const DrawList_t *List, size_t Start)
+{
+	if(Damage==NULL||Region==NULL||List==NULL)
+		return false;
+
+	DrawRect_t Bounds={ 0, 0, -1, -1 };
+	// FNV-1a over the recorded bytes, commands are zero padded so equal draws hash equal
+	uint64_t Hash=14695981039346656037ull;
+
+	for(size_t Offset=Start;Offset<DrawList_GetSize(List);)
+	{
+		const DrawCmdHeader_t *Cmd=DrawList_GetCommand(List, Offset);
+		DrawRect_t CmdBounds=DrawList_GetCommandBounds(Cmd);
+
+		if(!Damage_RectEmpty(CmdBounds))
+			Bounds=Damage_RectEmpty(Bounds)?CmdBounds:Damage_RectUnion(Bounds, CmdBounds);
+
+		for(uint32_t i=0;i<Cmd->Size;i++)
+		{
+			Hash^=((const uint8_t *)Cmd)[i];
+			Hash*=1099511628211ull;
+		}
+
+		Offset+=Cmd->Size;
+	}
+
+	if(Hash==Region->Hash&&memcmp(&Bounds, &Region->Bounds, sizeof(DrawRect_t))==0)
+		return false;
+
+	Damage_Add(Damage, Region->Bounds);
+	Damage_Add(Damage, Bounds);
+
+	Region->Bounds=Bounds;
+	Region->Hash=Hash;
+
+	return true;
+}
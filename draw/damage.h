@@ -0,0 +1,41 @@
+#ifndef __DAMAGE_H__
+#define __DAMAGE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "draw.h"
+#include "drawlist.h"
+
+// More than this and the cheapest pair gets merged, past a handful the per rect overhead outweighs the saved pixels
+#define DAMAGE_MAX_RECTS 16
+
+// Set of screen regions that need redrawing this frame
+typedef struct
+{
+	DrawRect_t Rects[DAMAGE_MAX_RECTS];
+	uint32_t NumRects;
+} Damage_t;
+
+// Tracks something drawn every frame (text, simulation) by what it recorded, so it only damages when that changes
+typedef struct
+{
+	DrawRect_t Bounds;
+	uint64_t Hash;
+} Damage_Region_t;
+
+void Damage_Clear(Damage_t *Damage);
+bool Damage_IsEmpty(const Damage_t *Damage);
+uint64_t Damage_GetArea(const Damage_t *Damage);
+
+// Adds a rect, merging it with any it overlaps or sits next to
+void Damage_Add(Damage_t *Damage, DrawRect_t Rect);
+void Damage_AddDamage(Damage_t *Damage, const Damage_t *Other);
+// Clips everything to Bounds (usually the surface), dropping what falls outside
+void Damage_Clip(Damage_t *Damage, DrawRect_t Bounds);
+
+// Compares the commands recorded since Start against what the region drew last time, damages the old and new
+// bounds if they differ. Returns true if it changed.
+bool Damage_TrackRegion(Damage_t *Damage, Damage_Region_t *Region, const DrawList_t *List, size_t Start);
+
+#endif
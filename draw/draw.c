@@ -0,0 +1,705 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../math/math.h"
+#include "span.h"
+#include "draw.h"
+#include "drawlist.h"
+
+void RenderTarget_Init(RenderTarget_t *Target, void *Base, int32_t Pitch, uint32_t BytesPerPixel, uint32_t Width, uint32_t Height)
+{
+	if(Target==NULL)
+		return;
+
+	Target->Base=(uint8_t *)Base;
+	Target->Pitch=Pitch;
+	Target->BytesPerPixel=BytesPerPixel;
+	Target->Width=Width;
+	Target->Height=Height;
+	Target->PixelsWritten=0;
+	Target->List=NULL;
+
+	RenderTarget_ResetClip(Target);
+}
+
+// Sets the clip rectangle (inclusive), the result is always kept inside the surface.
+void RenderTarget_SetClip(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+	if(Target==NULL)
+		return;
+
+	Target->ClipMinX=max(0, min(x1, x2));
+	Target->ClipMinY=max(0, min(y1, y2));
+	Target->ClipMaxX=min((int32_t)Target->Width-1, max(x1, x2));
+	Target->ClipMaxY=min((int32_t)Target->Height-1, max(y1, y2));
+}
+
+void RenderTarget_ResetClip(RenderTarget_t *Target)
+{
+	RenderTarget_SetClip(Target, 0, 0, (int32_t)Target->Width-1, (int32_t)Target->Height-1);
+}
+
+// Channel layout used by Draw_PackColor, defaults to X8R8G8B8
+static struct
+{
+	uint32_t Shift, Max;
+} PixelFormat[3]=
+{
+	{ 16, 0xFF },
+	{ 8, 0xFF },
+	{ 0, 0xFF }
+};
+
+static void Draw_SetChannel(uint32_t Channel, uint32_t Mask)
+{
+	uint32_t Shift=0;
+
+	if(!Mask)
+	{
+		PixelFormat[Channel].Shift=0;
+		PixelFormat[Channel].Max=0;
+		return;
+	}
+
+	while(!(Mask&1))
+	{
+		Mask>>=1;
+		Shift++;
+	}
+
+	PixelFormat[Channel].Shift=Shift;
+	PixelFormat[Channel].Max=Mask;
+}
+
+// Sets the channel masks colors get packed to, call with the surface's format before any colors are packed.
+void Draw_SetPixelFormat(uint32_t RMask, uint32_t GMask, uint32_t BMask)
+{
+	Draw_SetChannel(0, RMask);
+	Draw_SetChannel(1, GMask);
+	Draw_SetChannel(2, BMask);
+}
+
+// Converts a 0.0 to 1.0 RGB color into a packed pixel in the current pixel format.
+// This is the only float to int conversion in the pipeline, do it once per primitive (or once when a color is set).
+uint32_t Draw_PackColor(vec3 Color)
+{
+	const float c[3]={ Color.x, Color.y, Color.z };
+	uint32_t Packed=0;
+
+	for(uint32_t i=0;i<3;i++)
+	{
+		float v=c[i]<0.0f?0.0f:c[i]>1.0f?1.0f:c[i];
+
+		Packed|=((uint32_t)(v*PixelFormat[i].Max)&PixelFormat[i].Max)<<PixelFormat[i].Shift;
+	}
+
+	return Packed;
+}
+
+void Clear(RenderTarget_t *Target)
+{
+	fillrect(Target, 0, 0, (int32_t)Target->Width-1, (int32_t)Target->Height-1, 0x00000000);
+}
+
+// Writes one pixel with no clipping, callers must have already clipped
+static inline void Draw_PutPixel(uint8_t *Pixel, uint32_t BytesPerPixel, uint32_t Color)
+{
+	switch(BytesPerPixel)
+	{
+		case 4:
+			*(uint32_t *)Pixel=Color;
+			break;
+
+		case 3:
+			Pixel[0]=(uint8_t)(Color);
+			Pixel[1]=(uint8_t)(Color>>8);
+			Pixel[2]=(uint8_t)(Color>>16);
+			break;
+
+		case 2:
+			*(uint16_t *)Pixel=(uint16_t)Color;
+			break;
+
+		case 1:
+			*Pixel=(uint8_t)Color;
+			break;
+	}
+}
+
+static inline uint8_t *Draw_PixelAddress(const RenderTarget_t *Target, int32_t x, int32_t y)
+{
+	return Target->Base+(intptr_t)y*Target->Pitch+(intptr_t)x*Target->BytesPerPixel;
+}
+
+// Returns true if the inclusive box touches the clip rect at all
+static inline bool Draw_BoxVisible(const RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+	return x2>=Target->ClipMinX&&x1<=Target->ClipMaxX&&y2>=Target->ClipMinY&&y1<=Target->ClipMaxY;
+}
+
+// Returns true if the inclusive box is entirely inside the clip rect
+static inline bool Draw_BoxInside(const RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+	return x1>=Target->ClipMinX&&x2<=Target->ClipMaxX&&y1>=Target->ClipMinY&&y2<=Target->ClipMaxY;
+}
+
+void point(RenderTarget_t *Target, int32_t x, int32_t y, uint32_t Color)
+{
+	if(Target->List)
+	{
+		DrawList_AddPoint(Target->List, x, y, Color);
+		return;
+	}
+
+	if(x<Target->ClipMinX||x>Target->ClipMaxX)
+		return;
+	if(y<Target->ClipMinY||y>Target->ClipMaxY)
+		return;
+
+	Draw_PutPixel(Draw_PixelAddress(Target, x, y), Target->BytesPerPixel, Color);
+	Target->PixelsWritten++;
+}
+
+// Integer ceil(n/d) for d>0
+static inline int64_t Draw_CeilDiv(int64_t n, int64_t d)
+{
+	return n>=0?(n+d-1)/d:-((-n)/d);
+}
+
+// Bresenham line, clipped up front.
+// Along the major axis the pixel at step k is exactly minor0+floor((2*k*dmin+dmaj)/(2*dmaj)), so the visible range
+// of k can be solved for directly (Liang-Barsky style, in integers) and the error term started from the first visible
+// pixel. A clipped line touches exactly the same pixels the unclipped one would have inside the clip rect, and costs
+// nothing outside it. Coordinates are expected to stay within +/-2^29.
+void line(RenderTarget_t *Target, int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t Color)
+{
+	if(Target->List)
+	{
+		DrawList_AddRect(Target->List, DRAW_CMD_LINE, x0, y0, x1, y1, Color, 0);
+		return;
+	}
+
+	// Trivial reject, both ends on the same outside side of the clip rect
+	if(!Draw_BoxVisible(Target, min(x0, x1), min(y0, y1), max(x0, x1), max(y0, y1)))
+		return;
+
+	int64_t dx=(int64_t)x1-x0, dy=(int64_t)y1-y0;
+	int32_t sx=dx<0?-1:1, sy=dy<0?-1:1;
+
+	dx=dx<0?-dx:dx;
+	dy=dy<0?-dy:dy;
+
+	// Map onto major (u) and minor (v) axes
+	bool xMajor=dx>=dy;
+	int64_t dMaj=xMajor?dx:dy, dMin=xMajor?dy:dx;
+	int64_t u0=xMajor?x0:y0, v0=xMajor?y0:x0;
+	int32_t su=xMajor?sx:sy, sv=xMajor?sy:sx;
+	int64_t uMin=xMajor?Target->ClipMinX:Target->ClipMinY, uMax=xMajor?Target->ClipMaxX:Target->ClipMaxY;
+	int64_t vMin=xMajor?Target->ClipMinY:Target->ClipMinX, vMax=xMajor?Target->ClipMaxY:Target->ClipMaxX;
+
+	// Visible k along the major axis
+	int64_t kStart=0, kEnd=dMaj;
+
+	if(su>0)
+	{
+		kStart=max(kStart, uMin-u0);
+		kEnd=min(kEnd, uMax-u0);
+	}
+	else
+	{
+		kStart=max(kStart, u0-uMax);
+		kEnd=min(kEnd, u0-uMin);
+	}
+
+	// Allowed minor offsets m, where v=v0+sv*m
+	int64_t mLo=sv>0?vMin-v0:v0-vMax;
+	int64_t mHi=sv>0?vMax-v0:v0-vMin;
+
+	if(mHi<0)
+		return;
+
+	if(dMin==0)
+	{
+		// Minor offset is always 0
+		if(mLo>0)
+			return;
+	}
+	else
+	{
+		if(mLo>0)
+			kStart=max(kStart, Draw_CeilDiv((2*mLo-1)*dMaj, 2*dMin));
+
+		kEnd=min(kEnd, Draw_CeilDiv((2*mHi+1)*dMaj, 2*dMin)-1);
+	}
+
+	if(kStart>kEnd)
+		return;
+
+	// Start the error term at the first visible pixel
+	int64_t TwoMaj=2*dMaj, TwoMin=2*dMin;
+	int64_t Num=2*kStart*dMin+dMaj;
+	int64_t Rem=dMaj?Num%TwoMaj:0;
+	int64_t m=dMaj?Num/TwoMaj:0;
+
+	int32_t x=(int32_t)(xMajor?u0+su*kStart:v0+sv*m);
+	int32_t y=(int32_t)(xMajor?v0+sv*m:u0+su*kStart);
+
+	// Step the pixel pointer directly, everything from here on is inside the clip rect
+	uint32_t BytesPerPixel=Target->BytesPerPixel;
+	uint8_t *Pixel=Draw_PixelAddress(Target, x, y);
+	intptr_t StepX=sx*(intptr_t)BytesPerPixel, StepY=sy*(intptr_t)Target->Pitch;
+	intptr_t StepU=xMajor?StepX:StepY, StepV=xMajor?StepY:StepX;
+
+	Target->PixelsWritten+=(uint64_t)(kEnd-kStart+1);
+
+	for(int64_t k=kStart;k<=kEnd;k++)
+	{
+		Draw_PutPixel(Pixel, BytesPerPixel, Color);
+
+		Pixel+=StepU;
+		Rem+=TwoMin;
+
+		if(Rem>=TwoMaj)
+		{
+			Rem-=TwoMaj;
+			Pixel+=StepV;
+		}
+	}
+}
+
+void hline(RenderTarget_t *Target, int32_t x0, int32_t x1, int32_t y, uint32_t Color)
+{
+	fillrect(Target, x0, y, x1, y, Color);
+}
+
+void vline(RenderTarget_t *Target, int32_t x, int32_t y0, int32_t y1, uint32_t Color)
+{
+	fillrect(Target, x, y0, x, y1, Color);
+}
+
+void rect(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t Color)
+{
+	vline(Target, x1, y1, y2, Color);
+	vline(Target, x2, y1, y2, Color);
+	hline(Target, x1, x2, y1, Color);
+	hline(Target, x1, x2, y2, Color);
+}
+
+void fillrect(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t Color)
+{
+	if(Target->List)
+	{
+		DrawList_AddRect(Target->List, DRAW_CMD_FILLRECT, x1, y1, x2, y2, Color, 0);
+		return;
+	}
+
+	Span_FillRect(Target, x1, y1, x2, y2, Color);
+}
+
+// Translucent fill, Alpha is opacity from 0 to 255
+void blendrect(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t Color, uint32_t Alpha)
+{
+	if(Target->List)
+	{
+		DrawList_AddRect(Target->List, DRAW_CMD_BLENDRECT, x1, y1, x2, y2, Color, Alpha);
+		return;
+	}
+
+	Span_BlendRect(Target, x1, y1, x2, y2, Color, Alpha);
+}
+
+// Plots the 8 symmetric points of a circle octant step.
+// Corners (cx1, cy1)-(cx2, cy2) let the same code draw circles (all equal) and rounded rect corners.
+static inline void Draw_Plot8(RenderTarget_t *Target, bool Inside, int32_t cx1, int32_t cy1, int32_t cx2, int32_t cy2, int32_t x, int32_t y, uint32_t Color)
+{
+	const int32_t px[8]={ cx2+x, cx1-x, cx2+x, cx1-x, cx2+y, cx1-y, cx2+y, cx1-y };
+	const int32_t py[8]={ cy2+y, cy2+y, cy1-y, cy1-y, cy2+x, cy2+x, cy1-x, cy1-x };
+
+	if(Inside)
+	{
+		for(uint32_t i=0;i<8;i++)
+			Draw_PutPixel(Draw_PixelAddress(Target, px[i], py[i]), Target->BytesPerPixel, Color);
+
+		Target->PixelsWritten+=8;
+	}
+	else
+	{
+		for(uint32_t i=0;i<8;i++)
+			point(Target, px[i], py[i], Color);
+	}
+}
+
+void roundedrect(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t r, uint32_t Color)
+{
+	if(Target->List)
+	{
+		DrawList_AddRoundedRect(Target->List, DRAW_CMD_ROUNDEDRECT, x1, y1, x2, y2, r, Color);
+		return;
+	}
+
+	// Arc centers sit r in from each edge, so with flipped corners or an oversized r the arcs land outside the box
+	int32_t minX=min(min(x1, x2), min(x1+r, x2-r)), maxX=max(max(x1, x2), max(x1+r, x2-r));
+	int32_t minY=min(min(y1, y2), min(y1+r, y2-r)), maxY=max(max(y1, y2), max(y1+r, y2-r));
+
+	// Whole shape off the clip rect, nothing to do
+	if(!Draw_BoxVisible(Target, minX, minY, maxX, maxY))
+		return;
+
+	// Entirely inside, the arcs can skip per pixel clipping
+	bool Inside=Draw_BoxInside(Target, minX, minY, maxX, maxY);
+
+	float f=1.0f-(float)r;
+	float ddF_x=0.0f;
+	float ddF_y=-2.0f*r;
+	int32_t x=0, y=r;
+
+	line(Target, x1+r, y1, x2-r, y1, Color);
+	line(Target, x1+r, y2, x2-r, y2, Color);
+	line(Target, x1, y1+r, x1, y2-r, Color);
+	line(Target, x2, y1+r, x2, y2-r, Color);
+	int32_t cx1=x1+r;
+	int32_t cx2=x2-r;
+	int32_t cy1=y1+r;
+	int32_t cy2=y2-r;
+
+	while(x<y)
+	{
+		if(f>=0.0f)
+		{
+			y--;
+			ddF_y+=2.0f;
+			f+=ddF_y;
+		}
+		x++;
+		ddF_x+=2.0f;
+		f+=ddF_x+1.0f;
+
+		Draw_Plot8(Target, Inside, cx1, cy1, cx2, cy2, x, y, Color);
+	}
+}
+
+// Shared by fillcircle and fillroundedrect so both agree on the shape of a corner.
+// Pixel centers with x*x+y*y<=r*r+r are inside, which is a circle of radius r+0.5 (less the 0.25).
+static inline int32_t Draw_HalfWidth(int32_t r, int32_t dy, int32_t x)
+{
+	while(x>0&&x*x+dy*dy>r*r+r)
+		x--;
+
+	return x;
+}
+
+// Scanline filled rounded rect, one span per row so every covered pixel is written exactly once.
+void fillroundedrect(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t r, uint32_t Color)
+{
+	if(Target->List)
+	{
+		DrawList_AddRoundedRect(Target->List, DRAW_CMD_FILLROUNDEDRECT, x1, y1, x2, y2, r, Color);
+		return;
+	}
+
+	int32_t minX=min(x1, x2), maxX=max(x1, x2);
+	int32_t minY=min(y1, y2), maxY=max(y1, y2);
+
+	if(!Draw_BoxVisible(Target, minX, minY, maxX, maxY))
+		return;
+
+	// Corners can't be bigger than half the shortest side
+	r=min(r, min((maxX-minX)/2, (maxY-minY)/2));
+
+	if(r<0)
+		r=0;
+
+	int32_t cx1=minX+r, cx2=maxX-r;
+	int32_t cy1=minY+r, cy2=maxY-r;
+
+	// Straight middle section
+	Span_FillRect(Target, minX, cy1, maxX, cy2, Color);
+
+	// Corner rows, top and bottom at the same distance from the middle share a half width
+	int32_t hw=r;
+
+	for(int32_t dy=1;dy<=r;dy++)
+	{
+		hw=Draw_HalfWidth(r, dy, hw);
+
+		Span_FillRect(Target, cx1-hw, cy1-dy, cx2+hw, cy1-dy, Color);
+		Span_FillRect(Target, cx1-hw, cy2+dy, cx2+hw, cy2+dy, Color);
+	}
+}
+
+void circle(RenderTarget_t *Target, int32_t x, int32_t y, int32_t r, uint32_t Color)
+{
+	int32_t d;
+	int32_t curx, cury;
+
+	if(Target->List)
+	{
+		DrawList_AddCircle(Target->List, DRAW_CMD_CIRCLE, x, y, r, Color);
+		return;
+	}
+
+	if(r<=0)
+		return;
+
+	if(!Draw_BoxVisible(Target, x-r, y-r, x+r, y+r))
+		return;
+
+	bool Inside=Draw_BoxInside(Target, x-r, y-r, x+r, y+r);
+
+	d=3-(r<<1);
+	curx=0;
+	cury=r;
+
+	while(curx<=cury)
+	{
+		Draw_Plot8(Target, Inside, x, y, x, y, curx, cury, Color);
+
+		if(d<0)
+			d+=(curx<<2)+6;
+		else
+		{
+			d+=(curx-cury)*4+10;
+			cury--;
+		}
+
+		curx++;
+	}
+}
+
+// Scanline filled circle, one span per row so every covered pixel is written exactly once.
+void fillcircle(RenderTarget_t *Target, int32_t x0, int32_t y0, int32_t r, uint32_t Color)
+{
+	if(Target->List)
+	{
+		DrawList_AddCircle(Target->List, DRAW_CMD_FILLCIRCLE, x0, y0, r, Color);
+		return;
+	}
+
+	if(r<0)
+		return;
+
+	if(!Draw_BoxVisible(Target, x0-r, y0-r, x0+r, y0+r))
+		return;
+
+	// Only walk the rows that can be visible, closer to the center than dyMin both y0-dy and y0+dy are outside the clip rect
+	int32_t ClipAbove=Target->ClipMinY-y0, ClipBelow=y0-Target->ClipMaxY;
+	int32_t dyMin=max(0, max(ClipAbove, ClipBelow));
+
+	// Width is monotonic in dy, so walking down from r lands on the same width the skipped rows would have
+	int32_t hw=Draw_HalfWidth(r, dyMin, r);
+
+	for(int32_t dy=dyMin;dy<=r;dy++)
+	{
+		hw=Draw_HalfWidth(r, dy, hw);
+
+		Span_FillRect(Target, x0-hw, y0-dy, x0+hw, y0-dy, Color);
+
+		if(dy)
+			Span_FillRect(Target, x0-hw, y0+dy, x0+hw, y0+dy, Color);
+	}
+}
+
+void glyphrun(RenderTarget_t *Target, int32_t x, int32_t y, const uint8_t *Font, int32_t Width, int32_t Height, const char *Text, uint32_t Count, uint32_t Color)
+{
+	if(Target->List)
+	{
+		DrawList_AddGlyphRun(Target->List, x, y, Font, Width, Height, Text, Count, Color);
+		return;
+	}
+
+	if(Font==NULL||Text==NULL||Width<=0||Height<=0||!Count)
+		return;
+
+	// Only walk the glyphs that can land in the clip rect
+	if(!Draw_BoxVisible(Target, x, y, x+(int32_t)Count*Width-1, y+Height-1))
+		return;
+
+	int32_t First=max(0, (Target->ClipMinX-x)/Width);
+	int32_t Last=min((int32_t)Count-1, (Target->ClipMaxX-x)/Width);
+
+	for(int32_t g=First;g<=Last;g++)
+	{
+		const uint8_t *Bitmap=&Font[(uint8_t)Text[g]*Height];
+		int32_t gx=x+g*Width;
+
+		if(Draw_BoxInside(Target, gx, y, gx+Width-1, y+Height-1))
+		{
+			uint8_t *Row=Draw_PixelAddress(Target, gx, y);
+
+			for(int32_t j=0;j<Height;j++, Row+=Target->Pitch)
+			{
+				for(int32_t i=0;i<Width;i++)
+				{
+					if(Bitmap[j]&(0x80>>i))
+					{
+						Draw_PutPixel(Row+i*Target->BytesPerPixel, Target->BytesPerPixel, Color);
+						Target->PixelsWritten++;
+					}
+				}
+			}
+		}
+		else
+		{
+			for(int32_t j=0;j<Height;j++)
+			{
+				for(int32_t i=0;i<Width;i++)
+				{
+					if(Bitmap[j]&(0x80>>i))
+						point(Target, gx+i, y+j, Color);
+				}
+			}
+		}
+	}
+}
+
+void blit(RenderTarget_t *Target, int32_t x, int32_t y, const void *Source, int32_t SourcePitch, int32_t Width, int32_t Height)
+{
+	if(Target->List)
+	{
+		DrawList_AddBlit(Target->List, x, y, Source, SourcePitch, Width, Height);
+		return;
+	}
+
+	if(Source==NULL||Width<=0||Height<=0)
+		return;
+
+	int32_t x1=max(x, Target->ClipMinX), x2=min(x+Width-1, Target->ClipMaxX);
+	int32_t y1=max(y, Target->ClipMinY), y2=min(y+Height-1, Target->ClipMaxY);
+
+	if(x1>x2||y1>y2)
+		return;
+
+	const uint8_t *Src=(const uint8_t *)Source+(intptr_t)(y1-y)*SourcePitch+(intptr_t)(x1-x)*Target->BytesPerPixel;
+	uint8_t *Dst=Draw_PixelAddress(Target, x1, y1);
+	size_t RowSize=(size_t)(x2-x1+1)*Target->BytesPerPixel;
+
+	for(int32_t j=y1;j<=y2;j++, Src+=SourcePitch, Dst+=Target->Pitch)
+		memcpy(Dst, Src, RowSize);
+
+	Target->PixelsWritten+=(uint64_t)(x2-x1+1)*(y2-y1+1);
+}
+
+static inline uint64_t Draw_Load64(const uint8_t *p)
+{
+	uint64_t Value;
+
+	memcpy(&Value, p, sizeof(Value));
+
+	return Value;
+}
+
+static inline bool Draw_HasZeroByte(uint64_t Value)
+{
+	return ((Value-0x0101010101010101ull)&~Value&0x8080808080808080ull)!=0;
+}
+
+void maskblit(RenderTarget_t *Target, int32_t x, int32_t y, const void *Source, int32_t SourcePitch, const uint8_t *Mask, int32_t MaskPitch, int32_t Width, int32_t Height)
+{
+	if(Target->List)
+	{
+		DrawList_AddMaskBlit(Target->List, x, y, Source, SourcePitch, Mask, MaskPitch, Width, Height);
+		return;
+	}
+
+	if(Source==NULL||Mask==NULL||Width<=0||Height<=0)
+		return;
+
+	int32_t x1=max(x, Target->ClipMinX), x2=min(x+Width-1, Target->ClipMaxX);
+	int32_t y1=max(y, Target->ClipMinY), y2=min(y+Height-1, Target->ClipMaxY);
+
+	if(x1>x2||y1>y2)
+		return;
+
+	const uint32_t BytesPerPixel=Target->BytesPerPixel;
+	const uint8_t *Src=(const uint8_t *)Source+(intptr_t)(y1-y)*SourcePitch+(intptr_t)(x1-x)*BytesPerPixel;
+	const uint8_t *Covered=Mask+(intptr_t)(y1-y)*MaskPitch+(x1-x);
+	uint8_t *Dst=Draw_PixelAddress(Target, x1, y1);
+	const int32_t Count=x2-x1+1;
+
+	for(int32_t j=y1;j<=y2;j++, Src+=SourcePitch, Covered+=MaskPitch, Dst+=Target->Pitch)
+	{
+		for(int32_t i=0;i<Count;)
+		{
+			// Eight mask bytes at a time through the long uncovered and covered stretches
+			while(i+8<=Count&&Draw_Load64(Covered+i)==0)
+				i+=8;
+
+			while(i<Count&&!Covered[i])
+				i++;
+
+			int32_t Run=i;
+
+			while(i+8<=Count&&!Draw_HasZeroByte(Draw_Load64(Covered+i)))
+				i+=8;
+
+			while(i<Count&&Covered[i])
+				i++;
+
+			if(i>Run)
+			{
+				memcpy(Dst+(size_t)Run*BytesPerPixel, Src+(size_t)Run*BytesPerPixel, (size_t)(i-Run)*BytesPerPixel);
+				Target->PixelsWritten+=i-Run;
+			}
+		}
+	}
+}
+
+// Float color wrappers, these pack the color once and forward to the packed primitives.
+void pointf(RenderTarget_t *Target, int32_t x, int32_t y, float c[3])
+{
+	point(Target, x, y, Draw_PackColor(Vec3(c[0], c[1], c[2])));
+}
+
+void linef(RenderTarget_t *Target, int32_t x0, int32_t y0, int32_t x1, int32_t y1, float c[3])
+{
+	line(Target, x0, y0, x1, y1, Draw_PackColor(Vec3(c[0], c[1], c[2])));
+}
+
+void hlinef(RenderTarget_t *Target, int32_t x0, int32_t x1, int32_t y, float c[3])
+{
+	hline(Target, x0, x1, y, Draw_PackColor(Vec3(c[0], c[1], c[2])));
+}
+
+void vlinef(RenderTarget_t *Target, int32_t x, int32_t y0, int32_t y1, float c[3])
+{
+	vline(Target, x, y0, y1, Draw_PackColor(Vec3(c[0], c[1], c[2])));
+}
+
+void rectf(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2, float c[3])
+{
+	rect(Target, x1, y1, x2, y2, Draw_PackColor(Vec3(c[0], c[1], c[2])));
+}
+
+void fillrectf(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2, float c[3])
+{
+	fillrect(Target, x1, y1, x2, y2, Draw_PackColor(Vec3(c[0], c[1], c[2])));
+}
+
+void blendrectf(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2, float c[3], float a)
+{
+	if(a<=0.0f)
+		return;
+
+	blendrect(Target, x1, y1, x2, y2, Draw_PackColor(Vec3(c[0], c[1], c[2])), a>=1.0f?255:(uint32_t)(a*255.0f+0.5f));
+}
+
+void roundedrectf(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t r, float c[3])
+{
+	roundedrect(Target, x1, y1, x2, y2, r, Draw_PackColor(Vec3(c[0], c[1], c[2])));
+}
+
+void fillroundedrectf(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t r, float c[3])
+{
+	fillroundedrect(Target, x1, y1, x2, y2, r, Draw_PackColor(Vec3(c[0], c[1], c[2])));
+}
+
+void circlef(RenderTarget_t *Target, int32_t x, int32_t y, int32_t r, float c[3])
+{
+	circle(Target, x, y, r, Draw_PackColor(Vec3(c[0], c[1], c[2])));
+}
+
+void fillcirclef(RenderTarget_t *Target, int32_t x, int32_t y, int32_t r, float c[3])
+{
+	fillcircle(Target, x, y, r, Draw_PackColor(Vec3(c[0], c[1], c[2])));
+}
@@ -0,0 +1,75 @@
+#ifndef __DRAW_H__
+#define __DRAW_H__
+
+#include <stdint.h>
+#include "../math/math.h"
+
+struct DrawList_s;
+
+// Inclusive integer rectangle, empty when Min>Max
+typedef struct
+{
+	int32_t MinX, MinY, MaxX, MaxY;
+} DrawRect_t;
+
+// Lightweight description of a locked surface (or any plain memory buffer) to draw into.
+// Filled once per frame and passed by pointer through the whole draw stack.
+typedef struct
+{
+	uint8_t *Base;
+	int32_t Pitch;
+	uint32_t BytesPerPixel;
+	uint32_t Width, Height;
+
+	// Clip rectangle, inclusive, always inside the surface
+	int32_t ClipMinX, ClipMinY;
+	int32_t ClipMaxX, ClipMaxY;
+
+	// Overdraw counter, every pixel write (or blend) adds one
+	uint64_t PixelsWritten;
+
+	// When set, primitives record into this list instead of touching pixels (see drawlist.h)
+	struct DrawList_s *List;
+} RenderTarget_t;
+
+void RenderTarget_Init(RenderTarget_t *Target, void *Base, int32_t Pitch, uint32_t BytesPerPixel, uint32_t Width, uint32_t Height);
+void RenderTarget_SetClip(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+void RenderTarget_ResetClip(RenderTarget_t *Target);
+
+void Draw_SetPixelFormat(uint32_t RMask, uint32_t GMask, uint32_t BMask);
+uint32_t Draw_PackColor(vec3 Color);
+
+// Primitives take colors already packed by Draw_PackColor
+void Clear(RenderTarget_t *Target);
+void point(RenderTarget_t *Target, int32_t x, int32_t y, uint32_t Color);
+void line(RenderTarget_t *Target, int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t Color);
+void hline(RenderTarget_t *Target, int32_t x0, int32_t x1, int32_t y, uint32_t Color);
+void vline(RenderTarget_t *Target, int32_t x, int32_t y0, int32_t y1, uint32_t Color);
+void rect(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t Color);
+void fillrect(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t Color);
+void blendrect(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t Color, uint32_t Alpha);
+void roundedrect(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t r, uint32_t Color);
+void fillroundedrect(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t r, uint32_t Color);
+void circle(RenderTarget_t *Target, int32_t x, int32_t y, int32_t r, uint32_t Color);
+void fillcircle(RenderTarget_t *Target, int32_t x, int32_t y, int32_t r, uint32_t Color);
+// Count glyphs from a 1bpp font (Height bytes per glyph, MSB leftmost, Width up to 8), Width apart on one row
+void glyphrun(RenderTarget_t *Target, int32_t x, int32_t y, const uint8_t *Font, int32_t Width, int32_t Height, const char *Text, uint32_t Count, uint32_t Color);
+// Copies pixels in the target's format, Source is the top left of a Width by Height block
+void blit(RenderTarget_t *Target, int32_t x, int32_t y, const void *Source, int32_t SourcePitch, int32_t Width, int32_t Height);
+// Same, but only where the matching Mask byte is non-zero, covered runs of a row are copied in one go
+void maskblit(RenderTarget_t *Target, int32_t x, int32_t y, const void *Source, int32_t SourcePitch, const uint8_t *Mask, int32_t MaskPitch, int32_t Width, int32_t Height);
+
+// Float color wrappers
+void pointf(RenderTarget_t *Target, int32_t x, int32_t y, float c[3]);
+void linef(RenderTarget_t *Target, int32_t x0, int32_t y0, int32_t x1, int32_t y1, float c[3]);
+void hlinef(RenderTarget_t *Target, int32_t x0, int32_t x1, int32_t y, float c[3]);
+void vlinef(RenderTarget_t *Target, int32_t x, int32_t y0, int32_t y1, float c[3]);
+void rectf(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2, float c[3]);
+void fillrectf(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2, float c[3]);
+void blendrectf(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2, float c[3], float a);
+void roundedrectf(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t r, float c[3]);
+void fillroundedrectf(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t r, float c[3]);
+void circlef(RenderTarget_t *Target, int32_t x, int32_t y, int32_t r, float c[3]);
+void fillcirclef(RenderTarget_t *Target, int32_t x, int32_t y, int32_t r, float c[3]);
+
+#endif
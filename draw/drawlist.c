@@ -0,0 +1,722 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../math/math.h"
+#include "draw.h"
+#include "drawlist.h"
+
+bool DrawList_Init(DrawList_t *List)
+{
+	if(List==NULL)
+		return false;
+
+	List->Size=0;
+	List->Count=0;
+	List->BufferSize=16*1024;
+	List->Buffer=(uint8_t *)malloc(List->BufferSize);
+
+	if(List->Buffer==NULL)
+	{
+		List->BufferSize=0;
+		return false;
+	}
+
+	return true;
+}
+
+void DrawList_Destroy(DrawList_t *List)
+{
+	if(List==NULL)
+		return;
+
+	free(List->Buffer);
+	memset(List, 0, sizeof(DrawList_t));
+}
+
+void DrawList_Clear(DrawList_t *List)
+{
+	if(List==NULL)
+		return;
+
+	// Keeps the memory for the next frame
+	List->Size=0;
+	List->Count=0;
+}
+
+uint32_t DrawList_GetCount(const DrawList_t *List)
+{
+	if(List==NULL)
+		return 0;
+
+	return List->Count;
+}
+
+size_t DrawList_GetSize(const DrawList_t *List)
+{
+	if(List==NULL)
+		return 0;
+
+	return List->Size;
+}
+
+void DrawList_Truncate(DrawList_t *List, size_t Size)
+{
+	if(List==NULL||Size>=List->Size)
+		return;
+
+	for(size_t Offset=Size;Offset<List->Size;Offset+=((const DrawCmdHeader_t *)(List->Buffer+Offset))->Size)
+		List->Count--;
+
+	List->Size=Size;
+}
+
+const DrawCmdHeader_t *DrawList_GetCommand(const DrawList_t *List, size_t Offset)
+{
+	if(List==NULL||Offset>=List->Size)
+		return NULL;
+
+	return (const DrawCmdHeader_t *)(List->Buffer+Offset);
+}
+
+static bool DrawList_Reserve(DrawList_t *List, size_t Size)
+{
+	if(List->Size+Size<=List->BufferSize)
+		return true;
+
+	size_t BufferSize=List->BufferSize?List->BufferSize:16*1024;
+
+	while(BufferSize<List->Size+Size)
+		BufferSize*=2;
+
+	uint8_t *Buffer=(uint8_t *)realloc(List->Buffer, BufferSize);
+
+	if(Buffer==NULL)
+		return false;
+
+	List->Buffer=Buffer;
+	List->BufferSize=BufferSize;
+
+	return true;
+}
+
+// Reserves a zeroed record at the end of the list and fills in its header
+static void *DrawList_Alloc(DrawList_t *List, DrawCmdType Type, size_t Size)
+{
+	if(List==NULL)
+		return NULL;
+
+	Size=(Size+DRAWLIST_ALIGN-1)&~(size_t)(DRAWLIST_ALIGN-1);
+
+	if(Size>UINT16_MAX||!DrawList_Reserve(List, Size))
+		return NULL;
+
+	DrawCmdHeader_t *Header=(DrawCmdHeader_t *)(List->Buffer+List->Size);
+
+	memset(Header, 0, Size);
+	Header->Type=(uint8_t)Type;
+	Header->Size=(uint16_t)Size;
+
+	List->Size+=Size;
+	List->Count++;
+
+	return Header;
+}
+
+bool DrawList_AddPoint(DrawList_t *List, int32_t x, int32_t y, uint32_t Color)
+{
+	DrawCmdPoint_t *Cmd=DrawList_Alloc(List, DRAW_CMD_POINT, sizeof(DrawCmdPoint_t));
+
+	if(Cmd==NULL)
+		return false;
+
+	Cmd->x=x;
+	Cmd->y=y;
+	Cmd->Color=Color;
+
+	return true;
+}
+
+bool DrawList_AddRect(DrawList_t *List, DrawCmdType Type, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t Color, uint32_t Alpha)
+{
+	DrawCmdRect_t *Cmd=DrawList_Alloc(List, Type, sizeof(DrawCmdRect_t));
+
+	if(Cmd==NULL)
+		return false;
+
+	Cmd->Header.Param=(uint8_t)min(Alpha, 255);
+	Cmd->x1=x1;
+	Cmd->y1=y1;
+	Cmd->x2=x2;
+	Cmd->y2=y2;
+	Cmd->Color=Color;
+
+	return true;
+}
+
+bool DrawList_AddRoundedRect(DrawList_t *List, DrawCmdType Type, int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t r, uint32_t Color)
+{
+	DrawCmdRoundedRect_t *Cmd=DrawList_Alloc(List, Type, sizeof(DrawCmdRoundedRect_t));
+
+	if(Cmd==NULL)
+		return false;
+
+	Cmd->x1=x1;
+	Cmd->y1=y1;
+	Cmd->x2=x2;
+	Cmd->y2=y2;
+	Cmd->r=r;
+	Cmd->Color=Color;
+
+	return true;
+}
+
+bool DrawList_AddCircle(DrawList_t *List, DrawCmdType Type, int32_t x, int32_t y, int32_t r, uint32_t Color)
+{
+	DrawCmdCircle_t *Cmd=DrawList_Alloc(List, Type, sizeof(DrawCmdCircle_t));
+
+	if(Cmd==NULL)
+		return false;
+
+	Cmd->x=x;
+	Cmd->y=y;
+	Cmd->r=r;
+	Cmd->Color=Color;
+
+	return true;
+}
+
+bool DrawList_AddGlyphRun(DrawList_t *List, int32_t x, int32_t y, const uint8_t *Font, int32_t Width, int32_t Height, const char *Text, uint32_t Count, uint32_t Color)
+{
+	if(Text==NULL||Width<=0||Width>8||Height<=0||Height>255)
+		return false;
+
+	// Longer runs than a record can hold get split
+	const uint32_t MaxCount=UINT16_MAX-sizeof(DrawCmdGlyphRun_t)-DRAWLIST_ALIGN;
+
+	while(Count>MaxCount)
+	{
+		if(!DrawList_AddGlyphRun(List, x, y, Font, Width, Height, Text, MaxCount, Color))
+			return false;
+
+		x+=MaxCount*Width;
+		Text+=MaxCount;
+		Count-=MaxCount;
+	}
+
+	DrawCmdGlyphRun_t *Cmd=DrawList_Alloc(List, DRAW_CMD_GLYPHRUN, sizeof(DrawCmdGlyphRun_t)+Count);
+
+	if(Cmd==NULL)
+		return false;
+
+	Cmd->Font=Font;
+	Cmd->x=x;
+	Cmd->y=y;
+	Cmd->Color=Color;
+	Cmd->Width=(uint8_t)Width;
+	Cmd->Height=(uint8_t)Height;
+	Cmd->Count=(uint16_t)Count;
+
+	memcpy(Cmd+1, Text, Count);
+
+	return true;
+}
+
+bool DrawList_AddBlit(DrawList_t *List, int32_t x, int32_t y, const void *Source, int32_t SourcePitch, int32_t Width, int32_t Height)
+{
+	DrawCmdBlit_t *Cmd=DrawList_Alloc(List, DRAW_CMD_BLIT, sizeof(DrawCmdBlit_t));
+
+	if(Cmd==NULL)
+		return false;
+
+	Cmd->Source=(const uint8_t *)Source;
+	Cmd->SourcePitch=SourcePitch;
+	Cmd->x=x;
+	Cmd->y=y;
+	Cmd->Width=Width;
+	Cmd->Height=Height;
+
+	return true;
+}
+
+bool DrawList_AddMaskBlit(DrawList_t *List, int32_t x, int32_t y, const void *Source, int32_t SourcePitch, const uint8_t *Mask, int32_t MaskPitch, int32_t Width, int32_t Height)
+{
+	DrawCmdMaskBlit_t *Cmd=DrawList_Alloc(List, DRAW_CMD_MASKBLIT, sizeof(DrawCmdMaskBlit_t));
+
+	if(Cmd==NULL)
+		return false;
+
+	Cmd->Source=(const uint8_t *)Source;
+	Cmd->Mask=Mask;
+	Cmd->SourcePitch=SourcePitch;
+	Cmd->MaskPitch=MaskPitch;
+	Cmd->x=x;
+	Cmd->y=y;
+	Cmd->Width=Width;
+	Cmd->Height=Height;
+
+	return true;
+}
+
+bool DrawList_AddClip(DrawList_t *List, const DrawRect_t *Rect)
+{
+	DrawCmdClip_t *Cmd=DrawList_Alloc(List, DRAW_CMD_CLIP, sizeof(DrawCmdClip_t));
+
+	if(Cmd==NULL)
+		return false;
+
+	if(Rect)
+	{
+		Cmd->Header.Param=1;
+		Cmd->Rect=*Rect;
+	}
+
+	return true;
+}
+
+bool DrawList_Append(DrawList_t *List, const DrawList_t *Source)
+{
+	if(List==NULL||Source==NULL)
+		return false;
+
+	if(!DrawList_Reserve(List, Source->Size))
+		return false;
+
+	memcpy(List->Buffer+List->Size, Source->Buffer, Source->Size);
+	List->Size+=Source->Size;
+	List->Count+=Source->Count;
+
+	return true;
+}
+
+DrawRect_t DrawList_GetCommandBounds(const DrawCmdHeader_t *Cmd)
+{
+	switch(Cmd->Type)
+	{
+		case DRAW_CMD_POINT:
+		{
+			const DrawCmdPoint_t *Point=(const DrawCmdPoint_t *)Cmd;
+
+			return (DrawRect_t) { Point->x, Point->y, Point->x, Point->y };
+		}
+
+		case DRAW_CMD_LINE:
+		case DRAW_CMD_FILLRECT:
+		case DRAW_CMD_BLENDRECT:
+		{
+			const DrawCmdRect_t *Rect=(const DrawCmdRect_t *)Cmd;
+
+			return (DrawRect_t) { min(Rect->x1, Rect->x2), min(Rect->y1, Rect->y2), max(Rect->x1, Rect->x2), max(Rect->y1, Rect->y2) };
+		}
+
+		case DRAW_CMD_FILLROUNDEDRECT:
+		{
+			const DrawCmdRoundedRect_t *Rect=(const DrawCmdRoundedRect_t *)Cmd;
+
+			return (DrawRect_t) { min(Rect->x1, Rect->x2), min(Rect->y1, Rect->y2), max(Rect->x1, Rect->x2), max(Rect->y1, Rect->y2) };
+		}
+
+		// Outline corners are centered r in from each edge, which can land outside the box if r is oversized
+		case DRAW_CMD_ROUNDEDRECT:
+		{
+			const DrawCmdRoundedRect_t *Rect=(const DrawCmdRoundedRect_t *)Cmd;
+
+			return (DrawRect_t)
+			{
+				min(min(Rect->x1, Rect->x2), min(Rect->x1+Rect->r, Rect->x2-Rect->r)),
+				min(min(Rect->y1, Rect->y2), min(Rect->y1+Rect->r, Rect->y2-Rect->r)),
+				max(max(Rect->x1, Rect->x2), max(Rect->x1+Rect->r, Rect->x2-Rect->r)),
+				max(max(Rect->y1, Rect->y2), max(Rect->y1+Rect->r, Rect->y2-Rect->r))
+			};
+		}
+
+		case DRAW_CMD_CIRCLE:
+		case DRAW_CMD_FILLCIRCLE:
+		{
+			const DrawCmdCircle_t *Circle=(const DrawCmdCircle_t *)Cmd;
+			int32_t r=Circle->r<0?-Circle->r:Circle->r;
+
+			return (DrawRect_t) { Circle->x-r, Circle->y-r, Circle->x+r, Circle->y+r };
+		}
+
+		case DRAW_CMD_GLYPHRUN:
+		{
+			const DrawCmdGlyphRun_t *Run=(const DrawCmdGlyphRun_t *)Cmd;
+
+			return (DrawRect_t) { Run->x, Run->y, Run->x+Run->Count*Run->Width-1, Run->y+Run->Height-1 };
+		}
+
+		case DRAW_CMD_BLIT:
+		{
+			const DrawCmdBlit_t *Blit=(const DrawCmdBlit_t *)Cmd;
+
+			return (DrawRect_t) { Blit->x, Blit->y, Blit->x+Blit->Width-1, Blit->y+Blit->Height-1 };
+		}
+
+		case DRAW_CMD_MASKBLIT:
+		{
+			const DrawCmdMaskBlit_t *Blit=(const DrawCmdMaskBlit_t *)Cmd;
+
+			return (DrawRect_t) { Blit->x, Blit->y, Blit->x+Blit->Width-1, Blit->y+Blit->Height-1 };
+		}
+	}
+
+	// Unknown command, empty
+	return (DrawRect_t) { 0, 0, -1, -1 };
+}
+
+DrawRect_t DrawList_GetBounds(const DrawList_t *List, size_t Start, size_t End)
+{
+	DrawRect_t Bounds={ 0, 0, -1, -1 };
+
+	if(List==NULL)
+		return Bounds;
+
+	End=min(End, List->Size);
+
+	// Only clips set within the range are known, anything before it is taken as unclipped
+	const DrawCmdClip_t *Clip=NULL;
+
+	for(size_t Offset=Start;Offset<End;)
+	{
+		const DrawCmdHeader_t *Cmd=(const DrawCmdHeader_t *)(List->Buffer+Offset);
+		DrawRect_t Rect=DrawList_GetCommandBounds(Cmd);
+
+		Offset+=Cmd->Size;
+
+		if(Cmd->Type==DRAW_CMD_CLIP)
+		{
+			Clip=Cmd->Param?(const DrawCmdClip_t *)Cmd:NULL;
+			continue;
+		}
+
+		if(Clip)
+		{
+			Rect.MinX=max(Rect.MinX, Clip->Rect.MinX);
+			Rect.MinY=max(Rect.MinY, Clip->Rect.MinY);
+			Rect.MaxX=min(Rect.MaxX, Clip->Rect.MaxX);
+			Rect.MaxY=min(Rect.MaxY, Clip->Rect.MaxY);
+		}
+
+		if(Rect.MinX>Rect.MaxX||Rect.MinY>Rect.MaxY)
+			continue;
+
+		if(Bounds.MinX>Bounds.MaxX)
+			Bounds=Rect;
+		else
+		{
+			Bounds.MinX=min(Bounds.MinX, Rect.MinX);
+			Bounds.MinY=min(Bounds.MinY, Rect.MinY);
+			Bounds.MaxX=max(Bounds.MaxX, Rect.MaxX);
+			Bounds.MaxY=max(Bounds.MaxY, Rect.MaxY);
+		}
+	}
+
+	return Bounds;
+}
+
+// Sort key, layer first then type, submission order breaks ties so the sort is stable
+typedef struct
+{
+	uint32_t Layer;
+	uint32_t Type;
+	uint32_t Index;
+	uint32_t Offset;
+} DrawList_SortKey_t;
+
+static int DrawList_CompareKeys(const void *a, const void *b)
+{
+	const DrawList_SortKey_t *KeyA=(const DrawList_SortKey_t *)a;
+	const DrawList_SortKey_t *KeyB=(const DrawList_SortKey_t *)b;
+
+	if(KeyA->Layer!=KeyB->Layer)
+		return KeyA->Layer<KeyB->Layer?-1:1;
+
+	if(KeyA->Type!=KeyB->Type)
+		return KeyA->Type<KeyB->Type?-1:1;
+
+	return KeyA->Index<KeyB->Index?-1:KeyA->Index>KeyB->Index?1:0;
+}
+
+// Coarse grid used to find overlaps, never more than this many cells a side
+#define DRAWLIST_SORT_GRID 32
+
+// Every command gets a layer, at least the layer of any earlier command it shares a grid cell with, and one more
+// if that command's type sorts after its own. Sorting by (layer, type, order) then never swaps two commands that
+// could touch the same pixel, so the sorted list draws exactly what the original did.
+bool DrawList_Sort(DrawList_t *List)
+{
+	if(List==NULL)
+		return false;
+
+	if(List->Count<2)
+		return true;
+
+	DrawList_SortKey_t *Keys=(DrawList_SortKey_t *)malloc(sizeof(DrawList_SortKey_t)*List->Count);
+	DrawRect_t *Bounds=(DrawRect_t *)malloc(sizeof(DrawRect_t)*List->Count);
+	// Highest layer per cell per type, 0 is empty so layers are stored plus one
+	uint32_t *Cells=(uint32_t *)calloc(DRAWLIST_SORT_GRID*DRAWLIST_SORT_GRID*DRAW_NUM_CMD, sizeof(uint32_t));
+	uint8_t *Buffer=(uint8_t *)malloc(List->BufferSize);
+
+	if(Keys==NULL||Bounds==NULL||Cells==NULL||Buffer==NULL)
+	{
+		free(Keys);
+		free(Bounds);
+		free(Cells);
+		free(Buffer);
+		return false;
+	}
+
+	// Grid covers the union of everything, anything outside the 16 bit range is clamped (it's off any surface)
+	DrawRect_t Extent={ INT16_MAX, INT16_MAX, INT16_MIN, INT16_MIN };
+	uint32_t Count=0;
+
+	for(size_t Offset=0;Offset<List->Size;Offset+=((const DrawCmdHeader_t *)(List->Buffer+Offset))->Size, Count++)
+	{
+		DrawRect_t Rect=DrawList_GetCommandBounds((const DrawCmdHeader_t *)(List->Buffer+Offset));
+
+		Rect.MinX=max(INT16_MIN, min(INT16_MAX, Rect.MinX));
+		Rect.MinY=max(INT16_MIN, min(INT16_MAX, Rect.MinY));
+		Rect.MaxX=max(INT16_MIN, min(INT16_MAX, Rect.MaxX));
+		Rect.MaxY=max(INT16_MIN, min(INT16_MAX, Rect.MaxY));
+
+		Bounds[Count]=Rect;
+		Keys[Count].Offset=(uint32_t)Offset;
+		Keys[Count].Index=Count;
+
+		if(Rect.MinX<=Rect.MaxX&&Rect.MinY<=Rect.MaxY)
+		{
+			Extent.MinX=min(Extent.MinX, Rect.MinX);
+			Extent.MinY=min(Extent.MinY, Rect.MinY);
+			Extent.MaxX=max(Extent.MaxX, Rect.MaxX);
+			Extent.MaxY=max(Extent.MaxY, Rect.MaxY);
+		}
+	}
+
+	int32_t CellW=max(1, (Extent.MaxX-Extent.MinX+DRAWLIST_SORT_GRID)/DRAWLIST_SORT_GRID);
+	int32_t CellH=max(1, (Extent.MaxY-Extent.MinY+DRAWLIST_SORT_GRID)/DRAWLIST_SORT_GRID);
+
+	// Clip commands are barriers, each goes above everything before it and everything after goes above it
+	uint32_t Floor=0, Top=0;
+
+	for(uint32_t i=0;i<Count;i++)
+	{
+		const DrawRect_t *Rect=&Bounds[i];
+		uint32_t Type=((const DrawCmdHeader_t *)(List->Buffer+Keys[i].Offset))->Type;
+		uint32_t Layer=Floor;
+
+		Keys[i].Type=Type;
+
+		if(Type==DRAW_CMD_CLIP)
+		{
+			Keys[i].Layer=Top+1;
+			Floor=Top=Top+2;
+			continue;
+		}
+
+		// Draws nothing, leave it where it is
+		if(Rect->MinX>Rect->MaxX||Rect->MinY>Rect->MaxY)
+		{
+			Keys[i].Layer=Floor;
+			continue;
+		}
+
+		int32_t cx1=(Rect->MinX-Extent.MinX)/CellW, cx2=(Rect->MaxX-Extent.MinX)/CellW;
+		int32_t cy1=(Rect->MinY-Extent.MinY)/CellH, cy2=(Rect->MaxY-Extent.MinY)/CellH;
+
+		for(int32_t y=cy1;y<=cy2;y++)
+		{
+			for(int32_t x=cx1;x<=cx2;x++)
+			{
+				const uint32_t *Cell=&Cells[(y*DRAWLIST_SORT_GRID+x)*DRAW_NUM_CMD];
+
+				for(uint32_t t=0;t<DRAW_NUM_CMD;t++)
+				{
+					if(Cell[t])
+						Layer=max(Layer, Cell[t]-1+(t>Type?1:0));
+				}
+			}
+		}
+
+		Keys[i].Layer=Layer;
+		Top=max(Top, Layer);
+
+		for(int32_t y=cy1;y<=cy2;y++)
+		{
+			for(int32_t x=cx1;x<=cx2;x++)
+			{
+				uint32_t *Cell=&Cells[(y*DRAWLIST_SORT_GRID+x)*DRAW_NUM_CMD+Type];
+
+				*Cell=max(*Cell, Layer+1);
+			}
+		}
+	}
+
+	qsort(Keys, Count, sizeof(DrawList_SortKey_t), DrawList_CompareKeys);
+
+	size_t Size=0;
+
+	for(uint32_t i=0;i<Count;i++)
+	{
+		const DrawCmdHeader_t *Cmd=(const DrawCmdHeader_t *)(List->Buffer+Keys[i].Offset);
+
+		memcpy(Buffer+Size, Cmd, Cmd->Size);
+		Size+=Cmd->Size;
+	}
+
+	free(List->Buffer);
+	List->Buffer=Buffer;
+
+	free(Keys);
+	free(Bounds);
+	free(Cells);
+
+	return true;
+}
+
+void DrawList_ExecuteCommand(RenderTarget_t *Target, const DrawCmdHeader_t *Cmd)
+{
+	switch(Cmd->Type)
+	{
+		case DRAW_CMD_POINT:
+		{
+			const DrawCmdPoint_t *Point=(const DrawCmdPoint_t *)Cmd;
+
+			point(Target, Point->x, Point->y, Point->Color);
+			break;
+		}
+
+		case DRAW_CMD_LINE:
+		{
+			const DrawCmdRect_t *Rect=(const DrawCmdRect_t *)Cmd;
+
+			line(Target, Rect->x1, Rect->y1, Rect->x2, Rect->y2, Rect->Color);
+			break;
+		}
+
+		case DRAW_CMD_FILLRECT:
+		{
+			const DrawCmdRect_t *Rect=(const DrawCmdRect_t *)Cmd;
+
+			fillrect(Target, Rect->x1, Rect->y1, Rect->x2, Rect->y2, Rect->Color);
+			break;
+		}
+
+		case DRAW_CMD_BLENDRECT:
+		{
+			const DrawCmdRect_t *Rect=(const DrawCmdRect_t *)Cmd;
+
+			blendrect(Target, Rect->x1, Rect->y1, Rect->x2, Rect->y2, Rect->Color, Cmd->Param);
+			break;
+		}
+
+		case DRAW_CMD_ROUNDEDRECT:
+		{
+			const DrawCmdRoundedRect_t *Rect=(const DrawCmdRoundedRect_t *)Cmd;
+
+			roundedrect(Target, Rect->x1, Rect->y1, Rect->x2, Rect->y2, Rect->r, Rect->Color);
+			break;
+		}
+
+		case DRAW_CMD_FILLROUNDEDRECT:
+		{
+			const DrawCmdRoundedRect_t *Rect=(const DrawCmdRoundedRect_t *)Cmd;
+
+			fillroundedrect(Target, Rect->x1, Rect->y1, Rect->x2, Rect->y2, Rect->r, Rect->Color);
+			break;
+		}
+
+		case DRAW_CMD_CIRCLE:
+		{
+			const DrawCmdCircle_t *Circle=(const DrawCmdCircle_t *)Cmd;
+
+			circle(Target, Circle->x, Circle->y, Circle->r, Circle->Color);
+			break;
+		}
+
+		case DRAW_CMD_FILLCIRCLE:
+		{
+			const DrawCmdCircle_t *Circle=(const DrawCmdCircle_t *)Cmd;
+
+			fillcircle(Target, Circle->x, Circle->y, Circle->r, Circle->Color);
+			break;
+		}
+
+		case DRAW_CMD_GLYPHRUN:
+		{
+			const DrawCmdGlyphRun_t *Run=(const DrawCmdGlyphRun_t *)Cmd;
+
+			glyphrun(Target, Run->x, Run->y, Run->Font, Run->Width, Run->Height, (const char *)(Run+1), Run->Count, Run->Color);
+			break;
+		}
+
+		case DRAW_CMD_BLIT:
+		{
+			const DrawCmdBlit_t *Blit=(const DrawCmdBlit_t *)Cmd;
+
+			blit(Target, Blit->x, Blit->y, Blit->Source, Blit->SourcePitch, Blit->Width, Blit->Height);
+			break;
+		}
+
+		case DRAW_CMD_MASKBLIT:
+		{
+			const DrawCmdMaskBlit_t *Blit=(const DrawCmdMaskBlit_t *)Cmd;
+
+			maskblit(Target, Blit->x, Blit->y, Blit->Source, Blit->SourcePitch, Blit->Mask, Blit->MaskPitch, Blit->Width, Blit->Height);
+			break;
+		}
+
+		default:
+			break;
+	}
+}
+
+bool DrawList_ApplyClip(RenderTarget_t *Target, DrawRect_t Base, const DrawCmdClip_t *Clip)
+{
+	if(Clip->Header.Param)
+	{
+		Base.MinX=max(Base.MinX, Clip->Rect.MinX);
+		Base.MinY=max(Base.MinY, Clip->Rect.MinY);
+		Base.MaxX=min(Base.MaxX, Clip->Rect.MaxX);
+		Base.MaxY=min(Base.MaxY, Clip->Rect.MaxY);
+
+		// Primitives expect a clip inside the surface, so an empty one is left alone and reported instead
+		if(Base.MinX>Base.MaxX||Base.MinY>Base.MaxY)
+			return false;
+	}
+
+	Target->ClipMinX=Base.MinX;
+	Target->ClipMinY=Base.MinY;
+	Target->ClipMaxX=Base.MaxX;
+	Target->ClipMaxY=Base.MaxY;
+
+	return true;
+}
+
+void DrawList_Execute(const DrawList_t *List, RenderTarget_t *Target)
+{
+	if(List==NULL||Target==NULL||Target->List)
+		return;
+
+	const DrawRect_t Base={ Target->ClipMinX, Target->ClipMinY, Target->ClipMaxX, Target->ClipMaxY };
+	bool Visible=true;
+
+	for(size_t Offset=0;Offset<List->Size;)
+	{
+		const DrawCmdHeader_t *Cmd=(const DrawCmdHeader_t *)(List->Buffer+Offset);
+
+		if(Cmd->Type==DRAW_CMD_CLIP)
+			Visible=DrawList_ApplyClip(Target, Base, (const DrawCmdClip_t *)Cmd);
+		else if(Visible)
+			DrawList_ExecuteCommand(Target, Cmd);
+
+		Offset+=Cmd->Size;
+	}
+
+	// Lists don't have to end unclipped
+	Target->ClipMinX=Base.MinX;
+	Target->ClipMinY=Base.MinY;
+	Target->ClipMaxX=Base.MaxX;
+	Target->ClipMaxY=Base.MaxY;
+}
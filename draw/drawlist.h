@@ -0,0 +1,160 @@
+#ifndef __DRAWLIST_H__
+#define __DRAWLIST_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "draw.h"
+
+typedef enum
+{
+	DRAW_CMD_POINT=0,
+	DRAW_CMD_LINE,
+	DRAW_CMD_FILLRECT,
+	DRAW_CMD_BLENDRECT,
+	DRAW_CMD_ROUNDEDRECT,
+	DRAW_CMD_FILLROUNDEDRECT,
+	DRAW_CMD_CIRCLE,
+	DRAW_CMD_FILLCIRCLE,
+	DRAW_CMD_GLYPHRUN,
+	DRAW_CMD_BLIT,
+	DRAW_CMD_MASKBLIT,
+	DRAW_CMD_CLIP,
+	DRAW_NUM_CMD
+} DrawCmdType;
+
+// Records are packed back to back, each one padded to this so the pointers in them stay aligned
+#define DRAWLIST_ALIGN 8
+
+// Every command starts with this, Size is the whole record in bytes
+typedef struct
+{
+	uint8_t Type;
+	uint8_t Param;
+	uint16_t Size;
+} DrawCmdHeader_t;
+
+// Parameters are kept exactly as passed to the primitive, so a replay draws the same pixels
+
+// DRAW_CMD_POINT
+typedef struct
+{
+	DrawCmdHeader_t Header;
+	int32_t x, y;
+	uint32_t Color;
+} DrawCmdPoint_t;
+
+// DRAW_CMD_LINE, DRAW_CMD_FILLRECT and DRAW_CMD_BLENDRECT (alpha in Header.Param)
+typedef struct
+{
+	DrawCmdHeader_t Header;
+	int32_t x1, y1, x2, y2;
+	uint32_t Color;
+} DrawCmdRect_t;
+
+// DRAW_CMD_ROUNDEDRECT and DRAW_CMD_FILLROUNDEDRECT
+typedef struct
+{
+	DrawCmdHeader_t Header;
+	int32_t x1, y1, x2, y2, r;
+	uint32_t Color;
+} DrawCmdRoundedRect_t;
+
+// DRAW_CMD_CIRCLE and DRAW_CMD_FILLCIRCLE
+typedef struct
+{
+	DrawCmdHeader_t Header;
+	int32_t x, y, r;
+	uint32_t Color;
+} DrawCmdCircle_t;
+
+// DRAW_CMD_GLYPHRUN, followed by Count glyph codes
+typedef struct
+{
+	DrawCmdHeader_t Header;
+	const uint8_t *Font;
+	int32_t x, y;
+	uint32_t Color;
+	uint8_t Width, Height;
+	uint16_t Count;
+} DrawCmdGlyphRun_t;
+
+// DRAW_CMD_BLIT, the source pixels must stay alive until the list is replayed
+typedef struct
+{
+	DrawCmdHeader_t Header;
+	const uint8_t *Source;
+	int32_t SourcePitch;
+	int32_t x, y, Width, Height;
+} DrawCmdBlit_t;
+
+// DRAW_CMD_MASKBLIT, same as a blit plus a byte per pixel mask, both must stay alive until the list is replayed
+typedef struct
+{
+	DrawCmdHeader_t Header;
+	const uint8_t *Source;
+	const uint8_t *Mask;
+	int32_t SourcePitch, MaskPitch;
+	int32_t x, y, Width, Height;
+} DrawCmdMaskBlit_t;
+
+// DRAW_CMD_CLIP, with Header.Param set everything after it is clipped to Rect (inside the target's own clip) until
+// the next one, without it the target's clip is back. Draws nothing itself, so its bounds are empty.
+typedef struct
+{
+	DrawCmdHeader_t Header;
+	DrawRect_t Rect;
+} DrawCmdClip_t;
+
+// Setting a DrawList on a RenderTarget makes the primitives record into it instead of drawing.
+typedef struct DrawList_s
+{
+	uint8_t *Buffer;
+	size_t Size, BufferSize;
+	uint32_t Count;
+} DrawList_t;
+
+bool DrawList_Init(DrawList_t *List);
+void DrawList_Destroy(DrawList_t *List);
+void DrawList_Clear(DrawList_t *List);
+uint32_t DrawList_GetCount(const DrawList_t *List);
+size_t DrawList_GetSize(const DrawList_t *List);
+// Drops every command from Size on, Size must be an offset between commands (as from DrawList_GetSize)
+void DrawList_Truncate(DrawList_t *List, size_t Size);
+
+// Walking the list, Offset starts at 0 and ends at DrawList_GetSize
+const DrawCmdHeader_t *DrawList_GetCommand(const DrawList_t *List, size_t Offset);
+
+// Conservative bounds of every pixel a command can touch
+DrawRect_t DrawList_GetCommandBounds(const DrawCmdHeader_t *Cmd);
+// Union of the command bounds between two offsets, empty if nothing there draws
+DrawRect_t DrawList_GetBounds(const DrawList_t *List, size_t Start, size_t End);
+
+// Used by the primitives themselves when recording
+bool DrawList_AddPoint(DrawList_t *List, int32_t x, int32_t y, uint32_t Color);
+bool DrawList_AddRect(DrawList_t *List, DrawCmdType Type, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t Color, uint32_t Alpha);
+bool DrawList_AddRoundedRect(DrawList_t *List, DrawCmdType Type, int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t r, uint32_t Color);
+bool DrawList_AddCircle(DrawList_t *List, DrawCmdType Type, int32_t x, int32_t y, int32_t r, uint32_t Color);
+bool DrawList_AddGlyphRun(DrawList_t *List, int32_t x, int32_t y, const uint8_t *Font, int32_t Width, int32_t Height, const char *Text, uint32_t Count, uint32_t Color);
+bool DrawList_AddBlit(DrawList_t *List, int32_t x, int32_t y, const void *Source, int32_t SourcePitch, int32_t Width, int32_t Height);
+bool DrawList_AddMaskBlit(DrawList_t *List, int32_t x, int32_t y, const void *Source, int32_t SourcePitch, const uint8_t *Mask, int32_t MaskPitch, int32_t Width, int32_t Height);
+// Clips what comes after to Rect, NULL goes back to the target's clip
+bool DrawList_AddClip(DrawList_t *List, const DrawRect_t *Rect);
+
+// Copies every command of Source onto the end of List, for splicing retained lists into a frame
+bool DrawList_Append(DrawList_t *List, const DrawList_t *Source);
+
+// Groups commands by type where it can't change the result, commands only move past ones they don't overlap.
+// Fewer type switches, but worse pixel locality, so measure before using it (see the -bench command buffer section).
+bool DrawList_Sort(DrawList_t *List);
+
+// Runs a single command against a target, the target must not be recording. Clip commands are left to the caller,
+// see DrawList_ApplyClip.
+void DrawList_ExecuteCommand(RenderTarget_t *Target, const DrawCmdHeader_t *Cmd);
+// Sets the target's clip for a clip command, Base is the clip it had before the list started.
+// Returns false if nothing can be drawn until the next clip command.
+bool DrawList_ApplyClip(RenderTarget_t *Target, DrawRect_t Base, const DrawCmdClip_t *Clip);
+// Replays the whole list in order, this is the single threaded reference path
+void DrawList_Execute(const DrawList_t *List, RenderTarget_t *Target);
+
+#endif
@@ -0,0 +1,320 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../math/math.h"
+#include "../utils/list.h"
+#include "../utils/threads.h"
+#include "draw.h"
+#include "drawlist.h"
+#include "raster.h"
+
+bool Raster_Init(Raster_t *Raster, uint32_t NumThreads)
+{
+	if(Raster==NULL)
+		return false;
+
+	memset(Raster, 0, sizeof(Raster_t));
+
+	return ThreadPool_Init(&Raster->Pool, NumThreads);
+}
+
+static void Raster_FreeBins(Raster_t *Raster)
+{
+	for(uint32_t i=0;i<Raster->NumBins;i++)
+		List_Destroy(&Raster->Bins[i]);
+
+	free(Raster->Bins);
+	free(Raster->TilePixels);
+
+	Raster->Bins=NULL;
+	Raster->TilePixels=NULL;
+	Raster->NumBins=0;
+	Raster->TilesX=0;
+	Raster->TilesY=0;
+}
+
+void Raster_Destroy(Raster_t *Raster)
+{
+	if(Raster==NULL)
+		return;
+
+	ThreadPool_Destroy(&Raster->Pool);
+	Raster_FreeBins(Raster);
+}
+
+uint32_t Raster_GetNumThreads(Raster_t *Raster)
+{
+	if(Raster==NULL)
+		return 0;
+
+	return Raster->Pool.NumThreads;
+}
+
+// (Re)builds the tile grid when the target size changes
+static bool Raster_ResizeBins(Raster_t *Raster, uint32_t Width, uint32_t Height)
+{
+	uint32_t TilesX=(Width+RASTER_TILE_WIDTH-1)/RASTER_TILE_WIDTH;
+	uint32_t TilesY=(Height+RASTER_TILE_HEIGHT-1)/RASTER_TILE_HEIGHT;
+
+	if(TilesX==Raster->TilesX&&TilesY==Raster->TilesY&&Raster->Bins)
+		return true;
+
+	Raster_FreeBins(Raster);
+
+	Raster->Bins=(List_t *)calloc(TilesX*TilesY, sizeof(List_t));
+	Raster->TilePixels=(uint64_t *)calloc(TilesX*TilesY, sizeof(uint64_t));
+
+	if(Raster->Bins==NULL||Raster->TilePixels==NULL)
+	{
+		Raster_FreeBins(Raster);
+		return false;
+	}
+
+	for(uint32_t i=0;i<TilesX*TilesY;i++)
+	{
+		if(!List_Init(&Raster->Bins[i], sizeof(uint32_t), 64, NULL))
+		{
+			Raster->NumBins=i;
+			Raster_FreeBins(Raster);
+			return false;
+		}
+	}
+
+	Raster->NumBins=TilesX*TilesY;
+	Raster->TilesX=TilesX;
+	Raster->TilesY=TilesY;
+
+	return true;
+}
+
+// Replays a tile's bin into Tile, which is already clipped to the part of the tile being drawn
+static void Raster_ReplayBin(const Raster_t *Raster, List_t *Bin, RenderTarget_t *Tile)
+{
+	const uint32_t Count=(uint32_t)List_GetCount(Bin);
+	const uint32_t *Offsets=(const uint32_t *)List_GetBufferPointer(Bin);
+	const uint8_t *Buffer=Raster->List->Buffer;
+	const DrawRect_t Base={ Tile->ClipMinX, Tile->ClipMinY, Tile->ClipMaxX, Tile->ClipMaxY };
+	bool Visible=true;
+
+	for(uint32_t i=0;i<Count;i++)
+	{
+		const DrawCmdHeader_t *Cmd=(const DrawCmdHeader_t *)(Buffer+Offsets[i]);
+
+		if(Cmd->Type==DRAW_CMD_CLIP)
+			Visible=DrawList_ApplyClip(Tile, Base, (const DrawCmdClip_t *)Cmd);
+		else if(Visible)
+			DrawList_ExecuteCommand(Tile, Cmd);
+	}
+
+	// The next rect starts from the tile's clip again
+	RenderTarget_SetClip(Tile, Base.MinX, Base.MinY, Base.MaxX, Base.MaxY);
+}
+
+// Worker job, one tile per index
+static void Raster_TileJob(void *Arg, uint32_t Index)
+{
+	Raster_t *Raster=(Raster_t *)Arg;
+	List_t *Bin=&Raster->Bins[Index];
+
+	Raster->TilePixels[Index]=0;
+
+	// A redraw clears its rects even where nothing was recorded
+	if(!List_GetCount(Bin)&&Raster->Rects==NULL)
+		return;
+
+	// Private copy of the target, clipped down to this tile.
+	// Every primitive clips exactly, so the pixels it writes here are exactly the ones it would have written
+	// to this tile when drawn to the whole target.
+	RenderTarget_t Tile=*Raster->Target;
+	int32_t tx=(int32_t)(Index%Raster->TilesX)*RASTER_TILE_WIDTH;
+	int32_t ty=(int32_t)(Index/Raster->TilesX)*RASTER_TILE_HEIGHT;
+
+	Tile.ClipMinX=max(Tile.ClipMinX, tx);
+	Tile.ClipMinY=max(Tile.ClipMinY, ty);
+	Tile.ClipMaxX=min(Tile.ClipMaxX, tx+RASTER_TILE_WIDTH-1);
+	Tile.ClipMaxY=min(Tile.ClipMaxY, ty+RASTER_TILE_HEIGHT-1);
+	Tile.PixelsWritten=0;
+	Tile.List=NULL;
+
+	if(Raster->Rects==NULL)
+		Raster_ReplayBin(Raster, Bin, &Tile);
+	else
+	{
+		// Clear and redraw each rect touching this tile, clipped to where they overlap
+		const DrawRect_t TileRect={ Tile.ClipMinX, Tile.ClipMinY, Tile.ClipMaxX, Tile.ClipMaxY };
+
+		for(uint32_t i=0;i<Raster->NumRects;i++)
+		{
+			const DrawRect_t *Rect=&Raster->Rects[i];
+			int32_t MinX=max(TileRect.MinX, Rect->MinX), MaxX=min(TileRect.MaxX, Rect->MaxX);
+			int32_t MinY=max(TileRect.MinY, Rect->MinY), MaxY=min(TileRect.MaxY, Rect->MaxY);
+
+			if(MinX>MaxX||MinY>MaxY)
+				continue;
+
+			RenderTarget_SetClip(&Tile, MinX, MinY, MaxX, MaxY);
+			Clear(&Tile);
+			Raster_ReplayBin(Raster, Bin, &Tile);
+		}
+	}
+
+	Raster->TilePixels[Index]=Tile.PixelsWritten;
+}
+
+// Sorts the commands into the tile bins, only where they can touch Base. False if a bin couldn't grow.
+static bool Raster_Bin(Raster_t *Raster, const DrawList_t *List, const RenderTarget_t *Target, const DrawRect_t Base)
+{
+	if(!Raster_ResizeBins(Raster, Target->Width, Target->Height))
+		return false;
+
+	for(uint32_t i=0;i<Raster->NumBins;i++)
+		List_Clear(&Raster->Bins[i]);
+
+	// Bin by bounding box, clipped to Base and whatever clip command is in effect.
+	// Commands go into each bin in submission order, which keeps overlapping draws (and blends) in order per pixel.
+	DrawRect_t Clip=Base;
+
+	for(size_t Offset=0;Offset<List->Size;)
+	{
+		const DrawCmdHeader_t *Cmd=(const DrawCmdHeader_t *)(List->Buffer+Offset);
+		DrawRect_t Bounds=DrawList_GetCommandBounds(Cmd);
+		int32_t MinX=max(Bounds.MinX, Clip.MinX), MaxX=min(Bounds.MaxX, Clip.MaxX);
+		int32_t MinY=max(Bounds.MinY, Clip.MinY), MaxY=min(Bounds.MaxY, Clip.MaxY);
+		uint32_t CmdOffset=(uint32_t)Offset;
+
+		Offset+=Cmd->Size;
+
+		// Every tile has to see every clip change, there are only a few of these
+		if(Cmd->Type==DRAW_CMD_CLIP)
+		{
+			const DrawCmdClip_t *ClipCmd=(const DrawCmdClip_t *)Cmd;
+
+			Clip=Base;
+
+			if(Cmd->Param)
+			{
+				Clip.MinX=max(Clip.MinX, ClipCmd->Rect.MinX);
+				Clip.MinY=max(Clip.MinY, ClipCmd->Rect.MinY);
+				Clip.MaxX=min(Clip.MaxX, ClipCmd->Rect.MaxX);
+				Clip.MaxY=min(Clip.MaxY, ClipCmd->Rect.MaxY);
+			}
+
+			for(uint32_t i=0;i<Raster->NumBins;i++)
+			{
+				if(!List_Add(&Raster->Bins[i], &CmdOffset))
+					return false;
+			}
+
+			continue;
+		}
+
+		if(MinX>MaxX||MinY>MaxY)
+			continue;
+
+		for(int32_t y=MinY/RASTER_TILE_HEIGHT;y<=MaxY/RASTER_TILE_HEIGHT;y++)
+		{
+			for(int32_t x=MinX/RASTER_TILE_WIDTH;x<=MaxX/RASTER_TILE_WIDTH;x++)
+			{
+				if(!List_Add(&Raster->Bins[y*Raster->TilesX+x], &CmdOffset))
+					return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+// Runs the tile jobs over what's binned, clearing and drawing only inside Rects when there are any
+static void Raster_Dispatch(Raster_t *Raster, DrawList_t *List, RenderTarget_t *Target, const DrawRect_t *Rects, uint32_t NumRects)
+{
+	Raster->List=List;
+	Raster->Target=Target;
+	Raster->Rects=Rects;
+	Raster->NumRects=NumRects;
+
+	ThreadPool_Dispatch(&Raster->Pool, Raster_TileJob, Raster, Raster->NumBins);
+
+	for(uint32_t i=0;i<Raster->NumBins;i++)
+		Target->PixelsWritten+=Raster->TilePixels[i];
+
+	Raster->List=NULL;
+	Raster->Target=NULL;
+	Raster->Rects=NULL;
+	Raster->NumRects=0;
+}
+
+bool Raster_Flush(Raster_t *Raster, DrawList_t *List, RenderTarget_t *Target)
+{
+	if(Raster==NULL||List==NULL||Target==NULL||Target->List)
+		return false;
+
+	if(!DrawList_GetCount(List))
+		return true;
+
+	// A tile missing a command (or a clip change) would draw wrong without saying so, so anything short of
+	// binning all of it draws the whole list on this thread instead
+	if(!Raster_Bin(Raster, List, Target, (DrawRect_t){ Target->ClipMinX, Target->ClipMinY, Target->ClipMaxX, Target->ClipMaxY }))
+	{
+		DrawList_Execute(List, Target);
+		return true;
+	}
+
+	Raster_Dispatch(Raster, List, Target, NULL, 0);
+
+	return true;
+}
+
+bool Raster_FlushRects(Raster_t *Raster, DrawList_t *List, RenderTarget_t *Target, const DrawRect_t *Rects, uint32_t NumRects)
+{
+	if(Raster==NULL||List==NULL||Target==NULL||Target->List||(Rects==NULL&&NumRects))
+		return false;
+
+	// Everything the rects can touch, binning skips whatever's outside it
+	DrawRect_t Bounds={ INT32_MAX, INT32_MAX, INT32_MIN, INT32_MIN };
+
+	for(uint32_t i=0;i<NumRects;i++)
+	{
+		Bounds.MinX=min(Bounds.MinX, Rects[i].MinX);
+		Bounds.MinY=min(Bounds.MinY, Rects[i].MinY);
+		Bounds.MaxX=max(Bounds.MaxX, Rects[i].MaxX);
+		Bounds.MaxY=max(Bounds.MaxY, Rects[i].MaxY);
+	}
+
+	Bounds.MinX=max(Bounds.MinX, Target->ClipMinX);
+	Bounds.MinY=max(Bounds.MinY, Target->ClipMinY);
+	Bounds.MaxX=min(Bounds.MaxX, Target->ClipMaxX);
+	Bounds.MaxY=min(Bounds.MaxY, Target->ClipMaxY);
+
+	if(Bounds.MinX>Bounds.MaxX||Bounds.MinY>Bounds.MaxY)
+		return true;
+
+	// One thread gets nothing back for binning, and a failed bin can't be drawn from. Either way each rect is cleared
+	// and the list drawn clipped to it, right here.
+	if(Raster_GetNumThreads(Raster)<=1||!Raster_Bin(Raster, List, Target, Bounds))
+	{
+		const DrawRect_t Clip={ Target->ClipMinX, Target->ClipMinY, Target->ClipMaxX, Target->ClipMaxY };
+
+		for(uint32_t i=0;i<NumRects;i++)
+		{
+			int32_t MinX=max(Rects[i].MinX, Clip.MinX), MaxX=min(Rects[i].MaxX, Clip.MaxX);
+			int32_t MinY=max(Rects[i].MinY, Clip.MinY), MaxY=min(Rects[i].MaxY, Clip.MaxY);
+
+			if(MinX>MaxX||MinY>MaxY)
+				continue;
+
+			RenderTarget_SetClip(Target, MinX, MinY, MaxX, MaxY);
+			Clear(Target);
+			DrawList_Execute(List, Target);
+		}
+
+		RenderTarget_SetClip(Target, Clip.MinX, Clip.MinY, Clip.MaxX, Clip.MaxY);
+
+		return true;
+	}
+
+	Raster_Dispatch(Raster, List, Target, Rects, NumRects);
+
+	return true;
+}
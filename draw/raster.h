@@ -0,0 +1,50 @@
+#ifndef __RASTER_H__
+#define __RASTER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../utils/list.h"
+#include "../utils/threads.h"
+#include "draw.h"
+#include "drawlist.h"
+
+// Screen tile size in pixels, each tile is rasterized start to finish by one thread.
+// Wider than tall on purpose, short rows on a large pitch cost a page walk each.
+#ifndef RASTER_TILE_WIDTH
+#define RASTER_TILE_WIDTH 128
+#endif
+#ifndef RASTER_TILE_HEIGHT
+#define RASTER_TILE_HEIGHT 64
+#endif
+
+typedef struct
+{
+	ThreadPool_t Pool;
+
+	// Tile grid for the last target flushed, bins are reused across frames
+	uint32_t TilesX, TilesY, NumBins;
+	List_t *Bins;	// Byte offsets of the commands touching each tile
+	uint64_t *TilePixels;
+
+	// Current flush, only valid while Raster_Flush is running
+	DrawList_t *List;
+	RenderTarget_t *Target;
+	const DrawRect_t *Rects;	// Raster_FlushRects only
+	uint32_t NumRects;
+} Raster_t;
+
+bool Raster_Init(Raster_t *Raster, uint32_t NumThreads);
+void Raster_Destroy(Raster_t *Raster);
+uint32_t Raster_GetNumThreads(Raster_t *Raster);
+
+// Bins the recorded commands into tiles and rasterizes the tiles across the pool.
+// Every tile replays its commands in submission order clipped to the tile, so the output is identical to DrawList_Execute.
+// If the bins can't be allocated it falls back to DrawList_Execute on the calling thread.
+bool Raster_Flush(Raster_t *Raster, DrawList_t *List, RenderTarget_t *Target);
+// Clears each rect and draws the list clipped to it, the same as setting the clip, Clear and Raster_Flush per rect.
+// The list is only binned once however many rects there are, and tiles only clear and draw where the rects touch them.
+// With a single thread it draws each rect directly instead, tiles only cost it time.
+bool Raster_FlushRects(Raster_t *Raster, DrawList_t *List, RenderTarget_t *Target, const DrawRect_t *Rects, uint32_t NumRects);
+
+#endif
@@ -0,0 +1,424 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "span.h"
+
+#if defined(_M_X64)||defined(_M_IX86)||defined(__x86_64__)||defined(__i386__)
+#define SPAN_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// GCC/Clang need the ISA enabled per function, MSVC lets intrinsics through as-is
+#if defined(__GNUC__)||defined(__clang__)
+#define SPAN_TARGET(x) __attribute__((target(x)))
+#else
+#define SPAN_TARGET(x)
+#endif
+
+// Blend one 8 bit channel, exact divide by 255 with rounding.
+// The SIMD kernels use the same math so every kernel produces identical results.
+static inline uint32_t Span_BlendChannel(uint32_t s, uint32_t d, uint32_t a)
+{
+	uint32_t t=s*a+d*(255-a)+128;
+
+	return (t+(t>>8))>>8;
+}
+
+static void Span_Fill32_Scalar(uint32_t *Dst, uint32_t Count, uint32_t Color)
+{
+	for(uint32_t i=0;i<Count;i++)
+		Dst[i]=Color;
+}
+
+static void Span_Blend32_Scalar(uint32_t *Dst, uint32_t Count, uint32_t Color, uint32_t Alpha)
+{
+	for(uint32_t i=0;i<Count;i++)
+	{
+		uint32_t d=Dst[i];
+
+		Dst[i]=(Span_BlendChannel((Color>>0)&0xFF, (d>>0)&0xFF, Alpha)<<0)|
+			(Span_BlendChannel((Color>>8)&0xFF, (d>>8)&0xFF, Alpha)<<8)|
+			(Span_BlendChannel((Color>>16)&0xFF, (d>>16)&0xFF, Alpha)<<16)|
+			(Span_BlendChannel((Color>>24)&0xFF, (d>>24)&0xFF, Alpha)<<24);
+	}
+}
+
+#ifdef SPAN_X86
+static void Span_Fill32_SSE2(uint32_t *Dst, uint32_t Count, uint32_t Color)
+{
+	// Head, scalar until 16 byte aligned
+	while(Count&&((uintptr_t)Dst&15))
+	{
+		*Dst++=Color;
+		Count--;
+	}
+
+	__m128i c=_mm_set1_epi32((int32_t)Color);
+
+	// Body, 16 pixels per iteration, then 4
+	for(;Count>=16;Count-=16, Dst+=16)
+	{
+		_mm_store_si128((__m128i *)(Dst+0), c);
+		_mm_store_si128((__m128i *)(Dst+4), c);
+		_mm_store_si128((__m128i *)(Dst+8), c);
+		_mm_store_si128((__m128i *)(Dst+12), c);
+	}
+
+	for(;Count>=4;Count-=4, Dst+=4)
+		_mm_store_si128((__m128i *)Dst, c);
+
+	// Tail
+	while(Count--)
+		*Dst++=Color;
+}
+
+// Blends 4 pixels, s and ia are the pre-multiplied source (s*a+128) and inverse alpha (255-a) as 16 bit lanes.
+static inline __m128i Span_Blend4_SSE2(__m128i d, __m128i sa, __m128i ia)
+{
+	__m128i zero=_mm_setzero_si128();
+	__m128i lo=_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), ia), sa);
+	__m128i hi=_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), ia), sa);
+
+	lo=_mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+	hi=_mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+	return _mm_packus_epi16(lo, hi);
+}
+
+static void Span_Blend32_SSE2(uint32_t *Dst, uint32_t Count, uint32_t Color, uint32_t Alpha)
+{
+	while(Count&&((uintptr_t)Dst&15))
+	{
+		Span_Blend32_Scalar(Dst++, 1, Color, Alpha);
+		Count--;
+	}
+
+	__m128i s=_mm_unpacklo_epi8(_mm_set1_epi32((int32_t)Color), _mm_setzero_si128());
+	__m128i sa=_mm_add_epi16(_mm_mullo_epi16(s, _mm_set1_epi16((int16_t)Alpha)), _mm_set1_epi16(128));
+	__m128i ia=_mm_set1_epi16((int16_t)(255-Alpha));
+
+	for(;Count>=4;Count-=4, Dst+=4)
+		_mm_store_si128((__m128i *)Dst, Span_Blend4_SSE2(_mm_load_si128((__m128i *)Dst), sa, ia));
+
+	Span_Blend32_Scalar(Dst, Count, Color, Alpha);
+}
+
+SPAN_TARGET("avx2")
+static void Span_Fill32_AVX2(uint32_t *Dst, uint32_t Count, uint32_t Color)
+{
+	while(Count&&((uintptr_t)Dst&31))
+	{
+		*Dst++=Color;
+		Count--;
+	}
+
+	__m256i c=_mm256_set1_epi32((int32_t)Color);
+
+	for(;Count>=32;Count-=32, Dst+=32)
+	{
+		_mm256_store_si256((__m256i *)(Dst+0), c);
+		_mm256_store_si256((__m256i *)(Dst+8), c);
+		_mm256_store_si256((__m256i *)(Dst+16), c);
+		_mm256_store_si256((__m256i *)(Dst+24), c);
+	}
+
+	for(;Count>=8;Count-=8, Dst+=8)
+		_mm256_store_si256((__m256i *)Dst, c);
+
+	if(Count>=4)
+	{
+		_mm_store_si128((__m128i *)Dst, _mm256_castsi256_si128(c));
+		Dst+=4;
+		Count-=4;
+	}
+
+	_mm256_zeroupper();
+
+	while(Count--)
+		*Dst++=Color;
+}
+
+SPAN_TARGET("avx2")
+static void Span_Blend32_AVX2(uint32_t *Dst, uint32_t Count, uint32_t Color, uint32_t Alpha)
+{
+	while(Count&&((uintptr_t)Dst&31))
+	{
+		Span_Blend32_Scalar(Dst++, 1, Color, Alpha);
+		Count--;
+	}
+
+	__m256i zero=_mm256_setzero_si256();
+	__m256i s=_mm256_unpacklo_epi8(_mm256_set1_epi32((int32_t)Color), zero);
+	__m256i sa=_mm256_add_epi16(_mm256_mullo_epi16(s, _mm256_set1_epi16((int16_t)Alpha)), _mm256_set1_epi16(128));
+	__m256i ia=_mm256_set1_epi16((int16_t)(255-Alpha));
+
+	for(;Count>=8;Count-=8, Dst+=8)
+	{
+		__m256i d=_mm256_load_si256((__m256i *)Dst);
+		__m256i lo=_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), ia), sa);
+		__m256i hi=_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), ia), sa);
+
+		lo=_mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+		hi=_mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+
+		// Unpack/pack work per 128 bit lane, so the lane order round trips
+		_mm256_store_si256((__m256i *)Dst, _mm256_packus_epi16(lo, hi));
+	}
+
+	// Leave the upper halves clean for the non-VEX code we return to, short rows pay for the transition on every call
+	_mm256_zeroupper();
+
+	Span_Blend32_Scalar(Dst, Count, Color, Alpha);
+}
+#endif
+
+static const Span_Kernel_t Span_Kernels[SPAN_NUM_KERNEL]=
+{
+	[SPAN_KERNEL_SCALAR]={ "Scalar", Span_Fill32_Scalar, Span_Blend32_Scalar },
+#ifdef SPAN_X86
+	[SPAN_KERNEL_SSE2]={ "SSE2", Span_Fill32_SSE2, Span_Blend32_SSE2 },
+	[SPAN_KERNEL_AVX2]={ "AVX2", Span_Fill32_AVX2, Span_Blend32_AVX2 },
+#endif
+};
+
+// Active kernel, scalar until Span_Init picks something better
+static const Span_Kernel_t *Span_Kernel=&Span_Kernels[SPAN_KERNEL_SCALAR];
+
+#ifdef SPAN_X86
+static void Span_CPUID(uint32_t Regs[4], uint32_t Leaf, uint32_t SubLeaf)
+{
+#ifdef _MSC_VER
+	__cpuidex((int *)Regs, (int)Leaf, (int)SubLeaf);
+#else
+	__cpuid_count(Leaf, SubLeaf, Regs[0], Regs[1], Regs[2], Regs[3]);
+#endif
+}
+
+static uint64_t Span_XGETBV(void)
+{
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	uint32_t lo, hi;
+
+	__asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+
+	return ((uint64_t)hi<<32)|lo;
+#endif
+}
+#endif
+
+bool Span_IsKernelSupported(Span_KernelType Type)
+{
+	switch(Type)
+	{
+		case SPAN_KERNEL_SCALAR:
+			return true;
+
+#ifdef SPAN_X86
+		case SPAN_KERNEL_SSE2:
+		{
+			uint32_t Regs[4];
+
+			Span_CPUID(Regs, 1, 0);
+
+			return (Regs[3]&(1<<26))!=0;
+		}
+
+		case SPAN_KERNEL_AVX2:
+		{
+			uint32_t Regs[4];
+
+			Span_CPUID(Regs, 0, 0);
+
+			if(Regs[0]<7)
+				return false;
+
+			// Need AVX and OSXSAVE, and the OS has to be saving the YMM state
+			Span_CPUID(Regs, 1, 0);
+
+			if((Regs[2]&((1<<27)|(1<<28)))!=((1<<27)|(1<<28)))
+				return false;
+
+			if((Span_XGETBV()&6)!=6)
+				return false;
+
+			Span_CPUID(Regs, 7, 0);
+
+			return (Regs[1]&(1<<5))!=0;
+		}
+#endif
+
+		default:
+			return false;
+	}
+}
+
+// Picks the widest kernel the CPU supports.
+// Returns the selected kernel type.
+Span_KernelType Span_Init(void)
+{
+	for(int32_t Type=SPAN_NUM_KERNEL-1;Type>SPAN_KERNEL_SCALAR;Type--)
+	{
+		if(Span_SetKernel((Span_KernelType)Type))
+			return (Span_KernelType)Type;
+	}
+
+	Span_SetKernel(SPAN_KERNEL_SCALAR);
+
+	return SPAN_KERNEL_SCALAR;
+}
+
+bool Span_SetKernel(Span_KernelType Type)
+{
+	if(Type<0||Type>=SPAN_NUM_KERNEL||!Span_IsKernelSupported(Type))
+		return false;
+
+	Span_Kernel=&Span_Kernels[Type];
+
+	return true;
+}
+
+const Span_Kernel_t *Span_GetKernel(Span_KernelType Type)
+{
+	if(Type<0||Type>=SPAN_NUM_KERNEL||Span_Kernels[Type].Fill32==NULL)
+		return NULL;
+
+	return &Span_Kernels[Type];
+}
+
+const Span_Kernel_t *Span_GetActiveKernel(void)
+{
+	return Span_Kernel;
+}
+
+void Span_Row(uint8_t *Row, uint32_t Count, uint32_t BytesPerPixel, uint32_t Color)
+{
+	switch(BytesPerPixel)
+	{
+		case 4:
+			Span_Kernel->Fill32((uint32_t *)Row, Count, Color);
+			break;
+
+		case 3:
+		{
+			uint8_t b=(uint8_t)(Color), g=(uint8_t)(Color>>8), r=(uint8_t)(Color>>16);
+
+			for(uint32_t i=0;i<Count;i++, Row+=3)
+			{
+				Row[0]=b;
+				Row[1]=g;
+				Row[2]=r;
+			}
+			break;
+		}
+
+		case 2:
+		{
+			uint16_t *Dst=(uint16_t *)Row;
+
+			for(uint32_t i=0;i<Count;i++)
+				Dst[i]=(uint16_t)Color;
+			break;
+		}
+
+		case 1:
+			memset(Row, (uint8_t)Color, Count);
+			break;
+	}
+}
+
+void Span_BlendRow(uint8_t *Row, uint32_t Count, uint32_t BytesPerPixel, uint32_t Color, uint32_t Alpha)
+{
+	switch(BytesPerPixel)
+	{
+		case 4:
+			Span_Kernel->Blend32((uint32_t *)Row, Count, Color, Alpha);
+			break;
+
+		case 3:
+			for(uint32_t i=0;i<Count;i++, Row+=3)
+			{
+				Row[0]=(uint8_t)Span_BlendChannel((Color>>0)&0xFF, Row[0], Alpha);
+				Row[1]=(uint8_t)Span_BlendChannel((Color>>8)&0xFF, Row[1], Alpha);
+				Row[2]=(uint8_t)Span_BlendChannel((Color>>16)&0xFF, Row[2], Alpha);
+			}
+			break;
+
+		// Packed 8/16 bit formats can't be blended per byte, threshold instead
+		default:
+			if(Alpha>=128)
+				Span_Row(Row, Count, BytesPerPixel, Color);
+			break;
+	}
+}
+
+// Clips the inclusive rectangle against the target's clip rect.
+// Returns false if nothing is left.
+static bool Span_ClipRect(const RenderTarget_t *Target, int32_t *x1, int32_t *y1, int32_t *x2, int32_t *y2)
+{
+	int32_t minX=*x1<*x2?*x1:*x2, maxX=*x1<*x2?*x2:*x1;
+	int32_t minY=*y1<*y2?*y1:*y2, maxY=*y1<*y2?*y2:*y1;
+
+	if(minX<Target->ClipMinX)
+		minX=Target->ClipMinX;
+	if(minY<Target->ClipMinY)
+		minY=Target->ClipMinY;
+	if(maxX>Target->ClipMaxX)
+		maxX=Target->ClipMaxX;
+	if(maxY>Target->ClipMaxY)
+		maxY=Target->ClipMaxY;
+
+	*x1=minX;
+	*y1=minY;
+	*x2=maxX;
+	*y2=maxY;
+
+	return minX<=maxX&&minY<=maxY;
+}
+
+void Span_FillRect(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t Color)
+{
+	if(Target==NULL||Target->Base==NULL)
+		return;
+
+	// Clip once, everything after this is in bounds
+	if(!Span_ClipRect(Target, &x1, &y1, &x2, &y2))
+		return;
+
+	uint32_t Count=(uint32_t)(x2-x1+1);
+	uint8_t *Row=Target->Base+(intptr_t)y1*Target->Pitch+(intptr_t)x1*Target->BytesPerPixel;
+
+	Target->PixelsWritten+=(uint64_t)Count*(y2-y1+1);
+
+	for(int32_t y=y1;y<=y2;y++, Row+=Target->Pitch)
+		Span_Row(Row, Count, Target->BytesPerPixel, Color);
+}
+
+void Span_BlendRect(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t Color, uint32_t Alpha)
+{
+	if(Target==NULL||Target->Base==NULL||Alpha==0)
+		return;
+
+	if(Alpha>=255)
+	{
+		Span_FillRect(Target, x1, y1, x2, y2, Color);
+		return;
+	}
+
+	if(!Span_ClipRect(Target, &x1, &y1, &x2, &y2))
+		return;
+
+	uint32_t Count=(uint32_t)(x2-x1+1);
+	uint8_t *Row=Target->Base+(intptr_t)y1*Target->Pitch+(intptr_t)x1*Target->BytesPerPixel;
+
+	Target->PixelsWritten+=(uint64_t)Count*(y2-y1+1);
+
+	for(int32_t y=y1;y<=y2;y++, Row+=Target->Pitch)
+		Span_BlendRow(Row, Count, Target->BytesPerPixel, Color, Alpha);
+}
@@ -0,0 +1,42 @@
+#ifndef __SPAN_H__
+#define __SPAN_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "draw.h"
+
+typedef enum
+{
+	SPAN_KERNEL_SCALAR=0,
+	SPAN_KERNEL_SSE2,
+	SPAN_KERNEL_AVX2,
+	SPAN_NUM_KERNEL
+} Span_KernelType;
+
+// 32bpp row kernels, one set per instruction set
+typedef struct
+{
+	const char *Name;
+	void (*Fill32)(uint32_t *Dst, uint32_t Count, uint32_t Color);
+	void (*Blend32)(uint32_t *Dst, uint32_t Count, uint32_t Color, uint32_t Alpha);
+} Span_Kernel_t;
+
+// Selects the best kernel by CPUID, call once at start up.
+Span_KernelType Span_Init(void);
+bool Span_IsKernelSupported(Span_KernelType Type);
+bool Span_SetKernel(Span_KernelType Type);
+// Returns NULL if the kernel wasn't compiled in, used by the benchmarks to time each kernel directly.
+const Span_Kernel_t *Span_GetKernel(Span_KernelType Type);
+const Span_Kernel_t *Span_GetActiveKernel(void);
+
+// Writes Count packed pixels starting at Row.
+void Span_Row(uint8_t *Row, uint32_t Count, uint32_t BytesPerPixel, uint32_t Color);
+// Blends Count pixels starting at Row toward Color, Alpha is 0 to 255.
+void Span_BlendRow(uint8_t *Row, uint32_t Count, uint32_t BytesPerPixel, uint32_t Color, uint32_t Alpha);
+
+// Fills the inclusive rectangle (x1, y1)-(x2, y2), clipped once against the target's clip rect.
+// Coordinates may be given in any order and may lie off the surface.
+void Span_FillRect(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t Color);
+void Span_BlendRect(RenderTarget_t *Target, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t Color, uint32_t Alpha);
+
+#endif
@@ -1,52 +1,94 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <stdint.h>
-#include <ddraw.h>
+#include "../math/math.h"
+#include "../draw/draw.h"
 #include "font.h"
 
-void point(DDSURFACEDESC2 ddsd, uint32_t x, uint32_t y, float c[3]);
+// Prints Length characters as they are, no formatting or size limit
+void Font_PrintText(RenderTarget_t *Target, int32_t x, int32_t y, const char *Text, uint32_t Length)
+{
+	const char *ptr, *run, *end;
+	int32_t sx=x;
+	uint32_t Color=Draw_PackColor(Vec3b(1.0f));
+
+	if(Text==NULL)
+		return;
+
+	run=Text;
+	end=Text+Length;
+
+	// Each line (or tab separated piece of one) goes down as one glyph run
+	for(ptr=Text;;ptr++)
+	{
+		if(ptr==end||*ptr=='\n'||*ptr=='\r'||*ptr=='\t')
+		{
+			if(ptr>run)
+				glyphrun(Target, x, y, fontdata, FONT_WIDTH, FONT_HEIGHT, run, (uint32_t)(ptr-run), Color);
+
+			x+=(int32_t)(ptr-run)*FONT_WIDTH;
+			run=ptr+1;
+
+			if(ptr==end)
+				break;
+
+			if(*ptr=='\t')
+				x+=FONT_WIDTH*4;
+			else
+			{
+				x=sx;
+				y+=FONT_HEIGHT;
+			}
+		}
+	}
+}
 
-static void Font_PutChar(DDSURFACEDESC2 ddsd, uint32_t x, uint32_t y, char c)
+void Font_MeasureText(const char *Text, uint32_t Length, int32_t *Width, int32_t *Height)
 {
-	for(uint32_t j=0;j<FONT_HEIGHT;j++)
+	int32_t x=0, w=0, h=0;
+
+	if(Text!=NULL&&Length)
 	{
-		for(uint32_t i=0;i<FONT_WIDTH;i++)
+		h=FONT_HEIGHT;
+
+		// Same stepping as Font_PrintText, without the glyphs
+		for(uint32_t i=0;i<Length;i++)
 		{
-			if(fontdata[(c*FONT_HEIGHT)+j]&(0x80>>i))
-				point(ddsd, x+i, y+j, (float[]){ 1.0f, 1.0f, 1.0f });
+			if(Text[i]=='\n'||Text[i]=='\r')
+			{
+				x=0;
+				h+=FONT_HEIGHT;
+			}
+			else
+			{
+				x+=Text[i]=='\t'?FONT_WIDTH*4:FONT_WIDTH;
+				w=max(w, x);
+			}
 		}
 	}
+
+	if(Width)
+		*Width=w;
+
+	if(Height)
+		*Height=h;
 }
 
-void Font_Print(DDSURFACEDESC2 ddsd, uint32_t x, uint32_t y, const char *string, ...)
+void Font_Print(RenderTarget_t *Target, int32_t x, int32_t y, const char *string, ...)
 {
-	char *ptr, text[1024]; //Big enough for full screen.
+	char text[1024]; //Big enough for full screen.
 	va_list	ap;
-	int sx=x;
+	int Length;
 
 	if(string==NULL)
 		return;
 
 	va_start(ap, string);
-		vsnprintf(text, 1024, string, ap);
+		Length=vsnprintf(text, 1024, string, ap);
 	va_end(ap);
 
-	for(ptr=text;*ptr!='\0';ptr++)
-	{
-		if(*ptr=='\n'||*ptr=='\r')
-		{
-			x=sx;
-			y+=FONT_HEIGHT;
-			continue;
-		}
-
-		if(*ptr=='\t')
-		{
-			x+=FONT_WIDTH*4;
-			continue;
-		}
+	if(Length<0)
+		return;
 
-		Font_PutChar(ddsd, x, y, *ptr);
-		x+=FONT_WIDTH;
-	}
+	Font_PrintText(Target, x, y, text, (uint32_t)min(Length, 1023));
 }
@@ -2,9 +2,12 @@
 #define __FONT_H__
 
 #include <stdint.h>
-#include <ddraw.h>
+#include "../draw/draw.h"
 #include "font_6x10.h"
 
-void Font_Print(DDSURFACEDESC2 ddsd, uint32_t x, uint32_t y, const char *string, ...);
+void Font_Print(RenderTarget_t *Target, int32_t x, int32_t y, const char *string, ...);
+void Font_PrintText(RenderTarget_t *Target, int32_t x, int32_t y, const char *Text, uint32_t Length);
+// Size in pixels of what Font_PrintText would draw, lines and tabs included
+void Font_MeasureText(const char *Text, uint32_t Length, int32_t *Width, int32_t *Height);
 
 #endif
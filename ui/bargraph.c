@@ -3,36 +3,33 @@
 #include <stdio.h>
 #include "../math/math.h"
 #include "../utils/list.h"
+#include "../draw/draw.h"
 #include "ui.h"
 
 uint32_t UI_AddBarGraph(UI_t *UI, vec2 Position, vec2 Size, vec3 Color, const char *TitleText, bool Readonly, float Min, float Max, float Value)
 {
-	uint32_t ID=UI->IDBase++;
-
-	if(ID==UINT32_MAX||ID>=UI_HASHTABLE_MAX)
+	if(UI==NULL)
 		return UINT32_MAX;
 
 	UI_Control_t Control=
 	{
 		.Type=UI_CONTROL_BARGRAPH,
-		.ID=ID,
 		.Position=Position,
+		.Size=Size,
+		.PackedColor=Draw_PackColor(Color),
+		.Flags=UI_CONTROL_DIRTY|(Readonly?UI_CONTROL_READONLY:0)
+	};
+
+	UI_ControlData_t Data=
+	{
 		.Color=Color,
-		.BarGraph.Size=Size,
-		.BarGraph.Readonly=Readonly,
+		.Title=StringPool_Intern(&UI->Strings, TitleText),
 		.BarGraph.Min=Min,
 		.BarGraph.Max=Max,
 		.BarGraph.Value=Value
 	};
 
-	snprintf(Control.BarGraph.TitleText, UI_CONTROL_TITLETEXT_MAX, "%s", TitleText);
-
-	if(!List_Add(&UI->Controls, &Control))
-		return UINT32_MAX;
-
-	UI->Controls_Hashtable[ID]=List_GetPointer(&UI->Controls, List_GetCount(&UI->Controls)-1);
-
-	return ID;
+	return UI_AddControl(UI, &Control, &Data);
 }
 
 bool UI_UpdateBarGraph(UI_t *UI, uint32_t ID, vec2 Position, vec2 Size, vec3 Color, const char *TitleText, bool Readonly, float Min, float Max, float Value)
@@ -45,16 +42,24 @@ bool UI_UpdateBarGraph(UI_t *UI, uint32_t ID, vec2 Position, vec2 Size, vec3 Col
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_BARGRAPH)
 	{
+		UI_ControlData_t *Data=UI_GetControlData(UI, Control);
+
+		UI_InvalidateControl(UI, Control);
+
 		Control->Position=Position;
-		Control->Color=Color;
+		UI_SetControlColor(UI, Control, Color);
+
+		UI_SetControlTitle(UI, Control, TitleText);
+		Control->Size=Size;
+		Control->Flags=(Control->Flags&~UI_CONTROL_READONLY)|(Readonly?UI_CONTROL_READONLY:0);
+		Data->BarGraph.Min=Min;
+		Data->BarGraph.Max=Max;
+		Data->BarGraph.Value=Value;
 
-		snprintf(Control->BarGraph.TitleText, UI_CONTROL_TITLETEXT_MAX, "%s", TitleText);
-		Control->BarGraph.Size=Size;
-		Control->BarGraph.Readonly=Readonly;
-		Control->BarGraph.Min=Min;
-		Control->BarGraph.Max=Max;
-		Control->BarGraph.Value=Value;
+		if(Data->BarGraph.Binding)
+			*Data->BarGraph.Binding=Value;
 
+		UI_ReindexControl(UI, Control);
 		return true;
 	}
 
@@ -72,7 +77,10 @@ bool UI_UpdateBarGraphPosition(UI_t *UI, uint32_t ID, vec2 Position)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_BARGRAPH)
 	{
+		UI_InvalidateControl(UI, Control);
+
 		Control->Position=Position;
+		UI_ReindexControl(UI, Control);
 		return true;
 	}
 
@@ -90,7 +98,10 @@ bool UI_UpdateBarGraphSize(UI_t *UI, uint32_t ID, vec2 Size)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_BARGRAPH)
 	{
-		Control->Button.Size=Size;
+		UI_InvalidateControl(UI, Control);
+
+		Control->Size=Size;
+		UI_ReindexControl(UI, Control);
 		return true;
 	}
 
@@ -108,7 +119,7 @@ bool UI_UpdateBarGraphColor(UI_t *UI, uint32_t ID, vec3 Color)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_BARGRAPH)
 	{
-		Control->Color=Color;
+		UI_SetControlColor(UI, Control, Color);
 		return true;
 	}
 
@@ -126,7 +137,7 @@ bool UI_UpdateBarGraphTitleText(UI_t *UI, uint32_t ID, const char *TitleText)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_BARGRAPH)
 	{
-		snprintf(Control->BarGraph.TitleText, UI_CONTROL_TITLETEXT_MAX, "%s", TitleText);
+		UI_SetControlTitle(UI, Control, TitleText);
 		return true;
 	}
 
@@ -144,7 +155,8 @@ bool UI_UpdateBarGraphReadonly(UI_t *UI, uint32_t ID, bool Readonly)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_BARGRAPH)
 	{
-		Control->BarGraph.Readonly=Readonly;
+		Control->Flags=(Control->Flags&~UI_CONTROL_READONLY)|(Readonly?UI_CONTROL_READONLY:0);
+		UI_InvalidateHits(UI);
 		return true;
 	}
 
@@ -162,7 +174,11 @@ bool UI_UpdateBarGraphMin(UI_t *UI, uint32_t ID, float Min)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_BARGRAPH)
 	{
-		Control->BarGraph.Min=Min;
+		UI_ControlData_t *Data=UI_GetControlData(UI, Control);
+
+		UI_InvalidateControl(UI, Control);
+
+		Data->BarGraph.Min=Min;
 		return true;
 	}
 
@@ -180,7 +196,11 @@ bool UI_UpdateBarGraphMax(UI_t *UI, uint32_t ID, float Max)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_BARGRAPH)
 	{
-		Control->BarGraph.Max=Max;
+		UI_ControlData_t *Data=UI_GetControlData(UI, Control);
+
+		UI_InvalidateControl(UI, Control);
+
+		Data->BarGraph.Max=Max;
 		return true;
 	}
 
@@ -198,7 +218,15 @@ bool UI_UpdateBarGraphValue(UI_t *UI, uint32_t ID, float Value)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_BARGRAPH)
 	{
-		Control->BarGraph.Value=Value;
+		UI_ControlData_t *Data=UI_GetControlData(UI, Control);
+
+		if(Value!=Data->BarGraph.Value)
+			UI_InvalidateControl(UI, Control);
+
+		Data->BarGraph.Value=Value;
+
+		if(Data->BarGraph.Binding)
+			*Data->BarGraph.Binding=Value;
 		return true;
 	}
 
@@ -215,7 +243,7 @@ float UI_GetBarGraphMin(UI_t *UI, uint32_t ID)
 	UI_Control_t *Control=UI_FindControlByID(UI, ID);
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_BARGRAPH)
-		return Control->BarGraph.Min;
+		return UI_GetControlData(UI, Control)->BarGraph.Min;
 
 	// Not found
 	return NAN;
@@ -230,7 +258,7 @@ float UI_GetBarGraphMax(UI_t *UI, uint32_t ID)
 	UI_Control_t *Control=UI_FindControlByID(UI, ID);
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_BARGRAPH)
-		return Control->BarGraph.Max;
+		return UI_GetControlData(UI, Control)->BarGraph.Max;
 
 	// Not found
 	return NAN;
@@ -244,8 +272,13 @@ float UI_GetBarGraphValue(UI_t *UI, uint32_t ID)
 	// Search list
 	UI_Control_t *Control=UI_FindControlByID(UI, ID);
 
+	// Bound storage may have changed since the last sync
 	if(Control!=NULL&&Control->Type==UI_CONTROL_BARGRAPH)
-		return Control->BarGraph.Value;
+	{
+		const UI_ControlData_t *Data=UI_GetControlData(UI, Control);
+
+		return Data->BarGraph.Binding?*Data->BarGraph.Binding:Data->BarGraph.Value;
+	}
 
 	// Not found
 	return NAN;
@@ -260,8 +293,43 @@ float *UI_GetBarGraphValuePointer(UI_t *UI, uint32_t ID)
 	UI_Control_t *Control=UI_FindControlByID(UI, ID);
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_BARGRAPH)
-		return &Control->BarGraph.Value;
+	{
+		UI_ControlData_t *Data=UI_GetControlData(UI, Control);
+
+		return Data->BarGraph.Binding?Data->BarGraph.Binding:&Data->BarGraph.Value;
+	}
 
 	// Not found
 	return NULL;
 }
+
+bool UI_BindBarGraphValue(UI_t *UI, uint32_t ID, float *Value)
+{
+	if(UI==NULL||ID==UINT32_MAX)
+		return false;
+
+	// Search list
+	UI_Control_t *Control=UI_FindControlByID(UI, ID);
+
+	if(Control!=NULL&&Control->Type==UI_CONTROL_BARGRAPH)
+	{
+		// Unbinding leaves the entry for UI_SyncBindings to drop
+		if(Value!=NULL&&!UI_AddBinding(UI, Control))
+			return false;
+
+		UI_ControlData_t *Data=UI_GetControlData(UI, Control);
+
+		Data->BarGraph.Binding=Value;
+
+		if(Value!=NULL&&*Value!=Data->BarGraph.Value)
+		{
+			UI_InvalidateControl(UI, Control);
+			Data->BarGraph.Value=*Value;
+		}
+
+		return true;
+	}
+
+	// Not found
+	return false;
+}
@@ -0,0 +1,333 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "../math/math.h"
+#include "../utils/list.h"
+#include "../draw/draw.h"
+#include "ui.h"
+
+// Start queuing writes, anything queued by an uncommitted batch is dropped
+bool UI_BeginBatch(UI_t *UI)
+{
+	if(UI==NULL)
+		return false;
+
+	UI->NumBatchWrites=0;
+	UI->Batching=true;
+
+	return true;
+}
+
+// Returns the next write to fill in, or NULL if it can't be queued
+static inline UI_BatchWrite_t *UI_QueueBatchWrite(UI_t *UI, uint32_t ID, UI_Property Property, UI_BatchValueType ValueType)
+{
+	if(UI==NULL||!UI->Batching||ID==UINT32_MAX||Property>=UI_NUM_PROPERTY)
+		return NULL;
+
+	if(UI->NumBatchWrites>=UI->MaxBatchWrites)
+	{
+		const uint32_t MaxWrites=max(UI->MaxBatchWrites*2, 64);
+		UI_BatchWrite_t *Writes=(UI_BatchWrite_t *)realloc(UI->BatchWrites, sizeof(UI_BatchWrite_t)*MaxWrites);
+
+		if(Writes==NULL)
+			return NULL;
+
+		UI->BatchWrites=Writes;
+		UI->MaxBatchWrites=MaxWrites;
+	}
+
+	UI_BatchWrite_t *Write=&UI->BatchWrites[UI->NumBatchWrites++];
+
+	Write->ID=ID;
+	Write->Property=(uint8_t)Property;
+	Write->ValueType=(uint8_t)ValueType;
+
+	return Write;
+}
+
+bool UI_BatchSetFloat(UI_t *UI, uint32_t ID, UI_Property Property, float Value)
+{
+	UI_BatchWrite_t *Write=UI_QueueBatchWrite(UI, ID, Property, UI_BATCH_FLOAT);
+
+	if(Write==NULL)
+		return false;
+
+	Write->Float=Value;
+
+	return true;
+}
+
+bool UI_BatchSetBool(UI_t *UI, uint32_t ID, UI_Property Property, bool Value)
+{
+	UI_BatchWrite_t *Write=UI_QueueBatchWrite(UI, ID, Property, UI_BATCH_BOOL);
+
+	if(Write==NULL)
+		return false;
+
+	Write->Bool=Value;
+
+	return true;
+}
+
+bool UI_BatchSetVec2(UI_t *UI, uint32_t ID, UI_Property Property, vec2 Value)
+{
+	UI_BatchWrite_t *Write=UI_QueueBatchWrite(UI, ID, Property, UI_BATCH_VEC2);
+
+	if(Write==NULL)
+		return false;
+
+	Write->Vec2=Value;
+
+	return true;
+}
+
+bool UI_BatchSetVec3(UI_t *UI, uint32_t ID, UI_Property Property, vec3 Value)
+{
+	UI_BatchWrite_t *Write=UI_QueueBatchWrite(UI, ID, Property, UI_BATCH_VEC3);
+
+	if(Write==NULL)
+		return false;
+
+	Write->Vec3=Value;
+
+	return true;
+}
+
+// LSD radix sort on the list index in the high half, only as many byte passes as the largest index needs.
+// Each pass is stable, so keys for the same control stay in queue order. Returns whichever buffer ends up sorted.
+static uint64_t *UI_SortBatchKeys(uint64_t *Keys, uint64_t *Temp, uint32_t Count, uint32_t MaxIndex)
+{
+	for(uint32_t Shift=32;Shift<64&&(MaxIndex>>(Shift-32))!=0;Shift+=8)
+	{
+		uint32_t Offsets[256]={ 0 };
+
+		for(uint32_t i=0;i<Count;i++)
+			Offsets[(Keys[i]>>Shift)&0xFF]++;
+
+		for(uint32_t i=0, Sum=0;i<256;i++)
+		{
+			uint32_t Digit=Offsets[i];
+
+			Offsets[i]=Sum;
+			Sum+=Digit;
+		}
+
+		for(uint32_t i=0;i<Count;i++)
+			Temp[Offsets[(Keys[i]>>Shift)&0xFF]++]=Keys[i];
+
+		uint64_t *Swap=Keys;
+
+		Keys=Temp;
+		Temp=Swap;
+	}
+
+	return Keys;
+}
+
+// Applies one write if it fits the control, flagging whether it changed how it looks or where it can be hit
+static bool UI_ApplyBatchWrite(UI_Control_t *Control, UI_ControlData_t *Data, const UI_BatchWrite_t *Write, bool *Changed, bool *Moved)
+{
+	switch(Write->Property)
+	{
+		case UI_PROPERTY_POSITION:
+			if(Write->ValueType!=UI_BATCH_VEC2)
+				return false;
+
+			if(Write->Vec2.x!=Control->Position.x||Write->Vec2.y!=Control->Position.y)
+			{
+				Control->Position=Write->Vec2;
+				*Changed=*Moved=true;
+			}
+			return true;
+
+		case UI_PROPERTY_SIZE:
+			if(Write->ValueType!=UI_BATCH_VEC2||(Control->Type!=UI_CONTROL_BUTTON&&Control->Type!=UI_CONTROL_BARGRAPH&&Control->Type!=UI_CONTROL_SPRITE&&Control->Type!=UI_CONTROL_PANEL))
+				return false;
+
+			if(Write->Vec2.x!=Control->Size.x||Write->Vec2.y!=Control->Size.y)
+			{
+				Control->Size=Write->Vec2;
+				*Changed=*Moved=true;
+			}
+			return true;
+
+		case UI_PROPERTY_RADIUS:
+			if(Write->ValueType!=UI_BATCH_FLOAT||(Control->Type!=UI_CONTROL_CHECKBOX&&Control->Type!=UI_CONTROL_CURSOR))
+				return false;
+
+			if(Write->Float!=Control->Radius)
+			{
+				Control->Radius=Write->Float;
+				*Changed=*Moved=true;
+			}
+			return true;
+
+		case UI_PROPERTY_COLOR:
+		{
+			if(Write->ValueType!=UI_BATCH_VEC3)
+				return false;
+
+			const uint32_t PackedColor=Draw_PackColor(Write->Vec3);
+
+			if(PackedColor!=Control->PackedColor)
+				*Changed=true;
+
+			Data->Color=Write->Vec3;
+			Control->PackedColor=PackedColor;
+
+			if(Data->ColorBinding)
+				*Data->ColorBinding=Write->Vec3;
+			return true;
+		}
+
+		case UI_PROPERTY_VALUE:
+			if(Control->Type==UI_CONTROL_BARGRAPH&&Write->ValueType==UI_BATCH_FLOAT)
+			{
+				if(Write->Float!=Data->BarGraph.Value)
+				{
+					Data->BarGraph.Value=Write->Float;
+					*Changed=true;
+				}
+
+				if(Data->BarGraph.Binding)
+					*Data->BarGraph.Binding=Write->Float;
+				return true;
+			}
+
+			if(Control->Type==UI_CONTROL_CHECKBOX&&Write->ValueType==UI_BATCH_BOOL)
+			{
+				if(Write->Bool!=Data->CheckBox.Value)
+				{
+					Data->CheckBox.Value=Write->Bool;
+					*Changed=true;
+				}
+
+				if(Data->CheckBox.Binding)
+					*Data->CheckBox.Binding=Write->Bool;
+				return true;
+			}
+			return false;
+
+		case UI_PROPERTY_MIN:
+		case UI_PROPERTY_MAX:
+		{
+			if(Write->ValueType!=UI_BATCH_FLOAT||Control->Type!=UI_CONTROL_BARGRAPH)
+				return false;
+
+			float *Limit=Write->Property==UI_PROPERTY_MIN?&Data->BarGraph.Min:&Data->BarGraph.Max;
+
+			if(Write->Float!=*Limit)
+			{
+				*Limit=Write->Float;
+				*Changed=true;
+			}
+			return true;
+		}
+
+		// Doesn't change how it's drawn, only whether it takes the cursor
+		case UI_PROPERTY_READONLY:
+			if(Write->ValueType!=UI_BATCH_BOOL||Control->Type!=UI_CONTROL_BARGRAPH)
+				return false;
+
+			// Reindexing drops cached hits, which is all this needs
+			Control->Flags=(Control->Flags&~UI_CONTROL_READONLY)|(Write->Bool?UI_CONTROL_READONLY:0);
+			*Moved=true;
+			return true;
+
+		case UI_PROPERTY_ROTATION:
+			if(Write->ValueType!=UI_BATCH_FLOAT||Control->Type!=UI_CONTROL_SPRITE)
+				return false;
+
+			if(Write->Float!=Data->Sprite.Rotation)
+			{
+				Data->Sprite.Rotation=Write->Float;
+				*Changed=true;
+			}
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+uint32_t UI_CommitBatch(UI_t *UI)
+{
+	if(UI==NULL||!UI->Batching)
+		return 0;
+
+	UI->Batching=false;
+
+	const UI_BatchWrite_t *Writes=UI->BatchWrites;
+	const uint32_t Count=UI->NumBatchWrites;
+	const UI_Slot_t *Slots=(const UI_Slot_t *)List_GetBufferPointer(&UI->Slots);
+	const uint32_t NumSlots=(uint32_t)List_GetCount(&UI->Slots);
+	UI_Control_t *Controls=(UI_Control_t *)List_GetBufferPointer(&UI->Controls);
+	UI_ControlData_t *ControlData=(UI_ControlData_t *)List_GetBufferPointer(&UI->ControlData);
+	const uint32_t NumControls=(uint32_t)List_GetCount(&UI->Controls);
+	uint32_t Live=0, MaxIndex=0, Applied=0;
+
+	// Keys and the sort's second buffer
+	if(UI->BatchScratchSize<Count*2)
+	{
+		uint64_t *Scratch=(uint64_t *)realloc(UI->BatchScratch, sizeof(uint64_t)*Count*2);
+
+		if(Scratch==NULL)
+		{
+			UI->NumBatchWrites=0;
+			return 0;
+		}
+
+		UI->BatchScratch=Scratch;
+		UI->BatchScratchSize=Count*2;
+	}
+
+	uint64_t *Keys=UI->BatchScratch;
+
+	// Only the slots are read here, the controls themselves are left for the in order pass below.
+	// Key is the list index, then the queue position so writes to the same control stay in order.
+	for(uint32_t i=0;i<Count;i++)
+	{
+		const uint32_t SlotIndex=Writes[i].ID&UI_ID_INDEX_MASK;
+
+		if(SlotIndex>=NumSlots)
+			continue;
+
+		const UI_Slot_t *Slot=&Slots[SlotIndex];
+
+		if(Slot->Generation!=Writes[i].ID>>UI_ID_INDEX_BITS||Slot->Index>=NumControls)
+			continue;
+
+		Keys[Live++]=((uint64_t)Slot->Index<<32)|i;
+		MaxIndex=max(MaxIndex, Slot->Index);
+	}
+
+	Keys=UI_SortBatchKeys(Keys, UI->BatchScratch+Count, Live, MaxIndex);
+
+	for(uint32_t i=0;i<Live;)
+	{
+		const uint32_t Index=(uint32_t)(Keys[i]>>32);
+		UI_Control_t *Control=&Controls[Index];
+		UI_ControlData_t *Data=&ControlData[Index];
+		bool Changed=false, Moved=false;
+
+		for(;i<Live&&(uint32_t)(Keys[i]>>32)==Index;i++)
+		{
+			const UI_BatchWrite_t *Write=&Writes[(uint32_t)Keys[i]];
+
+			// A free slot's index is the next free one, so check it really landed on this control
+			if(Control->ID==Write->ID)
+				Applied+=UI_ApplyBatchWrite(Control, Data, Write, &Changed, &Moved);
+		}
+
+		// Damages the bounds it was last drawn with, which none of the writes touched, so once covers them all
+		if(Changed)
+			UI_InvalidateControl(UI, Control);
+
+		if(Moved)
+			UI_ReindexControl(UI, Control);
+	}
+
+	UI->NumBatchWrites=0;
+
+	return Applied;
+}
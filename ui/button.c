@@ -3,35 +3,33 @@
 #include <stdio.h>
 #include "../math/math.h"
 #include "../utils/list.h"
+#include "../draw/draw.h"
 #include "ui.h"
 
 // Add a button to the UI.
 // Returns an ID, or UINT32_MAX on failure.
 uint32_t UI_AddButton(UI_t *UI, vec2 Position, vec2 Size, vec3 Color, const char *TitleText, UIControlCallback Callback)
 {
-	uint32_t ID=UI->IDBase++;
-
-	if(ID==UINT32_MAX||ID>=UI_HASHTABLE_MAX)
+	if(UI==NULL)
 		return UINT32_MAX;
 
 	UI_Control_t Control=
 	{
 		.Type=UI_CONTROL_BUTTON,
-		.ID=ID,
 		.Position=Position,
+		.Size=Size,
+		.PackedColor=Draw_PackColor(Color),
+		.Flags=UI_CONTROL_DIRTY
+	};
+
+	UI_ControlData_t Data=
+	{
 		.Color=Color,
-		.Button.Size=Size,
+		.Title=StringPool_Intern(&UI->Strings, TitleText),
 		.Button.Callback=Callback
 	};
 
-	snprintf(Control.Button.TitleText, UI_CONTROL_TITLETEXT_MAX, "%s", TitleText);
-
-	if(!List_Add(&UI->Controls, &Control))
-		return UINT32_MAX;
-
-	UI->Controls_Hashtable[ID]=List_GetPointer(&UI->Controls, List_GetCount(&UI->Controls)-1);
-
-	return ID;
+	return UI_AddControl(UI, &Control, &Data);
 }
 
 // Update UI button parameters.
@@ -47,13 +45,18 @@ bool UI_UpdateButton(UI_t *UI, uint32_t ID, vec2 Position, vec2 Size, vec3 Color
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_BUTTON)
 	{
+		UI_ControlData_t *Data=UI_GetControlData(UI, Control);
+
+		UI_InvalidateControl(UI, Control);
+
 		Control->Position=Position;
-		Control->Color=Color;
+		UI_SetControlColor(UI, Control, Color);
 
-		snprintf(Control->Button.TitleText, UI_CONTROL_TITLETEXT_MAX, "%s", TitleText);
-		Control->Button.Size=Size;
-		Control->Button.Callback=Callback;
+		UI_SetControlTitle(UI, Control, TitleText);
+		Control->Size=Size;
+		Data->Button.Callback=Callback;
 
+		UI_ReindexControl(UI, Control);
 		return true;
 	}
 
@@ -71,7 +74,10 @@ bool UI_UpdateButtonPosition(UI_t *UI, uint32_t ID, vec2 Position)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_BUTTON)
 	{
+		UI_InvalidateControl(UI, Control);
+
 		Control->Position=Position;
+		UI_ReindexControl(UI, Control);
 		return true;
 	}
 
@@ -89,7 +95,10 @@ bool UI_UpdateButtonSize(UI_t *UI, uint32_t ID, vec2 Size)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_BUTTON)
 	{
-		Control->Button.Size=Size;
+		UI_InvalidateControl(UI, Control);
+
+		Control->Size=Size;
+		UI_ReindexControl(UI, Control);
 		return true;
 	}
 
@@ -107,7 +116,7 @@ bool UI_UpdateButtonColor(UI_t *UI, uint32_t ID, vec3 Color)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_BUTTON)
 	{
-		Control->Color=Color;
+		UI_SetControlColor(UI, Control, Color);
 		return true;
 	}
 
@@ -125,7 +134,7 @@ bool UI_UpdateButtonTitleText(UI_t *UI, uint32_t ID, const char *TitleText)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_BUTTON)
 	{
-		snprintf(Control->Button.TitleText, UI_CONTROL_TITLETEXT_MAX, "%s", TitleText);
+		UI_SetControlTitle(UI, Control, TitleText);
 		return true;
 	}
 
@@ -143,7 +152,29 @@ bool UI_UpdateButtonCallback(UI_t *UI, uint32_t ID, UIControlCallback Callback)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_BUTTON)
 	{
-		Control->Button.Callback=Callback;
+		UI_ControlData_t *Data=UI_GetControlData(UI, Control);
+
+		Data->Button.Callback=Callback;
+		return true;
+	}
+
+	// Not found
+	return false;
+}
+
+bool UI_UpdateButtonCallbackData(UI_t *UI, uint32_t ID, void *CallbackData)
+{
+	if(UI==NULL||ID==UINT32_MAX)
+		return false;
+
+	// Search list
+	UI_Control_t *Control=UI_FindControlByID(UI, ID);
+
+	if(Control!=NULL&&Control->Type==UI_CONTROL_BUTTON)
+	{
+		UI_ControlData_t *Data=UI_GetControlData(UI, Control);
+
+		Data->Button.CallbackData=CallbackData;
 		return true;
 	}
 
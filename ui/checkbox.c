@@ -3,35 +3,33 @@
 #include <stdio.h>
 #include "../math/math.h"
 #include "../utils/list.h"
+#include "../draw/draw.h"
 #include "ui.h"
 
 // Add a checkbox to the UI.
 // Returns an ID, or UINT32_MAX on failure.
 uint32_t UI_AddCheckBox(UI_t *UI, vec2 Position, float Radius, vec3 Color, const char *TitleText, bool Value)
 {
-	uint32_t ID=UI->IDBase++;
-
-	if(ID==UINT32_MAX||ID>=UI_HASHTABLE_MAX)
+	if(UI==NULL)
 		return UINT32_MAX;
 
 	UI_Control_t Control=
 	{
 		.Type=UI_CONTROL_CHECKBOX,
-		.ID=ID,
 		.Position=Position,
+		.Radius=Radius,
+		.PackedColor=Draw_PackColor(Color),
+		.Flags=UI_CONTROL_DIRTY
+	};
+
+	UI_ControlData_t Data=
+	{
 		.Color=Color,
-		.CheckBox.Radius=Radius,
+		.Title=StringPool_Intern(&UI->Strings, TitleText),
 		.CheckBox.Value=Value
 	};
 
-	snprintf(Control.CheckBox.TitleText, UI_CONTROL_TITLETEXT_MAX, "%s", TitleText);
-
-	if(!List_Add(&UI->Controls, &Control))
-		return UINT32_MAX;
-
-	UI->Controls_Hashtable[ID]=List_GetPointer(&UI->Controls, List_GetCount(&UI->Controls)-1);
-
-	return ID;
+	return UI_AddControl(UI, &Control, &Data);
 }
 
 // Update UI checkbox parameters.
@@ -47,13 +45,21 @@ bool UI_UpdateCheckBox(UI_t *UI, uint32_t ID, vec2 Position, float Radius, vec3
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_CHECKBOX)
 	{
+		UI_ControlData_t *Data=UI_GetControlData(UI, Control);
+
+		UI_InvalidateControl(UI, Control);
+
 		Control->Position=Position;
-		Control->Color=Color;
+		UI_SetControlColor(UI, Control, Color);
 
-		snprintf(Control->CheckBox.TitleText, UI_CONTROL_TITLETEXT_MAX, "%s", TitleText);
-		Control->CheckBox.Radius=Radius;
-		Control->CheckBox.Value=Value;
+		UI_SetControlTitle(UI, Control, TitleText);
+		Control->Radius=Radius;
+		Data->CheckBox.Value=Value;
 
+		if(Data->CheckBox.Binding)
+			*Data->CheckBox.Binding=Value;
+
+		UI_ReindexControl(UI, Control);
 		return true;
 	}
 
@@ -71,7 +77,10 @@ bool UI_UpdateCheckBoxPosition(UI_t *UI, uint32_t ID, vec2 Position)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_CHECKBOX)
 	{
+		UI_InvalidateControl(UI, Control);
+
 		Control->Position=Position;
+		UI_ReindexControl(UI, Control);
 		return true;
 	}
 
@@ -89,7 +98,10 @@ bool UI_UpdateCheckBoxRadius(UI_t *UI, uint32_t ID, float Radius)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_CHECKBOX)
 	{
-		Control->CheckBox.Radius=Radius;
+		UI_InvalidateControl(UI, Control);
+
+		Control->Radius=Radius;
+		UI_ReindexControl(UI, Control);
 		return true;
 	}
 
@@ -107,7 +119,7 @@ bool UI_UpdateCheckBoxColor(UI_t *UI, uint32_t ID, vec3 Color)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_CHECKBOX)
 	{
-		Control->Color=Color;
+		UI_SetControlColor(UI, Control, Color);
 		return true;
 	}
 
@@ -125,7 +137,7 @@ bool UI_UpdateCheckBoxTitleText(UI_t *UI, uint32_t ID, const char *TitleText)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_CHECKBOX)
 	{
-		snprintf(Control->CheckBox.TitleText, UI_CONTROL_TITLETEXT_MAX, "%s", TitleText);
+		UI_SetControlTitle(UI, Control, TitleText);
 		return true;
 	}
 
@@ -143,7 +155,15 @@ bool UI_UpdateCheckBoxValue(UI_t *UI, uint32_t ID, bool Value)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_CHECKBOX)
 	{
-		Control->CheckBox.Value=Value;
+		UI_ControlData_t *Data=UI_GetControlData(UI, Control);
+
+		if(Value!=Data->CheckBox.Value)
+			UI_InvalidateControl(UI, Control);
+
+		Data->CheckBox.Value=Value;
+
+		if(Data->CheckBox.Binding)
+			*Data->CheckBox.Binding=Value;
 		return true;
 	}
 
@@ -152,20 +172,52 @@ bool UI_UpdateCheckBoxValue(UI_t *UI, uint32_t ID, bool Value)
 }
 
 // Get the value of a checkbox by ID
-// Returns false on error, should this return by pointer instead or just outright get a pointer to control's value variable?
+// Returns false on error, UI_BindCheckBoxValue saves looking it up every frame
 bool UI_GetCheckBoxValue(UI_t *UI, uint32_t ID)
 {
 	if(UI==NULL||ID==UINT32_MAX)
 		return false;
 
 	// Search list
-	for(uint32_t i=0;i<List_GetCount(&UI->Controls);i++)
+	UI_Control_t *Control=UI_FindControlByID(UI, ID);
+
+	// Bound storage may have changed since the last sync
+	if(Control!=NULL&&Control->Type==UI_CONTROL_CHECKBOX)
 	{
-		UI_Control_t *Control=(UI_Control_t *)List_GetPointer(&UI->Controls, i);
+		const UI_ControlData_t *Data=UI_GetControlData(UI, Control);
 
-		// Check for matching ID and type
-		if(Control->ID==ID&&Control->Type==UI_CONTROL_CHECKBOX)
-			return Control->CheckBox.Value;
+		return Data->CheckBox.Binding?*Data->CheckBox.Binding:Data->CheckBox.Value;
+	}
+
+	// Not found
+	return false;
+}
+
+bool UI_BindCheckBoxValue(UI_t *UI, uint32_t ID, bool *Value)
+{
+	if(UI==NULL||ID==UINT32_MAX)
+		return false;
+
+	// Search list
+	UI_Control_t *Control=UI_FindControlByID(UI, ID);
+
+	if(Control!=NULL&&Control->Type==UI_CONTROL_CHECKBOX)
+	{
+		// Unbinding leaves the entry for UI_SyncBindings to drop
+		if(Value!=NULL&&!UI_AddBinding(UI, Control))
+			return false;
+
+		UI_ControlData_t *Data=UI_GetControlData(UI, Control);
+
+		Data->CheckBox.Binding=Value;
+
+		if(Value!=NULL&&*Value!=Data->CheckBox.Value)
+		{
+			UI_InvalidateControl(UI, Control);
+			Data->CheckBox.Value=*Value;
+		}
+
+		return true;
 	}
 
 	// Not found
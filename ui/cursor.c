@@ -3,32 +3,28 @@
 #include <stdio.h>
 #include "../math/math.h"
 #include "../utils/list.h"
+#include "../draw/draw.h"
 #include "ui.h"
 
 // Add a cursor to the UI.
 // Returns an ID, or UINT32_MAX on failure.
 uint32_t UI_AddCursor(UI_t *UI, vec2 Position, float Radius, vec3 Color)
 {
-	uint32_t ID=UI->IDBase++;
-
-	if(ID==UINT32_MAX||ID>=UI_HASHTABLE_MAX)
-		return UINT32_MAX;
-
 	UI_Control_t Control=
 	{
 		.Type=UI_CONTROL_CURSOR,
-		.ID=ID,
 		.Position=Position,
-		.Color=Color,
-		.Cursor.Radius=Radius,
+		.Radius=Radius,
+		.PackedColor=Draw_PackColor(Color),
+		.Flags=UI_CONTROL_DIRTY
 	};
 
-	if(!List_Add(&UI->Controls, &Control))
-		return UINT32_MAX;
-
-	UI->Controls_Hashtable[ID]=List_GetPointer(&UI->Controls, List_GetCount(&UI->Controls)-1);
+	UI_ControlData_t Data=
+	{
+		.Color=Color
+	};
 
-	return ID;
+	return UI_AddControl(UI, &Control, &Data);
 }
 
 // Update UI cursor parameters.
@@ -44,10 +40,12 @@ bool UI_UpdateCursor(UI_t *UI, uint32_t ID, vec2 Position, float Radius, vec3 Co
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_CURSOR)
 	{
+		UI_InvalidateControl(UI, Control);
+
 		Control->Position=Position;
-		Control->Color=Color;
+		UI_SetControlColor(UI, Control, Color);
 
-		Control->Cursor.Radius=Radius;
+		Control->Radius=Radius;
 
 		return true;
 	}
@@ -66,6 +64,8 @@ bool UI_UpdateCursorPosition(UI_t *UI, uint32_t ID, vec2 Position)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_CURSOR)
 	{
+		UI_InvalidateControl(UI, Control);
+
 		Control->Position=Position;
 		return true;
 	}
@@ -84,7 +84,9 @@ bool UI_UpdateCursorRadius(UI_t *UI, uint32_t ID, float Radius)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_CURSOR)
 	{
-		Control->Cursor.Radius=Radius;
+		UI_InvalidateControl(UI, Control);
+
+		Control->Radius=Radius;
 		return true;
 	}
 
@@ -102,7 +104,7 @@ bool UI_UpdateCursorColor(UI_t *UI, uint32_t ID, vec3 Color)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_CURSOR)
 	{
-		Control->Color=Color;
+		UI_SetControlColor(UI, Control, Color);
 		return true;
 	}
 
@@ -0,0 +1,95 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../math/math.h"
+#include "../utils/list.h"
+#include "../utils/clock.h"
+#include "ui.h"
+
+bool UI_QueueEvent(UI_t *UI, uint32_t ID, UI_EventType Type, UIControlCallback Callback, void *Data)
+{
+	if(UI==NULL||Type>=UI_NUM_EVENT||Callback==NULL)
+		return false;
+
+	UI_Event_t Event=
+	{
+		.ID=ID,
+		.Type=Type,
+		.Callback=Callback,
+		.Data=Data
+	};
+
+	return List_Add(&UI->Events, &Event);
+}
+
+bool UI_HasPendingEvents(const UI_t *UI)
+{
+	if(UI==NULL)
+		return false;
+
+	return UI->NextEvent<List_GetCount((List_t *)&UI->Events);
+}
+
+// Once everything has been taken the queue starts over from the front. Anything left is moved down once
+// most of the list has been taken, so a queue that keeps spilling over doesn't keep growing.
+static void UI_TrimEvents(UI_t *UI)
+{
+	const uint32_t Count=(uint32_t)List_GetCount(&UI->Events);
+
+	if(UI->NextEvent>=Count)
+	{
+		List_Clear(&UI->Events);
+		UI->NextEvent=0;
+	}
+	else if(UI->NextEvent*2>=Count)
+	{
+		UI_Event_t *Events=(UI_Event_t *)List_GetBufferPointer(&UI->Events);
+		const uint32_t Left=Count-UI->NextEvent;
+
+		memmove(Events, Events+UI->NextEvent, Left*sizeof(UI_Event_t));
+
+		// From the end, nothing shifts
+		for(uint32_t i=Count;i>Left;i--)
+			List_Del(&UI->Events, i-1);
+
+		UI->NextEvent=0;
+	}
+}
+
+bool UI_PopEvent(UI_t *UI, UI_Event_t *Event)
+{
+	if(!UI_HasPendingEvents(UI)||Event==NULL)
+		return false;
+
+	List_GetCopy(&UI->Events, UI->NextEvent++, Event);
+	UI_TrimEvents(UI);
+
+	return true;
+}
+
+uint32_t UI_DispatchEvents(UI_t *UI, double Budget)
+{
+	if(UI==NULL)
+		return 0;
+
+	const double Start=GetClock();
+	uint32_t Count=0;
+
+	// Callbacks can queue more events and grow the list, so each one is copied out before it runs.
+	// Whatever they queue waits behind what's already there, and counts against the same budget.
+	while(UI_HasPendingEvents(UI))
+	{
+		UI_Event_t Event;
+
+		List_GetCopy(&UI->Events, UI->NextEvent++, &Event);
+		Event.Callback(Event.Data);
+		Count++;
+
+		if(Budget>0.0&&GetClock()-Start>=Budget)
+			break;
+	}
+
+	UI_TrimEvents(UI);
+
+	return Count;
+}
@@ -0,0 +1,146 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "../math/math.h"
+#include "../utils/list.h"
+#include "../draw/draw.h"
+#include "ui.h"
+
+uint32_t UI_AddPanel(UI_t *UI, vec2 Position, vec2 Size, vec3 Color, const char *TitleText)
+{
+	if(UI==NULL)
+		return UINT32_MAX;
+
+	UI_Control_t Control=
+	{
+		.Type=UI_CONTROL_PANEL,
+		.Position=Position,
+		.Size=Size,
+		.PackedColor=Draw_PackColor(Color),
+		.Flags=UI_CONTROL_DIRTY
+	};
+
+	UI_ControlData_t Data=
+	{
+		.Color=Color,
+		.Title=StringPool_Intern(&UI->Strings, TitleText)
+	};
+
+	if(!List_Init(&Data.Panel.Children, sizeof(uint32_t), 0, NULL))
+	{
+		StringPool_Release(&UI->Strings, Data.Title);
+		return UINT32_MAX;
+	}
+
+	const uint32_t ID=UI_AddControl(UI, &Control, &Data);
+
+	if(ID==UINT32_MAX)
+		List_Destroy(&Data.Panel.Children);
+
+	return ID;
+}
+
+bool UI_UpdatePanel(UI_t *UI, uint32_t ID, vec2 Position, vec2 Size, vec3 Color, const char *TitleText)
+{
+	if(UI==NULL||ID==UINT32_MAX)
+		return false;
+
+	// Search list
+	UI_Control_t *Control=UI_FindControlByID(UI, ID);
+
+	if(Control!=NULL&&Control->Type==UI_CONTROL_PANEL)
+	{
+		UI_InvalidateControl(UI, Control);
+
+		Control->Position=Position;
+		UI_SetControlColor(UI, Control, Color);
+
+		UI_SetControlTitle(UI, Control, TitleText);
+		Control->Size=Size;
+
+		UI_ReindexControl(UI, Control);
+		return true;
+	}
+
+	// Not found
+	return false;
+}
+
+// Only the panel itself changes, what's in it follows when the draw list is rebuilt
+bool UI_UpdatePanelPosition(UI_t *UI, uint32_t ID, vec2 Position)
+{
+	if(UI==NULL||ID==UINT32_MAX)
+		return false;
+
+	// Search list
+	UI_Control_t *Control=UI_FindControlByID(UI, ID);
+
+	if(Control!=NULL&&Control->Type==UI_CONTROL_PANEL)
+	{
+		UI_InvalidateControl(UI, Control);
+
+		Control->Position=Position;
+		UI_ReindexControl(UI, Control);
+		return true;
+	}
+
+	// Not found
+	return false;
+}
+
+bool UI_UpdatePanelSize(UI_t *UI, uint32_t ID, vec2 Size)
+{
+	if(UI==NULL||ID==UINT32_MAX)
+		return false;
+
+	// Search list
+	UI_Control_t *Control=UI_FindControlByID(UI, ID);
+
+	if(Control!=NULL&&Control->Type==UI_CONTROL_PANEL)
+	{
+		UI_InvalidateControl(UI, Control);
+
+		Control->Size=Size;
+		UI_ReindexControl(UI, Control);
+		return true;
+	}
+
+	// Not found
+	return false;
+}
+
+bool UI_UpdatePanelColor(UI_t *UI, uint32_t ID, vec3 Color)
+{
+	if(UI==NULL||ID==UINT32_MAX)
+		return false;
+
+	// Search list
+	UI_Control_t *Control=UI_FindControlByID(UI, ID);
+
+	if(Control!=NULL&&Control->Type==UI_CONTROL_PANEL)
+	{
+		UI_SetControlColor(UI, Control, Color);
+		return true;
+	}
+
+	// Not found
+	return false;
+}
+
+bool UI_UpdatePanelTitleText(UI_t *UI, uint32_t ID, const char *TitleText)
+{
+	if(UI==NULL||ID==UINT32_MAX)
+		return false;
+
+	// Search list
+	UI_Control_t *Control=UI_FindControlByID(UI, ID);
+
+	if(Control!=NULL&&Control->Type==UI_CONTROL_PANEL)
+	{
+		UI_SetControlTitle(UI, Control, TitleText);
+		return true;
+	}
+
+	// Not found
+	return false;
+}
@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include "../math/math.h"
 #include "../utils/list.h"
+#include "../draw/draw.h"
 #include "ui.h"
 
 // Add a button to the UI.
@@ -10,27 +11,28 @@
 uint32_t UI_AddSprite(UI_t *UI, vec2 Position, vec2 Size, vec3 Color, /*VkuImage_t *Image, */float Rotation)
 {
 	static uint32_t SpriteDescriptorSetCount=0;
-	uint32_t ID=UI->IDBase++;
-
-	if(ID==UINT32_MAX||ID>=UI_HASHTABLE_MAX)
-		return UINT32_MAX;
 
 	UI_Control_t Control=
 	{
 		.Type=UI_CONTROL_SPRITE,
-		.ID=ID,
 		.Position=Position,
+		.Size=Size,
+		.PackedColor=Draw_PackColor(Color),
+		.Flags=UI_CONTROL_DIRTY
+	};
+
+	UI_ControlData_t Data=
+	{
 		.Color=Color,
 		//.Sprite.DescriptorSetOffset=SpriteDescriptorSetCount++,
 		//.Sprite.Image=Image,
-		.Sprite.Size=Size,
 		.Sprite.Rotation=Rotation
 	};
 
-	if(!List_Add(&UI->Controls, &Control))
-		return UINT32_MAX;
+	uint32_t ID=UI_AddControl(UI, &Control, &Data);
 
-	UI->Controls_Hashtable[ID]=List_GetPointer(&UI->Controls, List_GetCount(&UI->Controls)-1);
+	if(ID==UINT32_MAX)
+		return UINT32_MAX;
 
 	//VkDescriptorSet DescriptorSet=VK_NULL_HANDLE;
 	//VkDescriptorSetAllocateInfo AllocateInfo=
@@ -74,12 +76,16 @@ bool UI_UpdateSprite(UI_t *UI, uint32_t ID, vec2 Position, vec2 Size, vec3 Color
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_SPRITE)
 	{
+		UI_ControlData_t *Data=UI_GetControlData(UI, Control);
+
+		UI_InvalidateControl(UI, Control);
+
 		Control->Position=Position;
-		Control->Color=Color;
+		UI_SetControlColor(UI, Control, Color);
 
 		//Control->Sprite.Image=Image,
-		Control->Sprite.Rotation=Rotation;
-		Control->Sprite.Size=Size;
+		Data->Sprite.Rotation=Rotation;
+		Control->Size=Size;
 
 		return true;
 	}
@@ -98,6 +104,8 @@ bool UI_UpdateSpritePosition(UI_t *UI, uint32_t ID, vec2 Position)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_SPRITE)
 	{
+		UI_InvalidateControl(UI, Control);
+
 		Control->Position=Position;
 		return true;
 	}
@@ -116,7 +124,9 @@ bool UI_UpdateSpriteSize(UI_t *UI, uint32_t ID, vec2 Size)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_SPRITE)
 	{
-		Control->Button.Size=Size;
+		UI_InvalidateControl(UI, Control);
+
+		Control->Size=Size;
 		return true;
 	}
 
@@ -134,7 +144,7 @@ bool UI_UpdateSpriteColor(UI_t *UI, uint32_t ID, vec3 Color)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_SPRITE)
 	{
-		Control->Color=Color;
+		UI_SetControlColor(UI, Control, Color);
 		return true;
 	}
 
@@ -170,7 +180,9 @@ bool UI_UpdateSpriteRotation(UI_t *UI, uint32_t ID, float Rotation)
 
 	if(Control!=NULL&&Control->Type==UI_CONTROL_SPRITE)
 	{
-		Control->Sprite.Rotation=Rotation;
+		UI_InvalidateControl(UI, Control);
+
+		UI_GetControlData(UI, Control)->Sprite.Rotation=Rotation;
 		return true;
 	}
 
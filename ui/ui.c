@@ -1,10 +1,11 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdio.h>
-#include <ddraw.h>
+#include <stdlib.h>
 #include "../utils/genid.h"
 #include "../math/math.h"
 #include "../utils/list.h"
+#include "../draw/draw.h"
 #include "../font/font.h"
 #include "ui.h"
 
@@ -14,36 +15,873 @@ bool UI_Init(UI_t *UI, vec2 Position, vec2 Size)
 	if(UI==NULL)
 		return false;
 
-	UI->IDBase=0;
-
 	// Set screen width/height
 	UI->Position=Position;
 	UI->Size=Size;
 
-	// Initial 10 pre-allocated list of buttons, uninitialized
-	List_Init(&UI->Controls, sizeof(UI_Control_t), 10, NULL);
+	// Initial 10 pre-allocated list of buttons, uninitialized
+	List_Init(&UI->Controls, sizeof(UI_Control_t), 10, NULL);
+	List_Init(&UI->ControlData, sizeof(UI_ControlData_t), 10, NULL);
+
+	List_Init(&UI->Slots, sizeof(UI_Slot_t), 10, NULL);
+	UI->FreeSlot=UINT32_MAX;
+
+	if(!DrawList_Init(&UI->DrawList))
+		return false;
+
+	UI->DrawListDirty=true;
+	Damage_Clear(&UI->Damage);
+
+	if(!BitmapCache_Init(&UI->Cache, UI_CACHE_BUDGET))
+		return false;
+
+	UI->BytesPerPixel=0;
+
+	if(!Grid_Init(&UI->HitGrid, Size, UI_HIT_CELL_SIZE))
+		return false;
+
+	if(!StringPool_Init(&UI->Strings))
+		return false;
+
+	if(!List_Init(&UI->Events, sizeof(UI_Event_t), 0, NULL))
+		return false;
+
+	UI->NextEvent=0;
+
+	if(!List_Init(&UI->Bindings, sizeof(uint32_t), 0, NULL))
+		return false;
+
+	UI->BatchWrites=NULL;
+	UI->NumBatchWrites=0;
+	UI->MaxBatchWrites=0;
+	UI->Batching=false;
+	UI->BatchScratch=NULL;
+	UI->BatchScratchSize=0;
+
+	UI->Stats=(UI_Stats_t) { 0 };
+
+	UI->HitEpoch=0;
+	UI->HoverID=UINT32_MAX;
+	UI->CaptureID=UINT32_MAX;
+	UI->Hover=(UI_HitCache_t) { .ID=UINT32_MAX };
+	UI->Capture=(UI_HitCache_t) { .ID=UINT32_MAX };
+
+	return true;
+}
+
+void UI_Destroy(UI_t *UI)
+{
+	for(uint32_t i=0;i<List_GetCount(&UI->Controls);i++)
+	{
+		if(((UI_Control_t *)List_GetPointer(&UI->Controls, i))->Type==UI_CONTROL_PANEL)
+			List_Destroy(&((UI_ControlData_t *)List_GetPointer(&UI->ControlData, i))->Panel.Children);
+	}
+
+	List_Destroy(&UI->Controls);
+	List_Destroy(&UI->ControlData);
+	List_Destroy(&UI->Slots);
+	DrawList_Destroy(&UI->DrawList);
+	BitmapCache_Destroy(&UI->Cache);
+	Grid_Destroy(&UI->HitGrid);
+	StringPool_Destroy(&UI->Strings);
+	List_Destroy(&UI->Events);
+	List_Destroy(&UI->Bindings);
+	free(UI->BatchWrites);
+	free(UI->BatchScratch);
+}
+
+// Box around where a control can be hit, false for controls that can't be
+static bool UI_GetHitArea(const UI_Control_t *Control, vec2 *Min, vec2 *Max)
+{
+	switch(Control->Type)
+	{
+		case UI_CONTROL_BUTTON:
+			*Min=Control->Position;
+			*Max=Vec2_Addv(Control->Position, Control->Size);
+			return true;
+
+		case UI_CONTROL_CHECKBOX:
+			*Min=Vec2_Subv(Control->Position, Vec2b(Control->Radius));
+			*Max=Vec2_Addv(Control->Position, Vec2b(Control->Radius));
+			return true;
+
+		// Indexed even while read only, that can change without it moving
+		case UI_CONTROL_BARGRAPH:
+			*Min=Control->Position;
+			*Max=Vec2_Addv(Control->Position, Control->Size);
+			return true;
+
+		// Not hit itself, but whatever's in it can be
+		case UI_CONTROL_PANEL:
+			*Min=Control->Position;
+			*Max=Vec2_Addv(Control->Position, Control->Size);
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+static Grid_Range_t UI_GetHitCells(UI_t *UI, const UI_Control_t *Control)
+{
+	vec2 Min, Max;
+
+	if(!UI_GetHitArea(Control, &Min, &Max))
+		return GRID_RANGE_EMPTY;
+
+	return Grid_GetRange(&UI->HitGrid, Min, Max);
+}
+
+void UI_ReindexControl(UI_t *UI, UI_Control_t *Control)
+{
+	if(UI==NULL||Control==NULL)
+		return;
+
+	UI_ControlData_t *Data=UI_GetControlData(UI, Control);
+
+	// Out of memory leaves it out of the grid (unhittable) rather than half in it.
+	// Anything in a panel is found through the panel, so moving a panel doesn't move what's in it here either.
+	Grid_Move(&UI->HitGrid, Control->ID, &Data->HitCells, Data->Parent==UI_NO_PARENT?UI_GetHitCells(UI, Control):GRID_RANGE_EMPTY);
+	UI->HitEpoch++;
+}
+
+// Adds the control to the lists and hit grid, or nothing if any of it fails
+static uint32_t UI_InsertControl(UI_t *UI, UI_Control_t *Control, const UI_ControlData_t *Data)
+{
+	uint32_t Slot=UI->FreeSlot;
+
+	// Reuse a freed slot if there is one, otherwise grow
+	if(Slot==UINT32_MAX)
+	{
+		UI_Slot_t NewSlot={ .Index=UINT32_MAX, .Generation=0 };
+
+		if(List_GetCount(&UI->Slots)>=UI_MAX_CONTROLS||!List_Add(&UI->Slots, &NewSlot))
+			return UINT32_MAX;
+
+		Slot=(uint32_t)List_GetCount(&UI->Slots)-1;
+		UI->FreeSlot=Slot;
+	}
+
+	UI_Slot_t *Entry=List_GetPointer(&UI->Slots, Slot);
+
+	Control->ID=(Entry->Generation<<UI_ID_INDEX_BITS)|Slot;
+
+	UI_ControlData_t NewData=*Data;
+
+	// Everything starts outside of any panel
+	NewData.HitCells=UI_GetHitCells(UI, Control);
+	NewData.Parent=UI_NO_PARENT;
+	NewData.Origin=Vec2b(0.0f);
+	NewData.Clip=(DrawRect_t) { 0, 0, -1, -1 };
+
+	// A new slot stays on the free list if any of these fail
+	if(!Grid_Insert(&UI->HitGrid, Control->ID, NewData.HitCells))
+		return UINT32_MAX;
+
+	if(!List_Add(&UI->ControlData, &NewData))
+	{
+		Grid_Remove(&UI->HitGrid, Control->ID, NewData.HitCells);
+		return UINT32_MAX;
+	}
+
+	if(!List_Add(&UI->Controls, Control))
+	{
+		List_Del(&UI->ControlData, List_GetCount(&UI->ControlData)-1);
+		Grid_Remove(&UI->HitGrid, Control->ID, NewData.HitCells);
+		return UINT32_MAX;
+	}
+
+	UI->FreeSlot=Entry->Index;
+	Entry->Index=(uint32_t)List_GetCount(&UI->Controls)-1;
+
+	UI->DrawListDirty=true;
+	UI->HitEpoch++;
+
+	return Control->ID;
+}
+
+uint32_t UI_AddControl(UI_t *UI, UI_Control_t *Control, const UI_ControlData_t *Data)
+{
+	if(UI==NULL||Control==NULL||Data==NULL)
+		return UINT32_MAX;
+
+	const uint32_t ID=UI_InsertControl(UI, Control, Data);
+
+	if(ID==UINT32_MAX)
+		StringPool_Release(&UI->Strings, Data->Title);
+
+	return ID;
+}
+
+UI_Control_t *UI_FindControlByID(UI_t *UI, uint32_t ID)
+{
+	if(UI==NULL||ID==UINT32_MAX)
+		return NULL;
+
+	const UI_Slot_t *Entry=List_GetPointer(&UI->Slots, ID&UI_ID_INDEX_MASK);
+
+	if(Entry==NULL||Entry->Generation!=ID>>UI_ID_INDEX_BITS)
+		return NULL;
+
+	UI_Control_t *Control=List_GetPointer(&UI->Controls, Entry->Index);
+
+	// Free slots chain through Index, so check it really landed on this control
+	if(Control==NULL||Control->ID!=ID)
+		return NULL;
+
+	return Control;
+}
+
+UI_ControlData_t *UI_GetControlData(UI_t *UI, const UI_Control_t *Control)
+{
+	if(UI==NULL||Control==NULL)
+		return NULL;
+
+	return List_GetPointer(&UI->ControlData, Control-(UI_Control_t *)List_GetBufferPointer(&UI->Controls));
+}
+
+void UI_InvalidateControl(UI_t *UI, UI_Control_t *Control)
+{
+	if(UI==NULL||Control==NULL)
+		return;
+
+	// Only the bounds from the last draw need damaging, not every intermediate state
+	if(!(Control->Flags&UI_CONTROL_DIRTY))
+	{
+		Damage_Add(&UI->Damage, Control->Bounds);
+		Control->Flags|=UI_CONTROL_DIRTY;
+	}
+
+	UI->DrawListDirty=true;
+}
+
+void UI_SetControlTitle(UI_t *UI, UI_Control_t *Control, const char *TitleText)
+{
+	if(UI==NULL||Control==NULL)
+		return;
+
+	UI_ControlData_t *Data=UI_GetControlData(UI, Control);
+	const uint32_t Title=StringPool_Intern(&UI->Strings, TitleText);
+
+	// Same string, same handle, so setting the same title every frame costs a hash and a compare
+	if(Title==Data->Title)
+	{
+		StringPool_Release(&UI->Strings, Title);
+		return;
+	}
+
+	UI_InvalidateControl(UI, Control);
+	StringPool_Release(&UI->Strings, Data->Title);
+	Data->Title=Title;
+}
+
+void UI_SetControlColor(UI_t *UI, UI_Control_t *Control, vec3 Color)
+{
+	if(UI==NULL||Control==NULL)
+		return;
+
+	UI_ControlData_t *Data=UI_GetControlData(UI, Control);
+	const uint32_t PackedColor=Draw_PackColor(Color);
+
+	// Often set every frame, only a visible change needs a rebuild
+	if(PackedColor!=Control->PackedColor)
+		UI_InvalidateControl(UI, Control);
+
+	Data->Color=Color;
+	Control->PackedColor=PackedColor;
+
+	if(Data->ColorBinding)
+		*Data->ColorBinding=Color;
+}
+
+bool UI_AddBinding(UI_t *UI, UI_Control_t *Control)
+{
+	if(UI==NULL||Control==NULL)
+		return false;
+
+	if(Control->Flags&UI_CONTROL_BOUND)
+		return true;
+
+	if(!List_Add(&UI->Bindings, &Control->ID))
+		return false;
+
+	Control->Flags|=UI_CONTROL_BOUND;
+
+	return true;
+}
+
+bool UI_BindControlColor(UI_t *UI, uint32_t ID, vec3 *Color)
+{
+	UI_Control_t *Control=UI_FindControlByID(UI, ID);
+
+	if(Control==NULL)
+		return false;
+
+	// Unbinding leaves the entry for UI_SyncBindings to drop
+	if(Color!=NULL&&!UI_AddBinding(UI, Control))
+		return false;
+
+	UI_GetControlData(UI, Control)->ColorBinding=Color;
+
+	if(Color!=NULL)
+		UI_SetControlColor(UI, Control, *Color);
+
+	return true;
+}
+
+void UI_SyncBindings(UI_t *UI)
+{
+	if(UI==NULL)
+		return;
+
+	uint32_t *IDs=(uint32_t *)List_GetBufferPointer(&UI->Bindings);
+	uint32_t Count=(uint32_t)List_GetCount(&UI->Bindings);
+
+	// Runs every frame over every binding, so the slots are read straight out of the buffers
+	const UI_Slot_t *Slots=(const UI_Slot_t *)List_GetBufferPointer(&UI->Slots);
+	UI_Control_t *Controls=(UI_Control_t *)List_GetBufferPointer(&UI->Controls);
+	UI_ControlData_t *ControlData=(UI_ControlData_t *)List_GetBufferPointer(&UI->ControlData);
+	const uint32_t NumControls=(uint32_t)List_GetCount(&UI->Controls);
+
+	for(uint32_t i=0;i<Count;)
+	{
+		const UI_Slot_t *Slot=&Slots[IDs[i]&UI_ID_INDEX_MASK];
+		UI_Control_t *Control=NULL;
+		bool Bound=false;
+
+		// A free slot's index is the next free one, so check it really landed on this control
+		if(Slot->Generation==IDs[i]>>UI_ID_INDEX_BITS&&Slot->Index<NumControls&&Controls[Slot->Index].ID==IDs[i])
+			Control=&Controls[Slot->Index];
+
+		if(Control!=NULL)
+		{
+			UI_ControlData_t *Data=&ControlData[Slot->Index];
+
+			if(Data->ColorBinding)
+			{
+				const vec3 Color=*Data->ColorBinding;
+
+				if(Color.x!=Data->Color.x||Color.y!=Data->Color.y||Color.z!=Data->Color.z)
+					UI_SetControlColor(UI, Control, Color);
+
+				Bound=true;
+			}
+
+			if(Control->Type==UI_CONTROL_CHECKBOX&&Data->CheckBox.Binding)
+			{
+				if(*Data->CheckBox.Binding!=Data->CheckBox.Value)
+				{
+					UI_InvalidateControl(UI, Control);
+					Data->CheckBox.Value=*Data->CheckBox.Binding;
+				}
+
+				Bound=true;
+			}
+
+			if(Control->Type==UI_CONTROL_BARGRAPH&&Data->BarGraph.Binding)
+			{
+				if(*Data->BarGraph.Binding!=Data->BarGraph.Value)
+				{
+					UI_InvalidateControl(UI, Control);
+					Data->BarGraph.Value=*Data->BarGraph.Binding;
+				}
+
+				Bound=true;
+			}
+		}
+
+		if(Bound)
+		{
+			i++;
+			continue;
+		}
+
+		// Gone or unbound, the last entry fills the hole
+		if(Control!=NULL)
+			Control->Flags&=~UI_CONTROL_BOUND;
+
+		IDs[i]=IDs[--Count];
+		List_Del(&UI->Bindings, Count);
+	}
+}
+
+// Takes a control out of its panel's list, keeping the order of the rest
+static void UI_DetachControl(UI_t *UI, uint32_t ID, UI_ControlData_t *Data)
+{
+	UI_Control_t *Parent=UI_FindControlByID(UI, Data->Parent);
+
+	Data->Parent=UI_NO_PARENT;
+
+	// Gone already when a whole group goes
+	if(Parent==NULL)
+		return;
+
+	List_t *Children=&UI_GetControlData(UI, Parent)->Panel.Children;
+
+	for(uint32_t i=0;i<List_GetCount(Children);i++)
+	{
+		if(*(uint32_t *)List_GetPointer(Children, i)==ID)
+		{
+			List_Del(Children, i);
+			break;
+		}
+	}
+}
+
+bool UI_SetControlParent(UI_t *UI, uint32_t ID, uint32_t ParentID)
+{
+	UI_Control_t *Control=UI_FindControlByID(UI, ID);
+
+	if(Control==NULL)
+		return false;
+
+	UI_Control_t *Parent=NULL;
+
+	if(ParentID!=UI_NO_PARENT)
+	{
+		Parent=UI_FindControlByID(UI, ParentID);
+
+		if(Parent==NULL||Parent->Type!=UI_CONTROL_PANEL)
+			return false;
+
+		// A panel can't go inside itself or anything in it
+		for(uint32_t Up=ParentID;Up!=UI_NO_PARENT;Up=UI_GetControlData(UI, UI_FindControlByID(UI, Up))->Parent)
+		{
+			if(Up==ID)
+				return false;
+		}
+	}
+
+	UI_ControlData_t *Data=UI_GetControlData(UI, Control);
+
+	if(Data->Parent==ParentID)
+		return true;
+
+	if(Parent&&!List_Add(&UI_GetControlData(UI, Parent)->Panel.Children, &ID))
+		return false;
+
+	UI_InvalidateControl(UI, Control);
+	UI_DetachControl(UI, ID, Data);
+	Data->Parent=ParentID;
+	UI_ReindexControl(UI, Control);
+
+	return true;
+}
+
+bool UI_SetControlVisible(UI_t *UI, uint32_t ID, bool Visible)
+{
+	UI_Control_t *Control=UI_FindControlByID(UI, ID);
+
+	if(Control==NULL)
+		return false;
+
+	if(Visible==!(Control->Flags&UI_CONTROL_HIDDEN))
+		return true;
+
+	// Hiding a panel damages its bounds, which is all anything in it could have drawn to
+	UI_InvalidateControl(UI, Control);
+	Control->Flags^=UI_CONTROL_HIDDEN;
+	UI->HitEpoch++;
+
+	return true;
+}
+
+// Damages what the control drew and drops everything referring to it, its slot moves to a new generation.
+// Anything in a panel has to be freed separately.
+static void UI_FreeControl(UI_t *UI, UI_Control_t *Control)
+{
+	UI_InvalidateControl(UI, Control);
+	BitmapCache_Release(&UI->Cache, Control->CacheHandle, Control->ID);
+	UI_ControlData_t *Data=UI_GetControlData(UI, Control);
+
+	Grid_Remove(&UI->HitGrid, Control->ID, Data->HitCells);
+	StringPool_Release(&UI->Strings, Data->Title);
+	UI_DetachControl(UI, Control->ID, Data);
+
+	if(Control->Type==UI_CONTROL_PANEL)
+		List_Destroy(&Data->Panel.Children);
+
+	UI->HitEpoch++;
+
+	uint32_t Slot=Control->ID&UI_ID_INDEX_MASK;
+	UI_Slot_t *Entry=List_GetPointer(&UI->Slots, Slot);
+
+	// Out of generations, reusing it would hand out IDs that old ones alias
+	if(Entry->Generation>=UI_ID_GENERATION_MASK)
+	{
+		Entry->Generation=UI_SLOT_RETIRED;
+		Entry->Index=UINT32_MAX;
+		return;
+	}
+
+	Entry->Generation++;
+	Entry->Index=UI->FreeSlot;
+	UI->FreeSlot=Slot;
+}
+
+bool UI_RemoveControl(UI_t *UI, uint32_t ID)
+{
+	UI_Control_t *Control=UI_FindControlByID(UI, ID);
+
+	if(Control==NULL)
+		return false;
+
+	// Whatever's in a panel goes first, last first so each one coming out of the list shifts nothing
+	while(Control->Type==UI_CONTROL_PANEL)
+	{
+		List_t *Children=&UI_GetControlData(UI, Control)->Panel.Children;
+		const uint32_t Count=(uint32_t)List_GetCount(Children);
+
+		if(!Count)
+			break;
+
+		UI_RemoveControl(UI, *(uint32_t *)List_GetPointer(Children, Count-1));
+
+		// Removing swaps controls around
+		Control=UI_FindControlByID(UI, ID);
+	}
+
+	uint32_t Index=((UI_Slot_t *)List_GetPointer(&UI->Slots, ID&UI_ID_INDEX_MASK))->Index;
+	uint32_t Last=(uint32_t)List_GetCount(&UI->Controls)-1;
+
+	UI_FreeControl(UI, Control);
+
+	// Fill the hole with the last control, it now draws earlier so it may stack differently
+	if(Index!=Last)
+	{
+		UI_Control_t *Moved=List_GetPointer(&UI->Controls, Last);
+
+		UI_InvalidateControl(UI, Moved);
+		*Control=*Moved;
+		*(UI_ControlData_t *)List_GetPointer(&UI->ControlData, Index)=*(UI_ControlData_t *)List_GetPointer(&UI->ControlData, Last);
+		((UI_Slot_t *)List_GetPointer(&UI->Slots, Control->ID&UI_ID_INDEX_MASK))->Index=Index;
+	}
+
+	List_Del(&UI->Controls, Last);
+	List_Del(&UI->ControlData, Last);
+
+	return true;
+}
+
+bool UI_SetControlGroup(UI_t *UI, uint32_t ID, uint32_t Group)
+{
+	UI_Control_t *Control=UI_FindControlByID(UI, ID);
+
+	if(Control==NULL)
+		return false;
+
+	UI_GetControlData(UI, Control)->Group=Group;
+
+	return true;
+}
+
+// Puts everything in a panel into its group, so it goes with the panel
+static void UI_MarkPanelGroup(UI_t *UI, UI_ControlData_t *Data, uint32_t Group)
+{
+	for(uint32_t i=0;i<List_GetCount(&Data->Panel.Children);i++)
+	{
+		UI_Control_t *Child=UI_FindControlByID(UI, *(uint32_t *)List_GetPointer(&Data->Panel.Children, i));
+
+		if(Child==NULL)
+			continue;
+
+		UI_ControlData_t *ChildData=UI_GetControlData(UI, Child);
+
+		ChildData->Group=Group;
+
+		if(Child->Type==UI_CONTROL_PANEL)
+			UI_MarkPanelGroup(UI, ChildData, Group);
+	}
+}
+
+uint32_t UI_RemoveGroup(UI_t *UI, uint32_t Group)
+{
+	if(UI==NULL||Group==0)
+		return 0;
+
+	uint32_t Count=(uint32_t)List_GetCount(&UI->Controls), Kept=0;
+
+	for(uint32_t i=0;i<Count;i++)
+	{
+		UI_Control_t *Control=List_GetPointer(&UI->Controls, i);
+		UI_ControlData_t *Data=List_GetPointer(&UI->ControlData, i);
+
+		if(Control->Type==UI_CONTROL_PANEL&&Data->Group==Group)
+			UI_MarkPanelGroup(UI, Data, Group);
+	}
+
+	// Compact in place, everything kept shifts down over the removed ones
+	for(uint32_t i=0;i<Count;i++)
+	{
+		UI_Control_t *Control=List_GetPointer(&UI->Controls, i);
+		UI_ControlData_t *Data=List_GetPointer(&UI->ControlData, i);
+
+		if(Data->Group==Group)
+		{
+			UI_FreeControl(UI, Control);
+			continue;
+		}
+
+		if(Kept!=i)
+		{
+			*(UI_Control_t *)List_GetPointer(&UI->Controls, Kept)=*Control;
+			*(UI_ControlData_t *)List_GetPointer(&UI->ControlData, Kept)=*Data;
+			((UI_Slot_t *)List_GetPointer(&UI->Slots, Control->ID&UI_ID_INDEX_MASK))->Index=Kept;
+		}
+
+		Kept++;
+	}
+
+	// Only the tail is left to drop, nothing shifts
+	while(List_GetCount(&UI->Controls)>Kept)
+	{
+		List_Del(&UI->Controls, List_GetCount(&UI->Controls)-1);
+		List_Del(&UI->ControlData, List_GetCount(&UI->ControlData)-1);
+	}
+
+	return Count-Kept;
+}
+
+bool UI_IsInvalidated(const UI_t *UI)
+{
+	if(UI==NULL)
+		return false;
+
+	return UI->DrawListDirty||!Damage_IsEmpty(&UI->Damage);
+}
+
+// Whether Position is on a control that reacts to being clicked
+static bool UI_HitControl(const UI_Control_t *Control, vec2 Position)
+{
+	switch(Control->Type)
+	{
+		case UI_CONTROL_BUTTON:
+			return Position.x>=Control->Position.x&&Position.x<=Control->Position.x+Control->Size.x&&
+				   Position.y>=Control->Position.y&&Position.y<=Control->Position.y+Control->Size.y;
+
+		case UI_CONTROL_CHECKBOX:
+		{
+			vec2 Normal=Vec2_Subv(Control->Position, Position);
+
+			return Vec2_Dot(Normal, Normal)<=Control->Radius*Control->Radius;
+		}
+
+		case UI_CONTROL_BARGRAPH:
+			return !(Control->Flags&UI_CONTROL_READONLY)&&
+				   Position.x>=Control->Position.x&&Position.x<=Control->Position.x+Control->Size.x&&
+				   Position.y>=Control->Position.y&&Position.y<=Control->Position.y+Control->Size.y;
+
+		default:
+			return false;
+	}
+}
+
+// Finds what's under Position (in the panel's parent's space) among what's in a panel, the first one in its list wins
+static UI_Control_t *UI_HitPanel(UI_t *UI, const UI_Control_t *Panel, vec2 Position)
+{
+	// Anything outside of the panel is clipped away
+	if(Position.x<Panel->Position.x||Position.x>Panel->Position.x+Panel->Size.x||
+	   Position.y<Panel->Position.y||Position.y>Panel->Position.y+Panel->Size.y)
+		return NULL;
+
+	const List_t *Children=&UI_GetControlData(UI, Panel)->Panel.Children;
+	const vec2 Local=Vec2_Subv(Position, Panel->Position);
+
+	for(uint32_t i=0;i<List_GetCount((List_t *)Children);i++)
+	{
+		UI_Control_t *Child=UI_FindControlByID(UI, *(uint32_t *)List_GetPointer((List_t *)Children, i));
+
+		if(Child==NULL||(Child->Flags&UI_CONTROL_HIDDEN))
+			continue;
+
+		if(Child->Type==UI_CONTROL_PANEL)
+		{
+			UI_Control_t *Hit=UI_HitPanel(UI, Child, Local);
+
+			if(Hit)
+				return Hit;
+		}
+		else if(UI_HitControl(Child, Local))
+			return Child;
+	}
+
+	return NULL;
+}
+
+// Where a control's panel is in UI space, the sum of every panel above it
+static vec2 UI_GetParentOrigin(UI_t *UI, const UI_Control_t *Control)
+{
+	vec2 Origin=Vec2b(0.0f);
+
+	for(uint32_t Up=UI_GetControlData(UI, Control)->Parent;Up!=UI_NO_PARENT;)
+	{
+		const UI_Control_t *Panel=UI_FindControlByID(UI, Up);
+
+		Origin=Vec2_Addv(Origin, Panel->Position);
+		Up=UI_GetControlData(UI, Panel)->Parent;
+	}
+
+	return Origin;
+}
+
+// Shrinks the cache's area to the part inside Min to Max (offset by Origin)
+static void UI_ClipHitCache(UI_HitCache_t *Cache, vec2 Origin, vec2 Min, vec2 Max)
+{
+	Cache->Min.x=fmaxf(Cache->Min.x, Origin.x+Min.x);
+	Cache->Min.y=fmaxf(Cache->Min.y, Origin.y+Min.y);
+	Cache->Max.x=fminf(Cache->Max.x, Origin.x+Max.x);
+	Cache->Max.y=fminf(Cache->Max.y, Origin.y+Max.y);
+}
+
+// Whether anything of a control (offset by Origin) is inside the cache's area, if so it could take hits there
+static bool UI_OverlapsHitCache(const UI_HitCache_t *Cache, const UI_Control_t *Control, vec2 Origin)
+{
+	vec2 Min, Max;
+
+	if(Control->Flags&UI_CONTROL_HIDDEN||!UI_GetHitArea(Control, &Min, &Max))
+		return false;
+
+	return Origin.x+Min.x<Cache->Max.x&&Origin.x+Max.x>=Cache->Min.x&&
+		   Origin.y+Min.y<Cache->Max.y&&Origin.y+Max.y>=Cache->Min.y;
+}
+
+// Works out the area around Position where Hit stays the result: the hit control's own area inside every panel it's in,
+// within the grid cell, and only if nothing tested before it reaches into that area. Otherwise the area is left empty.
+static void UI_FillHitCache(UI_t *UI, vec2 Position, const UI_Control_t *Hit, uint32_t HitIndex, const uint32_t *Keys, uint32_t Count, UI_HitCache_t *Cache)
+{
+	Cache->ID=Hit?Hit->ID:UINT32_MAX;
+	Cache->Epoch=UI->HitEpoch;
+	Cache->Origin=Hit?UI_GetParentOrigin(UI, Hit):Vec2b(0.0f);
+
+	Grid_GetCellBounds(&UI->HitGrid, Position, &Cache->Min, &Cache->Max);
+	UI_ClipHitCache(Cache, Vec2b(0.0f), Vec2b(0.0f), UI->Size);
+
+	if(Hit)
+	{
+		vec2 Min, Max;
+
+		UI_GetHitArea(Hit, &Min, &Max);
+		UI_ClipHitCache(Cache, Cache->Origin, Min, Max);
+
+		// Up through the panels, each clips the area and anything before it in its list could take over
+		const UI_Control_t *Control=Hit;
+		vec2 Origin=Cache->Origin;
+
+		for(uint32_t Up=UI_GetControlData(UI, Control)->Parent;Up!=UI_NO_PARENT;)
+		{
+			const UI_Control_t *Panel=UI_FindControlByID(UI, Up);
+			const List_t *Children=&UI_GetControlData(UI, Panel)->Panel.Children;
+
+			for(uint32_t i=0;i<List_GetCount((List_t *)Children);i++)
+			{
+				const UI_Control_t *Child=UI_FindControlByID(UI, *(uint32_t *)List_GetPointer((List_t *)Children, i));
+
+				if(Child==Control)
+					break;
+
+				if(Child&&UI_OverlapsHitCache(Cache, Child, Origin))
+				{
+					Cache->Max=Cache->Min;
+					return;
+				}
+			}
+
+			Origin=Vec2_Subv(Origin, Panel->Position);
+			UI_ClipHitCache(Cache, Origin, Panel->Position, Vec2_Addv(Panel->Position, Panel->Size));
+
+			Control=Panel;
+			Up=UI_GetControlData(UI, Panel)->Parent;
+		}
+	}
+
+	// Top level controls sharing the cell that come first win over the hit, any other would be hit instead of nothing
+	for(uint32_t i=0;i<Count;i++)
+	{
+		const uint32_t Index=((UI_Slot_t *)List_GetPointer(&UI->Slots, Keys[i]&UI_ID_INDEX_MASK))->Index;
+
+		if(Index>=HitIndex)
+			continue;
+
+		if(UI_OverlapsHitCache(Cache, List_GetPointer(&UI->Controls, Index), Vec2b(0.0f)))
+		{
+			Cache->Max=Cache->Min;
+			return;
+		}
+	}
+}
+
+// Finds the control under Position (in UI space), filling Cache if given
+static UI_Control_t *UI_FindHit(UI_t *UI, vec2 Position, UI_HitCache_t *Cache)
+{
+	// Nothing outside of the viewport can be hit
+	if(Position.x<0.0f||Position.y<0.0f||Position.x>=UI->Size.x||Position.y>=UI->Size.y)
+	{
+		if(Cache)
+			*Cache=(UI_HitCache_t) { .ID=UINT32_MAX, .Epoch=UI->HitEpoch };
+
+		return NULL;
+	}
+
+	// Only the controls sharing the cursor's grid cell can be under it
+	uint32_t Count=0;
+	const uint32_t *Keys=Grid_Query(&UI->HitGrid, Position, &Count);
+
+	UI_Control_t *Hit=NULL;
+	uint32_t HitIndex=UINT32_MAX;
+
+	// Where controls overlap the first one in the list wins, same as testing them in order
+	for(uint32_t i=0;i<Count;i++)
+	{
+		const uint32_t Index=((UI_Slot_t *)List_GetPointer(&UI->Slots, Keys[i]&UI_ID_INDEX_MASK))->Index;
+
+		if(Index>=HitIndex)
+			continue;
+
+		UI_Control_t *Control=List_GetPointer(&UI->Controls, Index);
+
+		if(Control->Flags&UI_CONTROL_HIDDEN)
+			continue;
+
+		// Only top level controls are in the grid, a panel stands in for everything in it
+		if(Control->Type==UI_CONTROL_PANEL)
+		{
+			UI_Control_t *Child=UI_HitPanel(UI, Control, Position);
 
-	memset(UI->Controls_Hashtable, 0, sizeof(UI_Control_t *)*UI_HASHTABLE_MAX);
+			if(Child)
+			{
+				Hit=Child;
+				HitIndex=Index;
+			}
+		}
+		else if(UI_HitControl(Control, Position))
+		{
+			Hit=Control;
+			HitIndex=Index;
+		}
+	}
 
-	return true;
-}
+	if(Cache)
+		UI_FillHitCache(UI, Position, Hit, HitIndex, Keys, Count, Cache);
 
-void UI_Destroy(UI_t *UI)
-{
-	List_Destroy(&UI->Controls);
+	return Hit;
 }
 
-UI_Control_t *UI_FindControlByID(UI_t *UI, uint32_t ID)
+// True while the cached result still holds at Position (in UI space), *Hit is then the control or NULL for nothing hit
+static bool UI_CheckHitCache(UI_t *UI, const UI_HitCache_t *Cache, vec2 Position, UI_Control_t **Hit)
 {
-	if(UI==NULL||ID>=UI_HASHTABLE_MAX||ID==UINT32_MAX)
-		return NULL;
+	*Hit=NULL;
 
-	UI_Control_t *Control=UI->Controls_Hashtable[ID];
+	if(Cache->Epoch!=UI->HitEpoch||
+	   Position.x<Cache->Min.x||Position.y<Cache->Min.y||Position.x>=Cache->Max.x||Position.y>=Cache->Max.y)
+		return false;
 
-	if(Control->ID==ID)
-		return Control;
+	if(Cache->ID==UINT32_MAX)
+		return true;
 
-	return NULL;
+	// The area is a box, a check box is round
+	*Hit=UI_FindControlByID(UI, Cache->ID);
+
+	return *Hit&&UI_HitControl(*Hit, Vec2_Subv(Position, Cache->Origin));
 }
 
 // Checks hit on UI controls, also processes certain controls, intended to be used on mouse button down events
@@ -54,59 +892,59 @@ uint32_t UI_TestHit(UI_t *UI, vec2 Position)
 	if(UI==NULL)
 		return UINT32_MAX;
 
-	// Offset by UI position
-	Position=Vec2_Addv(Position, UI->Position);
+	// Into UI space
+	UI_Control_t *Hit=UI_FindHit(UI, Vec2_Subv(Position, UI->Position), NULL);
 
-	// Loop through all controls in the UI
-	for(uint32_t i=0;i<List_GetCount(&UI->Controls);i++)
-	{
-		UI_Control_t *Control=List_GetPointer(&UI->Controls, i);
+	// Nothing found
+	if(Hit==NULL)
+		return UINT32_MAX;
 
-		switch(Control->Type)
-		{
-		case UI_CONTROL_BUTTON:
-			if(Position.x>=Control->Position.x&&Position.x<=Control->Position.x+Control->Button.Size.x&&
-			   Position.y>=Control->Position.y&&Position.y<=Control->Position.y+Control->Button.Size.y)
-			{
-				// TODO: This could potentionally be an issue if the callback blocks
-				if(Control->Button.Callback)
-					Control->Button.Callback(NULL);
+	const uint32_t ID=Hit->ID;
+	UI_ControlData_t *Data=UI_GetControlData(UI, Hit);
 
-				return Control->ID;
-			}
+	// Drags go to it until the button comes up
+	UI->CaptureID=ID;
+	UI->Capture=(UI_HitCache_t) { .ID=ID, .Epoch=UI->HitEpoch, .Origin=UI_GetParentOrigin(UI, Hit) };
+
+	switch(Hit->Type)
+	{
+		// Queued rather than called, a slow callback here would hold up the message loop
+		case UI_CONTROL_BUTTON:
+			if(Data->Button.Callback)
+				UI_QueueEvent(UI, ID, UI_EVENT_CLICK, Data->Button.Callback, Data->Button.CallbackData);
 			break;
 
 		case UI_CONTROL_CHECKBOX:
-			vec2 Normal=Vec2_Subv(Control->Position, Position);
+			UI_InvalidateControl(UI, Hit);
+			Data->CheckBox.Value=!Data->CheckBox.Value;
 
-			if(Vec2_Dot(Normal, Normal)<=Control->CheckBox.Radius*Control->CheckBox.Radius)
-			{
-				Control->CheckBox.Value=!Control->CheckBox.Value;
-				return Control->ID;
-			}
+			if(Data->CheckBox.Binding)
+				*Data->CheckBox.Binding=Data->CheckBox.Value;
 			break;
 
-			// Only return the ID of this control
-		case UI_CONTROL_BARGRAPH:
-			if(!Control->BarGraph.Readonly)
-			{
-				// If hit inside control area, map hit position to point on bargraph and set the value scaled to the set min and max
-				if(Position.x>=Control->Position.x&&Position.x<=Control->Position.x+Control->BarGraph.Size.x&&
-				   Position.y>=Control->Position.y&&Position.y<=Control->Position.y+Control->BarGraph.Size.y)
-					return Control->ID;
-			}
+		// Only return the ID of this control, UI_ProcessControl sets the value while dragging
+		default:
 			break;
+	}
 
-		case UI_CONTROL_SPRITE:
-			break;
+	return ID;
+}
 
-		case UI_CONTROL_CURSOR:
-			break;
-		}
-	}
+// Sets a bar graph's value from where x (in its panel's space) is along it, clamped to its ends
+static void UI_DragBarGraph(UI_t *UI, UI_Control_t *Control, float x)
+{
+	UI_ControlData_t *Data=UI_GetControlData(UI, Control);
+	const float Along=fminf(fmaxf((x-Control->Position.x)/Control->Size.x, 0.0f), 1.0f);
+	const float Value=Along*(Data->BarGraph.Max-Data->BarGraph.Min)+Data->BarGraph.Min;
 
-	// Nothing found
-	return UINT32_MAX;
+	if(Value==Data->BarGraph.Value)
+		return;
+
+	UI_InvalidateControl(UI, Control);
+	Data->BarGraph.Value=Value;
+
+	if(Data->BarGraph.Binding)
+		*Data->BarGraph.Binding=Data->BarGraph.Value;
 }
 
 // Processes hit on certain UI controls by ID (returned by UI_TestHit), intended to be used by "mouse move" events.
@@ -117,8 +955,8 @@ bool UI_ProcessControl(UI_t *UI, uint32_t ID, vec2 Position)
 	if(UI==NULL||ID==UINT32_MAX)
 		return false;
 
-	// Offset by UI position
-	Position=Vec2_Addv(Position, UI->Position);
+	// Into UI space
+	Position=Vec2_Subv(Position, UI->Position);
 
 	// Get the control from the ID
 	UI_Control_t *Control=UI_FindControlByID(UI, ID);
@@ -135,12 +973,15 @@ bool UI_ProcessControl(UI_t *UI, uint32_t ID, vec2 Position)
 		break;
 
 	case UI_CONTROL_BARGRAPH:
-		if(!Control->BarGraph.Readonly)
+		if(!(Control->Flags&UI_CONTROL_READONLY))
 		{
+			// Into the space of whatever panel it's in
+			Position=Vec2_Subv(Position, UI_GetParentOrigin(UI, Control));
+
 			// If hit inside control area, map hit position to point on bargraph and set the value scaled to the set min and max
-			if(Position.x>=Control->Position.x&&Position.x<=Control->Position.x+Control->BarGraph.Size.x&&
-			   Position.y>=Control->Position.y&&Position.y<=Control->Position.y+Control->BarGraph.Size.y)
-				Control->BarGraph.Value=((Position.x-Control->Position.x)/Control->BarGraph.Size.x)*(Control->BarGraph.Max-Control->BarGraph.Min)+Control->BarGraph.Min;
+			if(Position.x>=Control->Position.x&&Position.x<=Control->Position.x+Control->Size.x&&
+			   Position.y>=Control->Position.y&&Position.y<=Control->Position.y+Control->Size.y)
+				UI_DragBarGraph(UI, Control, Position.x);
 		}
 		break;
 
@@ -149,76 +990,471 @@ bool UI_ProcessControl(UI_t *UI, uint32_t ID, vec2 Position)
 
 	case UI_CONTROL_CURSOR:
 		break;
+
+	case UI_CONTROL_PANEL:
+		break;
+
+	default:
+		break;
 	}
 
 	return true;
 }
 
-void point(DDSURFACEDESC2 ddsd, uint32_t x, uint32_t y, float c[3]);
-void line(DDSURFACEDESC2 ddsd, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, float c[3]);
-void roundedrect(DDSURFACEDESC2 ddsd, uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2, uint32_t r, float c[3]);
-void fillroundedrect(DDSURFACEDESC2 ddsd, uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2, uint32_t r, float c[3]);
-void circle(DDSURFACEDESC2 ddsd, uint32_t x, uint32_t y, uint32_t r, float c[3]);
-void fillcircle(DDSURFACEDESC2 ddsd, uint32_t x, uint32_t y, uint32_t r, float c[3]);
+// Moves the highlight from one control to another
+static void UI_SetHover(UI_t *UI, uint32_t ID)
+{
+	UI_Control_t *Control=UI_FindControlByID(UI, UI->HoverID);
+
+	if(Control)
+	{
+		UI_InvalidateControl(UI, Control);
+		Control->Flags&=~UI_CONTROL_HOVER;
+	}
+
+	UI->HoverID=ID;
+	Control=UI_FindControlByID(UI, ID);
+
+	if(Control)
+	{
+		UI_InvalidateControl(UI, Control);
+		Control->Flags|=UI_CONTROL_HOVER;
+	}
+}
 
-bool UI_Draw(UI_t *UI, DDSURFACEDESC2 ddsd)
+uint32_t UI_UpdateHover(UI_t *UI, vec2 Position)
 {
 	if(UI==NULL)
+		return UINT32_MAX;
+
+	// Into UI space
+	Position=Vec2_Subv(Position, UI->Position);
+
+	UI_Control_t *Hit;
+
+	// Still where the last result holds, by far the usual case for a mouse reporting every millisecond
+	if(!UI_CheckHitCache(UI, &UI->Hover, Position, &Hit))
+		Hit=UI_FindHit(UI, Position, &UI->Hover);
+
+	const uint32_t ID=Hit?Hit->ID:UINT32_MAX;
+
+	if(ID!=UI->HoverID)
+		UI_SetHover(UI, ID);
+
+	return ID;
+}
+
+bool UI_ProcessCapture(UI_t *UI, vec2 Position)
+{
+	if(UI==NULL||UI->CaptureID==UINT32_MAX)
 		return false;
 
-	for(uint32_t i=0;i<List_GetCount(&UI->Controls);i++)
+	UI_Control_t *Control=UI_FindControlByID(UI, UI->CaptureID);
+
+	// Removed while held
+	if(Control==NULL)
 	{
-		UI_Control_t *Control=List_GetPointer(&UI->Controls, i);
+		UI_ReleaseCapture(UI);
+		return false;
+	}
+
+	// Its panels only need walking again when something moved
+	if(UI->Capture.Epoch!=UI->HitEpoch)
+	{
+		UI->Capture.Origin=UI_GetParentOrigin(UI, Control);
+		UI->Capture.Epoch=UI->HitEpoch;
+	}
+
+	// Into the control's space, no bounds test, it keeps the drag even off its edges
+	Position=Vec2_Subv(Vec2_Subv(Position, UI->Position), UI->Capture.Origin);
+
+	if(Control->Type==UI_CONTROL_BARGRAPH&&!(Control->Flags&UI_CONTROL_READONLY))
+		UI_DragBarGraph(UI, Control, Position.x);
+
+	return true;
+}
+
+void UI_ReleaseCapture(UI_t *UI)
+{
+	if(UI==NULL)
+		return;
+
+	UI->CaptureID=UINT32_MAX;
+}
+
+void UI_InvalidateHits(UI_t *UI)
+{
+	if(UI==NULL)
+		return;
+
+	UI->HitEpoch++;
+}
+
+// What every control being recorded shares
+typedef struct
+{
+	RenderTarget_t *Target;
+	uint32_t BytesPerPixel;
+	bool Cached;
+
+	// Fixed frame colors, packed once per draw rather than per primitive. Hovered controls swap Gray for Highlight.
+	uint32_t White, Gray, Highlight;
+
+	// Visible part of the UI on screen, everything is clipped to it
+	DrawRect_t Viewport;
+} UI_Builder_t;
+
+static DrawRect_t UI_IntersectRect(DrawRect_t a, DrawRect_t b)
+{
+	a.MinX=max(a.MinX, b.MinX);
+	a.MinY=max(a.MinY, b.MinY);
+	a.MaxX=min(a.MaxX, b.MaxX);
+	a.MaxY=min(a.MaxY, b.MaxY);
+
+	return a;
+}
+
+static bool UI_RectEmpty(DrawRect_t Rect)
+{
+	return Rect.MinX>Rect.MaxX||Rect.MinY>Rect.MaxY;
+}
 
-		switch(Control->Type)
+// Screen area a control at Position draws to, from its shape and title without recording anything.
+// Conservative by a pixel or so, it only has to never be smaller than what's drawn.
+static DrawRect_t UI_GetDrawRect(UI_t *UI, const UI_Control_t *Control, const UI_ControlData_t *Data, vec2 Position)
+{
+	const uint32_t Length=StringPool_GetLength(&UI->Strings, Data->Title);
+	int32_t x=(int32_t)Position.x, y=(int32_t)Position.y;
+	int32_t TextX, TextY, TextWidth, TextHeight;
+	DrawRect_t Rect;
+
+	Font_MeasureText(StringPool_GetString(&UI->Strings, Data->Title), Length, &TextWidth, &TextHeight);
+
+	switch(Control->Type)
+	{
+		case UI_CONTROL_CHECKBOX:
 		{
-			case UI_CONTROL_BUTTON:
-			{
-				uint32_t x=(uint32_t)Control->Position.x;
-				uint32_t y=(uint32_t)Control->Position.y;
-				uint32_t w=(uint32_t)Control->Button.Size.x;
-				uint32_t h=(uint32_t)Control->Button.Size.y;
-				uint32_t textlen=(uint32_t)strlen(Control->Button.TitleText);
-
-				fillroundedrect(ddsd, x, y, x+w, y+h, 5, (float[]){ 1.0f, 1.0f, 1.0f });
-				fillroundedrect(ddsd, x+1, y+1, x+w, y+h, 5, (float[]){ 0.25f, 0.25f, 0.25f });
-				Font_Print(ddsd, x+(w-textlen*FONT_WIDTH)/2, y+(h-FONT_HEIGHT)/2, "%s", Control->Button.TitleText);
-				break;
-			}
+			int32_t r=(int32_t)Control->Radius;
 
-			case UI_CONTROL_CHECKBOX:
-			{
-				uint32_t x=(uint32_t)Control->Position.x;
-				uint32_t y=(uint32_t)Control->Position.y;
-				uint32_t r=(uint32_t)Control->CheckBox.Radius;
+			Rect=(DrawRect_t) { x-r, y-r, x+r+1, y+r+1 };
+			TextX=x+r+2;
+			TextY=y-(FONT_HEIGHT/2);
+			break;
+		}
+
+		case UI_CONTROL_PANEL:
+			Rect=(DrawRect_t) { x, y, x+(int32_t)Control->Size.x, y+(int32_t)Control->Size.y };
+			TextX=x+5;
+			TextY=y+5;
+			break;
 
-				circle(ddsd, x, y, r, (float[]){ 1.0f, 1.0f, 1.0f });
-				circle(ddsd, x+1, y+1, r, (float[]){ 0.25f, 0.25f, 0.25f });
-				Font_Print(ddsd, x+r+2, y-(FONT_HEIGHT/2), "%s", Control->CheckBox.TitleText);
+		// Buttons and bar graphs, title centered on the box
+		default:
+		{
+			int32_t w=(int32_t)Control->Size.x;
+			int32_t h=(int32_t)Control->Size.y;
 
-				if(Control->CheckBox.Value)
-					fillcircle(ddsd, x, y, r-3, (float *)&Control->Color.x);
-				break;
-			}
+			Rect=(DrawRect_t) { x, y, x+w, y+h };
+			TextX=x+(w-(int32_t)Length*FONT_WIDTH)/2;
+			TextY=y+(h-FONT_HEIGHT)/2;
+			break;
+		}
+	}
 
-			case UI_CONTROL_BARGRAPH:
-			{
-				uint32_t x=(uint32_t)Control->Position.x;
-				uint32_t y=(uint32_t)Control->Position.y;
-				uint32_t w=(uint32_t)Control->BarGraph.Size.x;
-				uint32_t h=(uint32_t)Control->BarGraph.Size.y;
-				uint32_t textlen=(uint32_t)strlen(Control->BarGraph.TitleText);
-				float normalize_value=(Control->BarGraph.Value-Control->BarGraph.Min)/(Control->BarGraph.Max-Control->BarGraph.Min);
-				uint32_t value=(uint32_t)(normalize_value*(Control->BarGraph.Size.x-6));
-
-				roundedrect(ddsd, x, y, x+w, y+h, 5, (float[]){ 1.0f, 1.0f, 1.0f });
-				roundedrect(ddsd, x+1, y+1, x+w, y+h, 5, (float[]){ 0.25f, 0.25f, 0.25f });
-				fillroundedrect(ddsd, x+3, y+3, x+3+value, y-3+h, 2, (float *)&Control->Color.x);
-				Font_Print(ddsd, x+(w-textlen*FONT_WIDTH)/2, y+(h-FONT_HEIGHT)/2, "%s", Control->BarGraph.TitleText);
-				break;
-			}
+	if(TextWidth>0)
+	{
+		Rect.MinX=min(Rect.MinX, TextX);
+		Rect.MinY=min(Rect.MinY, TextY);
+		Rect.MaxX=max(Rect.MaxX, TextX+TextWidth-1);
+		Rect.MaxY=max(Rect.MaxY, TextY+TextHeight-1);
+	}
+
+	return Rect;
+}
+
+// Records one control at Origin (its panel's position on screen, or the UI's) inside Clip (its panel's, or the viewport),
+// and for a panel everything in it.
+static void UI_BuildControl(UI_t *UI, UI_Builder_t *Builder, UI_Control_t *Control, vec2 Origin, const DrawRect_t *Clip)
+{
+	RenderTarget_t *Target=Builder->Target;
+	UI_ControlData_t *Data=UI_GetControlData(UI, Control);
+	const DrawRect_t ControlClip=*Clip;
+
+	// Moving or resizing a panel moves or clips what's in it without touching it, catch that here
+	if(Data->Origin.x!=Origin.x||Data->Origin.y!=Origin.y||
+	   Data->Clip.MinX!=ControlClip.MinX||Data->Clip.MinY!=ControlClip.MinY||Data->Clip.MaxX!=ControlClip.MaxX||Data->Clip.MaxY!=ControlClip.MaxY)
+	{
+		UI_InvalidateControl(UI, Control);
+		Data->Origin=Origin;
+		Data->Clip=ControlClip;
+	}
+
+	const vec2 Position=Vec2_Addv(Origin, Control->Position);
+
+	// Entirely outside, nothing of it (or of what's in it for a panel) is recorded
+	if(UI_RectEmpty(UI_IntersectRect(UI_GetDrawRect(UI, Control, Data, Position), *Clip)))
+	{
+		if(Control->Flags&UI_CONTROL_DIRTY)
+		{
+			Control->Flags&=~UI_CONTROL_DIRTY;
+			Control->Bounds=(DrawRect_t) { 0, 0, -1, -1 };
+		}
+
+		UI->Stats.NumCulled++;
+		return;
+	}
+
+	UI->Stats.NumDrawn++;
+
+	size_t Start=DrawList_GetSize(&UI->DrawList);
+	const uint32_t Gray=(Control->Flags&UI_CONTROL_HOVER)?Builder->Highlight:Builder->Gray;
+
+	switch(Control->Type)
+	{
+		case UI_CONTROL_BUTTON:
+		{
+			int32_t x=(int32_t)Position.x;
+			int32_t y=(int32_t)Position.y;
+			int32_t w=(int32_t)Control->Size.x;
+			int32_t h=(int32_t)Control->Size.y;
+			int32_t textlen=(int32_t)StringPool_GetLength(&UI->Strings, Data->Title);
+
+			fillroundedrect(Target, x, y, x+w, y+h, 5, Builder->White);
+			fillroundedrect(Target, x+1, y+1, x+w, y+h, 5, Gray);
+			Font_PrintText(Target, x+(w-textlen*FONT_WIDTH)/2, y+(h-FONT_HEIGHT)/2, StringPool_GetString(&UI->Strings, Data->Title), textlen);
+			break;
+		}
+
+		case UI_CONTROL_CHECKBOX:
+		{
+			int32_t x=(int32_t)Position.x;
+			int32_t y=(int32_t)Position.y;
+			int32_t r=(int32_t)Control->Radius;
+
+			circle(Target, x, y, r, Builder->White);
+			circle(Target, x+1, y+1, r, Gray);
+			Font_PrintText(Target, x+r+2, y-(FONT_HEIGHT/2), StringPool_GetString(&UI->Strings, Data->Title), StringPool_GetLength(&UI->Strings, Data->Title));
+
+			if(Data->CheckBox.Value)
+				fillcircle(Target, x, y, r-3, Control->PackedColor);
+			break;
+		}
+
+		case UI_CONTROL_BARGRAPH:
+		{
+			int32_t x=(int32_t)Position.x;
+			int32_t y=(int32_t)Position.y;
+			int32_t w=(int32_t)Control->Size.x;
+			int32_t h=(int32_t)Control->Size.y;
+			int32_t textlen=(int32_t)StringPool_GetLength(&UI->Strings, Data->Title);
+			float normalize_value=(Data->BarGraph.Value-Data->BarGraph.Min)/(Data->BarGraph.Max-Data->BarGraph.Min);
+			int32_t value=(int32_t)(normalize_value*(Control->Size.x-6));
+
+			roundedrect(Target, x, y, x+w, y+h, 5, Builder->White);
+			roundedrect(Target, x+1, y+1, x+w, y+h, 5, Gray);
+			fillroundedrect(Target, x+3, y+3, x+3+value, y-3+h, 2, Control->PackedColor);
+			Font_PrintText(Target, x+(w-textlen*FONT_WIDTH)/2, y+(h-FONT_HEIGHT)/2, StringPool_GetString(&UI->Strings, Data->Title), textlen);
+			break;
+		}
+
+		case UI_CONTROL_PANEL:
+		{
+			int32_t x=(int32_t)Position.x;
+			int32_t y=(int32_t)Position.y;
+			int32_t w=(int32_t)Control->Size.x;
+			int32_t h=(int32_t)Control->Size.y;
+
+			fillroundedrect(Target, x, y, x+w, y+h, 5, Builder->White);
+			fillroundedrect(Target, x+1, y+1, x+w, y+h, 5, Control->PackedColor);
+			Font_PrintText(Target, x+5, y+5, StringPool_GetString(&UI->Strings, Data->Title), StringPool_GetLength(&UI->Strings, Data->Title));
+			break;
+		}
+
+		case UI_CONTROL_SPRITE:
+			break;
+
+		case UI_CONTROL_CURSOR:
+			break;
+
+		default:
+			break;
+	}
+
+	// The old bounds were damaged when it was invalidated, now the new ones
+	DrawRect_t Bounds=DrawList_GetBounds(&UI->DrawList, Start, DrawList_GetSize(&UI->DrawList));
+
+	Bounds=UI_IntersectRect(Bounds, *Clip);
+
+	// Only the shape was outside, but nothing shows
+	if(UI_RectEmpty(Bounds))
+		DrawList_Truncate(&UI->DrawList, Start);
+
+	// Swap the control's commands for one masked blit of its bitmap, rendering it first if it changed
+	if(Builder->Cached&&!UI_RectEmpty(Bounds)&&(int64_t)(Bounds.MaxX-Bounds.MinX+1)*(Bounds.MaxY-Bounds.MinY+1)<=UI_CACHE_MAX_PIXELS)
+	{
+		const BitmapCache_Entry_t *Entry=NULL;
+
+		if(Control->Flags&UI_CONTROL_DIRTY)
+			BitmapCache_Release(&UI->Cache, Control->CacheHandle, Control->ID);
+		else
+			Entry=BitmapCache_Lookup(&UI->Cache, Control->CacheHandle, Control->ID, Builder->BytesPerPixel);
+
+		if(Entry==NULL)
+			Entry=BitmapCache_Store(&UI->Cache, &Control->CacheHandle, Control->ID, &UI->DrawList, Start, DrawList_GetSize(&UI->DrawList), Bounds, Builder->BytesPerPixel);
+
+		if(Entry)
+		{
+			DrawList_Truncate(&UI->DrawList, Start);
+			maskblit(Target, Entry->Bounds.MinX, Entry->Bounds.MinY, Entry->Pixels, Entry->Pitch, Entry->Mask, Entry->MaskPitch, Entry->Width, Entry->Height);
+		}
+	}
+
+	if(Control->Flags&UI_CONTROL_DIRTY)
+	{
+		Damage_Add(&UI->Damage, Bounds);
+		Control->Flags&=~UI_CONTROL_DIRTY;
+	}
+
+	Control->Bounds=Bounds;
+
+	if(Control->Type!=UI_CONTROL_PANEL)
+		return;
+
+	// What's in a panel only shows inside of it, and only what's on screen of that
+	DrawRect_t ChildClip=
+	{
+		(int32_t)Position.x, (int32_t)Position.y,
+		(int32_t)(Position.x+Control->Size.x), (int32_t)(Position.y+Control->Size.y)
+	};
+
+	ChildClip=UI_IntersectRect(ChildClip, *Clip);
+
+	if(UI_RectEmpty(ChildClip))
+		return;
+
+	DrawList_AddClip(&UI->DrawList, &ChildClip);
+
+	for(uint32_t i=0;i<List_GetCount(&Data->Panel.Children);i++)
+	{
+		UI_Control_t *Child=UI_FindControlByID(UI, *(uint32_t *)List_GetPointer(&Data->Panel.Children, i));
+
+		// Stays dirty while hidden, so it's damaged again when it shows
+		if(Child==NULL||(Child->Flags&UI_CONTROL_HIDDEN))
+			continue;
+
+		UI_BuildControl(UI, Builder, Child, Position, &ChildClip);
+	}
+
+	// Back to the panel's own clip
+	DrawList_AddClip(&UI->DrawList, Clip);
+}
+
+// Records every control into the retained draw list.
+static void UI_BuildDrawList(UI_t *UI, uint32_t BytesPerPixel)
+{
+	// Nothing is drawn here, the primitives only need a target to record through
+	RenderTarget_t Recorder={ .List=&UI->DrawList };
+
+	UI_Builder_t Builder=
+	{
+		.Target=&Recorder,
+		.BytesPerPixel=BytesPerPixel,
+		// Bitmaps need to know the pixel size, a target that only records doesn't say
+		.Cached=BytesPerPixel&&BitmapCache_GetStats(&UI->Cache).Budget,
+		.White=Draw_PackColor(Vec3b(1.0f)),
+		.Gray=Draw_PackColor(Vec3b(0.25f)),
+		.Highlight=Draw_PackColor(Vec3b(0.4f)),
+		.Viewport=
+		{
+			(int32_t)UI->Position.x, (int32_t)UI->Position.y,
+			(int32_t)(UI->Position.x+UI->Size.x)-1, (int32_t)(UI->Position.y+UI->Size.y)-1
 		}
+	};
+
+	DrawList_Clear(&UI->DrawList);
+	BitmapCache_BeginFrame(&UI->Cache);
+	UI->Stats=(UI_Stats_t) { 0 };
+
+	// Whatever's left partly outside of the viewport is cut at its edge
+	DrawList_AddClip(&UI->DrawList, &Builder.Viewport);
+
+	// Panels draw what's in them, so only top level controls start here
+	for(uint32_t i=0;i<List_GetCount(&UI->Controls);i++)
+	{
+		UI_Control_t *Control=List_GetPointer(&UI->Controls, i);
+		const UI_ControlData_t *Data=List_GetPointer(&UI->ControlData, i);
+
+		if(Data->Parent!=UI_NO_PARENT||(Control->Flags&UI_CONTROL_HIDDEN))
+			continue;
+
+		UI_BuildControl(UI, &Builder, Control, UI->Position, &Builder.Viewport);
+	}
+
+	DrawList_AddClip(&UI->DrawList, NULL);
+
+	// Nothing from the last build is referenced anymore, so the cache can shrink back to its budget
+	BitmapCache_Trim(&UI->Cache);
+}
+
+UI_Stats_t UI_GetStats(const UI_t *UI)
+{
+	if(UI==NULL)
+		return (UI_Stats_t) { 0 };
+
+	return UI->Stats;
+}
+
+// Every control's screen position or clip changes with it, the rebuild catches and damages each one
+void UI_SetViewport(UI_t *UI, vec2 Position, vec2 Size)
+{
+	if(UI==NULL)
+		return;
+
+	UI->Position=Position;
+	UI->Size=Size;
+	UI->DrawListDirty=true;
+	UI->HitEpoch++;
+}
+
+void UI_SetCacheBudget(UI_t *UI, size_t Budget)
+{
+	if(UI==NULL)
+		return;
+
+	BitmapCache_SetBudget(&UI->Cache, Budget);
+	UI->DrawListDirty=true;
+}
+
+BitmapCache_Stats_t UI_GetCacheStats(const UI_t *UI)
+{
+	if(UI==NULL)
+		return (BitmapCache_Stats_t) { 0 };
+
+	return BitmapCache_GetStats(&UI->Cache);
+}
+
+// Draws (or records) all controls. Any rebuild adds the damaged areas to UI->Damage, which the caller takes and clears
+// before deciding what to redraw, so record the UI first when drawing only the damaged areas.
+bool UI_Draw(UI_t *UI, RenderTarget_t *Target)
+{
+	if(UI==NULL||Target==NULL)
+		return false;
+
+	UI_SyncBindings(UI);
+
+	// Cached bitmaps are in the target's pixel format, so a different one needs a rebuild
+	if(UI->DrawListDirty||Target->BytesPerPixel!=UI->BytesPerPixel)
+	{
+		UI_BuildDrawList(UI, Target->BytesPerPixel);
+		UI->BytesPerPixel=Target->BytesPerPixel;
+		UI->DrawListDirty=false;
 	}
 
+	// Splice into a frame being recorded, otherwise draw it now
+	if(Target->List)
+		return DrawList_Append(Target->List, &UI->DrawList);
+
+	DrawList_Execute(&UI->DrawList, Target);
+
 	return true;
 }
@@ -3,15 +3,42 @@
 
 #include <stdint.h>
 #include <stdbool.h>
-#include <ddraw.h>
+#include "../draw/draw.h"
+#include "../draw/drawlist.h"
+#include "../draw/damage.h"
+#include "../draw/bitmapcache.h"
 #include "../utils/list.h"
+#include "../utils/grid.h"
+#include "../utils/stringpool.h"
 
-// Does the callback really need args? (userdata?)
+// Called with the button's callback data, see UI_UpdateButtonCallbackData
 typedef void (*UIControlCallback)(void *arg);
 
-#define UI_CONTROL_TITLETEXT_MAX 128
+// Control IDs are slot map handles, the low bits pick a slot and the high bits are that slot's generation.
+// A slot's generation moves on when it's freed, so an old ID can't find whatever reuses the slot.
+#define UI_ID_INDEX_BITS 20
+#define UI_ID_INDEX_MASK ((1u<<UI_ID_INDEX_BITS)-1)
+// 12 bits, so a slot can only be reused 4095 times before an old ID would match again. A slot whose generation would
+// wrap is retired instead, it never goes back on the free list (it costs one of UI_MAX_CONTROLS slots, 8 bytes).
+#define UI_ID_GENERATION_MASK (UINT32_MAX>>UI_ID_INDEX_BITS)
+// Generation of a retired slot, wider than any ID's generation so nothing can match it
+#define UI_SLOT_RETIRED (UI_ID_GENERATION_MASK+1)
+// The last slot index is never handed out, so no ID can be UINT32_MAX
+#define UI_MAX_CONTROLS UI_ID_INDEX_MASK
+// Parent of a control that isn't in a panel
+#define UI_NO_PARENT UINT32_MAX
 
-#define UI_HASHTABLE_MAX 8192
+// Default memory for cached control bitmaps, see UI_SetCacheBudget
+#define UI_CACHE_BUDGET (8*1024*1024)
+// Copying a cached pixel costs about as much as filling one, so only controls small enough to be mostly text are cached
+#define UI_CACHE_MAX_PIXELS (128*128)
+
+// Default time UI_DispatchEvents gets a frame in seconds, enough for a few light callbacks without costing a frame
+#define UI_EVENT_BUDGET 0.002
+
+// Hit testing only looks at controls in the grid cell under the cursor, cells about the size of a typical control
+// keep both the number of cells a control spans and the number sharing a cell low
+#define UI_HIT_CELL_SIZE 64.0f
 
 typedef enum
 {
@@ -20,16 +47,69 @@ typedef enum
 	UI_CONTROL_BARGRAPH,
 	UI_CONTROL_SPRITE,
 	UI_CONTROL_CURSOR,
+	UI_CONTROL_PANEL,
 	UI_NUM_CONTROLTYPE
 } UI_ControlType;
 
+// Control flags
+#define UI_CONTROL_DIRTY	0x01	// Changed since it was last drawn
+#define UI_CONTROL_READONLY	0x02	// Bar graph ignores the cursor
+#define UI_CONTROL_BOUND	0x04	// In UI->Bindings, see UI_SyncBindings
+#define UI_CONTROL_HIDDEN	0x08	// Not drawn or hit, nor is anything in it if it's a panel
+#define UI_CONTROL_HOVER	0x10	// Under the cursor, drawn highlighted
+
+// The part of a control every draw list rebuild and linear walk touches, kept small and packed together.
+// Anything only needed by one type or one call lives in the matching UI_ControlData_t.
 typedef struct
 {
-	// Common to all controls
 	UI_ControlType Type;
 	uint32_t ID;
 	vec2 Position;
+
+	// Relative to the panel it's in, if any
+	union
+	{
+		// Buttons, bar graphs, sprites and panels
+		vec2 Size;
+		// Check boxes and cursors
+		float Radius;
+	};
+
+	// Color packed to the surface format, updated whenever the color is set
+	uint32_t PackedColor;
+	uint32_t Flags;
+
+	// Screen area covered the last time the control was drawn
+	DrawRect_t Bounds;
+
+	// Cached bitmap of the control, BITMAPCACHE_NONE until first drawn
+	uint32_t CacheHandle;
+} UI_Control_t;
+
+// The rest of a control, in a second list in the same order as the controls, see UI_GetControlData
+typedef struct
+{
 	vec3 Color;
+	// Caller's storage the color follows, NULL if not bound
+	vec3 *ColorBinding;
+
+	// Caller defined, lets a whole set of controls be removed at once (0 is no group)
+	uint32_t Group;
+
+	// Cells of UI->HitGrid the control's hit area is in, kept current by UI_ReindexControl.
+	// Only controls outside of panels are in the grid, hits on a panel are passed on to what's in it.
+	Grid_Range_t HitCells;
+
+	// ID of the panel the control is in, or UI_NO_PARENT
+	uint32_t Parent;
+
+	// World position of the parent and the clip from its panels, as last drawn. The draw list rebuild keeps these
+	// current, so moving a panel doesn't touch anything in it, and anything whose either changed is redrawn.
+	vec2 Origin;
+	DrawRect_t Clip;
+
+	// Title text in UI->Strings, STRINGPOOL_NONE for none
+	uint32_t Title;
 
 	// Specific to type
 	union
@@ -37,26 +117,22 @@ typedef struct
 		// Button type
 		struct
 		{
-			char TitleText[UI_CONTROL_TITLETEXT_MAX];
-			vec2 Size;
 			UIControlCallback Callback;
+			void *CallbackData;
 		} Button;
 
 		// CheckBox type, should this also have a callback for flexibility?
 		struct
 		{
-			char TitleText[UI_CONTROL_TITLETEXT_MAX];
-			float Radius;
 			bool Value;
+			bool *Binding;
 		} CheckBox;
 
 		// BarGraph type
 		struct
 		{
-			char TitleText[UI_CONTROL_TITLETEXT_MAX];
-			vec2 Size;
-			bool Readonly;
 			float Min, Max, Value;
+			float *Binding;
 		} BarGraph;
 
 		// Sprite type
@@ -64,37 +140,202 @@ typedef struct
 		{
 //			uint32_t DescriptorSetOffset;
 //			VkuImage_t *Image;
-			vec2 Size;
 			float Rotation;
 		} Sprite;
 
-		// Cursur type
+		// Panel type, IDs of the controls in it in draw order
 		struct
 		{
-			float Radius;
-		} Cursor;
+			List_t Children;
+		} Panel;
 	};
-} UI_Control_t;
+} UI_ControlData_t;
+
+// Properties a batch can write, and the value each takes
+typedef enum
+{
+	UI_PROPERTY_POSITION=0,	// vec2, any control
+	UI_PROPERTY_SIZE,		// vec2, buttons, bar graphs, sprites and panels
+	UI_PROPERTY_RADIUS,		// float, check boxes and cursors
+	UI_PROPERTY_COLOR,		// vec3, any control
+	UI_PROPERTY_VALUE,		// float for bar graphs, bool for check boxes
+	UI_PROPERTY_MIN,		// float, bar graphs
+	UI_PROPERTY_MAX,		// float, bar graphs
+	UI_PROPERTY_READONLY,	// bool, bar graphs
+	UI_PROPERTY_ROTATION,	// float, sprites
+	UI_NUM_PROPERTY
+} UI_Property;
+
+typedef enum
+{
+	UI_BATCH_FLOAT=0,
+	UI_BATCH_BOOL,
+	UI_BATCH_VEC2,
+	UI_BATCH_VEC3
+} UI_BatchValueType;
 
 typedef struct
 {
-	// Position and size of whole UI system
-	vec2 Position, Size;
+	uint32_t ID;
+	uint8_t Property, ValueType;
+
+	union
+	{
+		float Float;
+		bool Bool;
+		vec2 Vec2;
+		vec3 Vec3;
+	};
+} UI_BatchWrite_t;
+
+typedef enum
+{
+	UI_EVENT_CLICK=0,
+	UI_NUM_EVENT
+} UI_EventType;
+
+// Queued by UI_TestHit, everything needed to run it is taken at the time so it can be run anywhere later
+typedef struct
+{
+	uint32_t ID;
+	UI_EventType Type;
+	UIControlCallback Callback;
+	void *Data;
+} UI_Event_t;
+
+typedef struct
+{
+	// Index into the control list, or the next free slot
+	uint32_t Index;
+	uint32_t Generation;
+} UI_Slot_t;
+
+// Result of a hit test and the area around it where the result can't change, in UI space.
+// Only good while Epoch matches UI->HitEpoch.
+typedef struct
+{
+	uint32_t ID, Epoch;
 
-	// Base ID for generating IDs
-	uint32_t IDBase;
+	// Points from Min up to (not including) Max get the same result, an empty area means test every time
+	vec2 Min, Max;
 
-	// List of controls in UI
+	// Where the control's panel (or the UI) is, to get from UI space into the control's
+	vec2 Origin;
+} UI_HitCache_t;
+
+// Counts from the last draw list rebuild
+typedef struct
+{
+	// Controls recorded, and controls rejected as entirely outside the viewport or their panel.
+	// A rejected panel counts once, what's in it isn't visited.
+	uint32_t NumDrawn, NumCulled;
+} UI_Stats_t;
+
+typedef struct
+{
+	// Where the UI sits on screen and how much of it shows, controls are relative to Position
+	vec2 Position, Size;
+
+	// List of controls in UI, and their UI_ControlData_t at the same index
 	List_t Controls;
+	List_t ControlData;
+
+	// Slot map from IDs to controls, free slots are chained through Index starting at FreeSlot
+	List_t Slots;
+	uint32_t FreeSlot;
 
-	// Hashtable for quick lookup by ID
-	UI_Control_t *Controls_Hashtable[UI_HASHTABLE_MAX];
+	// Retained draw commands for all controls, only rebuilt by UI_Draw after something changed
+	DrawList_t DrawList;
+	bool DrawListDirty;
+
+	// Controls are rendered once into cached bitmaps and blitted from there, the list is built for this pixel size
+	BitmapCache_t Cache;
+	uint32_t BytesPerPixel;
+
+	// Old and new bounds of every control changed since the caller last took it, see UI_Draw
+	Damage_t Damage;
+
+	// Controls by where they can be hit, for UI_TestHit
+	Grid_t HitGrid;
+
+	// Control titles, each different string is only stored once
+	StringPool_t Strings;
+
+	// Callbacks waiting to run, oldest first from NextEvent
+	List_t Events;
+	uint32_t NextEvent;
+
+	// IDs of controls with bound values, UI_SyncBindings drops any that are gone or unbound
+	List_t Bindings;
+
+	// Writes queued since UI_BeginBatch, applied by UI_CommitBatch, and space to sort them.
+	// A plain array rather than a list, it's appended to thousands of times a frame.
+	UI_BatchWrite_t *BatchWrites;
+	uint32_t NumBatchWrites, MaxBatchWrites;
+	bool Batching;
+	uint64_t *BatchScratch;
+	uint32_t BatchScratchSize;
+
+	UI_Stats_t Stats;
+
+	// Bumped by anything that changes what's under a point, which drops both caches
+	uint32_t HitEpoch;
+
+	// Control under the cursor (hover) and the one taking the drag since the button went down (capture)
+	uint32_t HoverID, CaptureID;
+	UI_HitCache_t Hover, Capture;
 } UI_t;
 
 bool UI_Init(UI_t *UI, vec2 Position, vec2 Size);
 void UI_Destroy(UI_t *UI);
 
+// Gives the control an ID and adds it along with its data, for the UI_Add* functions. Returns the ID, or UINT32_MAX on failure.
+// The control owns Data->Title from here on, even if adding it fails.
+uint32_t UI_AddControl(UI_t *UI, UI_Control_t *Control, const UI_ControlData_t *Data);
+// NULL for IDs that were never handed out or whose control is gone
 UI_Control_t *UI_FindControlByID(UI_t *UI, uint32_t ID);
+// Control must be one of UI's, from UI_FindControlByID or the control list
+UI_ControlData_t *UI_GetControlData(UI_t *UI, const UI_Control_t *Control);
+
+// Removes a control, its ID stops working straight away and its slot gets reused later.
+// Swaps the last control into its place, so that one moves in the draw order. Removing a panel removes what's in it.
+bool UI_RemoveControl(UI_t *UI, uint32_t ID);
+// Moves a control into a panel, on top of what's already there, or back out with UI_NO_PARENT.
+// Its position is taken as relative to the panel from then on, and it's clipped to the panel.
+bool UI_SetControlParent(UI_t *UI, uint32_t ID, uint32_t ParentID);
+// Hidden controls aren't drawn or hit, hiding a panel hides everything in it
+bool UI_SetControlVisible(UI_t *UI, uint32_t ID, bool Visible);
+bool UI_SetControlGroup(UI_t *UI, uint32_t ID, uint32_t Group);
+// Removes every control in Group in one pass, keeping the order of the rest. Returns how many went.
+uint32_t UI_RemoveGroup(UI_t *UI, uint32_t Group);
+// Only invalidates the control if the text actually changed
+void UI_SetControlTitle(UI_t *UI, UI_Control_t *Control, const char *TitleText);
+// Only invalidates the control if the packed color changed, also writes to the bound color if there is one
+void UI_SetControlColor(UI_t *UI, UI_Control_t *Control, vec3 Color);
+// Moves a control to the hit grid cells for its current position and size, call after changing either
+void UI_ReindexControl(UI_t *UI, UI_Control_t *Control);
+// Puts a control in UI->Bindings for UI_SyncBindings, for the UI_Bind* functions
+bool UI_AddBinding(UI_t *UI, UI_Control_t *Control);
+// Flags a control for redraw, call before changing anything that affects how it looks
+void UI_InvalidateControl(UI_t *UI, UI_Control_t *Control);
+// Drops cached hover and drag results, call after changing what can be hit without UI_ReindexControl
+void UI_InvalidateHits(UI_t *UI);
+// Zero turns caching off, the cache is only trimmed to a new budget on the next rebuild
+void UI_SetCacheBudget(UI_t *UI, size_t Budget);
+BitmapCache_Stats_t UI_GetCacheStats(const UI_t *UI);
+UI_Stats_t UI_GetStats(const UI_t *UI);
+// Moves or resizes the visible window onto the controls, only what's inside it is drawn or hit
+void UI_SetViewport(UI_t *UI, vec2 Position, vec2 Size);
+
+// Binds a control's color to caller owned storage, which it then follows and writes back to, NULL unbinds.
+// The storage has to outlive the binding, the control takes its value straight away.
+bool UI_BindControlColor(UI_t *UI, uint32_t ID, vec3 *Color);
+// Checks every bound value against what the control last had and invalidates only the ones that changed.
+// UI_Draw does this first, call it before UI_IsInvalidated if bound values change other than through the UI.
+void UI_SyncBindings(UI_t *UI);
+
+// True while anything changed since the last UI_Draw handed over its damage, an idle UI stays false
+bool UI_IsInvalidated(const UI_t *UI);
 
 // Buttons
 uint32_t UI_AddButton(UI_t *UI, vec2 Position, vec2 Size, vec3 Color, const char *TitleText, UIControlCallback Callback);
@@ -105,6 +346,7 @@ bool UI_UpdateButtonSize(UI_t *UI, uint32_t ID, vec2 Size);
 bool UI_UpdateButtonColor(UI_t *UI, uint32_t ID, vec3 Color);
 bool UI_UpdateButtonTitleText(UI_t *UI, uint32_t ID, const char *TitleText);
 bool UI_UpdateButtonCallback(UI_t *UI, uint32_t ID, UIControlCallback Callback);
+bool UI_UpdateButtonCallbackData(UI_t *UI, uint32_t ID, void *Data);
 
 // Check boxes
 uint32_t UI_AddCheckBox(UI_t *UI, vec2 Position, float Radius, vec3 Color, const char *TitleText, bool Value);
@@ -117,6 +359,8 @@ bool UI_UpdateCheckBoxTitleText(UI_t *UI, uint32_t ID, const char *TitleText);
 bool UI_UpdateCheckBoxValue(UI_t *UI, uint32_t ID, bool Value);
 
 bool UI_GetCheckBoxValue(UI_t *UI, uint32_t ID);
+// Same as UI_BindControlColor, clicking the check box writes to Value
+bool UI_BindCheckBoxValue(UI_t *UI, uint32_t ID, bool *Value);
 
 // Bar graphs
 uint32_t UI_AddBarGraph(UI_t *UI, vec2 Position, vec2 Size, vec3 Color, const char *TitleText, bool Readonly, float Min, float Max, float Value);
@@ -134,9 +378,51 @@ bool UI_UpdateBarGraphValue(UI_t *UI, uint32_t ID, float Value);
 float UI_GetBarGraphMin(UI_t *UI, uint32_t ID);
 float UI_GetBarGraphMax(UI_t *UI, uint32_t ID);
 float UI_GetBarGraphValue(UI_t *UI, uint32_t ID);
+// The bound storage if there is one, otherwise the control's own value, which isn't checked for changes
+float *UI_GetBarGraphValuePointer(UI_t *UI, uint32_t ID);
+// Same as UI_BindControlColor, dragging the bar graph writes to Value
+bool UI_BindBarGraphValue(UI_t *UI, uint32_t ID, float *Value);
+
+// Panels, containers for other controls (see UI_SetControlParent). Moving one moves what's in it for free.
+uint32_t UI_AddPanel(UI_t *UI, vec2 Position, vec2 Size, vec3 Color, const char *TitleText);
+
+bool UI_UpdatePanel(UI_t *UI, uint32_t ID, vec2 Position, vec2 Size, vec3 Color, const char *TitleText);
+bool UI_UpdatePanelPosition(UI_t *UI, uint32_t ID, vec2 Position);
+bool UI_UpdatePanelSize(UI_t *UI, uint32_t ID, vec2 Size);
+bool UI_UpdatePanelColor(UI_t *UI, uint32_t ID, vec3 Color);
+bool UI_UpdatePanelTitleText(UI_t *UI, uint32_t ID, const char *TitleText);
+
+// Batched updates, for setting many properties a frame (live telemetry and the like). Writes are only checked
+// and applied on commit, sorted by control so each is found, updated and invalidated once, in list order.
+// Later writes to the same property win. Returns false if no batch was begun.
+bool UI_BeginBatch(UI_t *UI);
+bool UI_BatchSetFloat(UI_t *UI, uint32_t ID, UI_Property Property, float Value);
+bool UI_BatchSetBool(UI_t *UI, uint32_t ID, UI_Property Property, bool Value);
+bool UI_BatchSetVec2(UI_t *UI, uint32_t ID, UI_Property Property, vec2 Value);
+bool UI_BatchSetVec3(UI_t *UI, uint32_t ID, UI_Property Property, vec3 Value);
+// Applies and ends the batch. Returns how many writes were applied, the rest had a dead ID or didn't fit the control.
+uint32_t UI_CommitBatch(UI_t *UI);
+
+// Button callbacks don't run from UI_TestHit, they're queued to run at a point of the caller's choosing.
+// Runs queued callbacks oldest first until Budget seconds have gone (0 for no limit), the rest wait for the next call.
+// At least one runs each call, so a callback longer than the budget can't hold the queue up. Returns how many ran.
+uint32_t UI_DispatchEvents(UI_t *UI, double Budget);
+// Takes the oldest event off the queue without running it, to hand to another thread. False if there are none.
+bool UI_PopEvent(UI_t *UI, UI_Event_t *Event);
+bool UI_HasPendingEvents(const UI_t *UI);
+// Adds to the queue, for controls and callers raising their own events
+bool UI_QueueEvent(UI_t *UI, uint32_t ID, UI_EventType Type, UIControlCallback Callback, void *Data);
 
 uint32_t UI_TestHit(UI_t *UI, vec2 Position);
 bool UI_ProcessControl(UI_t *UI, uint32_t ID, vec2 Position);
-bool UI_Draw(UI_t *UI, DDSURFACEDESC2 ddsd);
+
+// Tracks the control under the cursor, intended for mouse move events while no button is down.
+// Only tests again once the cursor leaves the area the last result holds for. Returns the hovered ID or UINT32_MAX.
+uint32_t UI_UpdateHover(UI_t *UI, vec2 Position);
+// UI_TestHit captures what it hit, drags then go to it wherever the cursor is until released.
+// Returns false when nothing is captured.
+bool UI_ProcessCapture(UI_t *UI, vec2 Position);
+void UI_ReleaseCapture(UI_t *UI);
+bool UI_Draw(UI_t *UI, RenderTarget_t *Target);
 
 #endif
@@ -0,0 +1,33 @@
+// clock_gettime and CLOCK_MONOTONIC are POSIX, strict C modes hide them otherwise
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include "clock.h"
+
+#ifdef _WIN32
+#include <windows.h>
+
+double GetClock(void)
+{
+	static uint64_t Frequency=0;
+	uint64_t Count;
+
+	if(!Frequency)
+		QueryPerformanceFrequency((LARGE_INTEGER *)&Frequency);
+
+	QueryPerformanceCounter((LARGE_INTEGER *)&Count);
+
+	return (double)Count/Frequency;
+}
+#else
+#include <time.h>
+
+double GetClock(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec+(double)ts.tv_nsec/1000000000.0;
+}
+#endif
@@ -0,0 +1,7 @@
+#ifndef __CLOCK_H__
+#define __CLOCK_H__
+
+// Monotonic high resolution clock in seconds.
+double GetClock(void);
+
+#endif
@@ -0,0 +1,168 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <float.h>
+#include "../math/math.h"
+#include "list.h"
+#include "grid.h"
+
+bool Grid_Init(Grid_t *Grid, vec2 Size, float CellSize)
+{
+	if(Grid==NULL||!(CellSize>0.0f))
+		return false;
+
+	Grid->CellSize=CellSize;
+	Grid->Width=max((int32_t)ceilf(Size.x/CellSize), 1);
+	Grid->Height=max((int32_t)ceilf(Size.y/CellSize), 1);
+
+	Grid->Cells=(List_t *)calloc((size_t)Grid->Width*Grid->Height, sizeof(List_t));
+
+	if(Grid->Cells==NULL)
+		return false;
+
+	for(int32_t i=0;i<Grid->Width*Grid->Height;i++)
+	{
+		if(!List_Init(&Grid->Cells[i], sizeof(uint32_t), 0, NULL))
+		{
+			Grid_Destroy(Grid);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void Grid_Destroy(Grid_t *Grid)
+{
+	if(Grid==NULL||Grid->Cells==NULL)
+		return;
+
+	// Cells past a failed init are still zeroed, freeing their NULL buffers is fine
+	for(int32_t i=0;i<Grid->Width*Grid->Height;i++)
+		List_Destroy(&Grid->Cells[i]);
+
+	free(Grid->Cells);
+	Grid->Cells=NULL;
+}
+
+static int32_t Grid_Cell(float Coord, float CellSize, int32_t Count)
+{
+	const float Cell=floorf(Coord/CellSize);
+
+	// Also catches NaN, which fails both compares and lands in the first cell
+	if(!(Cell>0.0f))
+		return 0;
+
+	if(Cell>=(float)Count)
+		return Count-1;
+
+	return (int32_t)Cell;
+}
+
+Grid_Range_t Grid_GetRange(const Grid_t *Grid, vec2 Min, vec2 Max)
+{
+	if(Grid==NULL)
+		return GRID_RANGE_EMPTY;
+
+	return (Grid_Range_t)
+	{
+		Grid_Cell(Min.x, Grid->CellSize, Grid->Width),
+		Grid_Cell(Min.y, Grid->CellSize, Grid->Height),
+		Grid_Cell(Max.x, Grid->CellSize, Grid->Width),
+		Grid_Cell(Max.y, Grid->CellSize, Grid->Height)
+	};
+}
+
+bool Grid_Insert(Grid_t *Grid, uint32_t Key, Grid_Range_t Range)
+{
+	if(Grid==NULL)
+		return false;
+
+	for(int32_t y=Range.MinY;y<=Range.MaxY;y++)
+	{
+		for(int32_t x=Range.MinX;x<=Range.MaxX;x++)
+		{
+			if(!List_Add(&Grid->Cells[y*Grid->Width+x], &Key))
+			{
+				// Take back the cells already done, the rest never had it so removing from them does nothing
+				Grid_Remove(Grid, Key, Range);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void Grid_Remove(Grid_t *Grid, uint32_t Key, Grid_Range_t Range)
+{
+	if(Grid==NULL)
+		return;
+
+	for(int32_t y=Range.MinY;y<=Range.MaxY;y++)
+	{
+		for(int32_t x=Range.MinX;x<=Range.MaxX;x++)
+		{
+			List_t *Cell=&Grid->Cells[y*Grid->Width+x];
+			uint32_t *Keys=(uint32_t *)List_GetBufferPointer(Cell);
+			const uint32_t Count=(uint32_t)List_GetCount(Cell);
+
+			// Order within a cell doesn't matter, so the last key fills the hole
+			for(uint32_t i=0;i<Count;i++)
+			{
+				if(Keys[i]==Key)
+				{
+					Keys[i]=Keys[Count-1];
+					List_Del(Cell, Count-1);
+					break;
+				}
+			}
+		}
+	}
+}
+
+bool Grid_Move(Grid_t *Grid, uint32_t Key, Grid_Range_t *Range, Grid_Range_t NewRange)
+{
+	if(Grid==NULL||Range==NULL)
+		return false;
+
+	// Most moves are small enough to stay within the same cells
+	if(Range->MinX==NewRange.MinX&&Range->MinY==NewRange.MinY&&Range->MaxX==NewRange.MaxX&&Range->MaxY==NewRange.MaxY)
+		return true;
+
+	Grid_Remove(Grid, Key, *Range);
+
+	if(!Grid_Insert(Grid, Key, NewRange))
+	{
+		*Range=GRID_RANGE_EMPTY;
+		return false;
+	}
+
+	*Range=NewRange;
+
+	return true;
+}
+
+void Grid_GetCellBounds(const Grid_t *Grid, vec2 Point, vec2 *Min, vec2 *Max)
+{
+	if(Grid==NULL||Min==NULL||Max==NULL)
+		return;
+
+	const int32_t x=Grid_Cell(Point.x, Grid->CellSize, Grid->Width);
+	const int32_t y=Grid_Cell(Point.y, Grid->CellSize, Grid->Height);
+
+	*Min=Vec2(x>0?(float)x*Grid->CellSize:-FLT_MAX, y>0?(float)y*Grid->CellSize:-FLT_MAX);
+	*Max=Vec2(x<Grid->Width-1?(float)(x+1)*Grid->CellSize:FLT_MAX, y<Grid->Height-1?(float)(y+1)*Grid->CellSize:FLT_MAX);
+}
+
+const uint32_t *Grid_Query(const Grid_t *Grid, vec2 Point, uint32_t *Count)
+{
+	if(Grid==NULL||Count==NULL)
+		return NULL;
+
+	List_t *Cell=&Grid->Cells[Grid_Cell(Point.y, Grid->CellSize, Grid->Height)*Grid->Width+Grid_Cell(Point.x, Grid->CellSize, Grid->Width)];
+
+	*Count=(uint32_t)List_GetCount(Cell);
+
+	return (const uint32_t *)List_GetBufferPointer(Cell);
+}
@@ -0,0 +1,44 @@
+#ifndef __GRID_H__
+#define __GRID_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../math/math.h"
+#include "list.h"
+
+// Inclusive range of cells, empty when Min is past Max
+typedef struct
+{
+	int32_t MinX, MinY, MaxX, MaxY;
+} Grid_Range_t;
+
+#define GRID_RANGE_EMPTY ((Grid_Range_t) { 0, 0, -1, -1 })
+
+// Uniform grid of buckets over an area, each holding the keys of everything whose box overlaps that cell.
+// Boxes and points outside the area are clamped to the edge cells, so nothing is ever missed, only tested more.
+typedef struct
+{
+	float CellSize;
+	int32_t Width, Height;
+	List_t *Cells;
+} Grid_t;
+
+bool Grid_Init(Grid_t *Grid, vec2 Size, float CellSize);
+void Grid_Destroy(Grid_t *Grid);
+
+// Cells covered by the box from Min to Max
+Grid_Range_t Grid_GetRange(const Grid_t *Grid, vec2 Min, vec2 Max);
+
+bool Grid_Insert(Grid_t *Grid, uint32_t Key, Grid_Range_t Range);
+// Range has to be the one Key was inserted with
+void Grid_Remove(Grid_t *Grid, uint32_t Key, Grid_Range_t Range);
+// Moves Key from the cells in *Range to those in NewRange and updates *Range, nothing happens if they're the same cells
+bool Grid_Move(Grid_t *Grid, uint32_t Key, Grid_Range_t *Range, Grid_Range_t NewRange);
+
+// Keys in the cell under Point, a superset of what's actually there
+const uint32_t *Grid_Query(const Grid_t *Grid, vec2 Point, uint32_t *Count);
+// Area of the cell under Point, everywhere in it gets the same keys from Grid_Query.
+// Edge cells take in everything past the edge, so those sides go out to FLT_MAX.
+void Grid_GetCellBounds(const Grid_t *Grid, vec2 Point, vec2 *Min, vec2 *Max);
+
+#endif
@@ -0,0 +1,115 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "clock.h"
+#include "inputqueue.h"
+
+void InputQueue_Init(InputQueue_t *Queue)
+{
+	if(Queue==NULL)
+		return;
+
+	memset(Queue, 0, sizeof(InputQueue_t));
+}
+
+bool InputQueue_IsEmpty(const InputQueue_t *Queue)
+{
+	if(Queue==NULL)
+		return true;
+
+	return Queue->Head==Queue->Tail;
+}
+
+const InputEvent_t *InputQueue_PeekNewest(const InputQueue_t *Queue)
+{
+	if(Queue==NULL||Queue->Head==Queue->Tail)
+		return NULL;
+
+	return &Queue->Events[(Queue->Head-1)&(INPUTQUEUE_SIZE-1)];
+}
+
+bool InputQueue_PushEvent(InputQueue_t *Queue, const InputEvent_t *Event)
+{
+	if(Queue==NULL||Event==NULL||Event->Type>=INPUT_NUM_TYPE)
+		return false;
+
+	// Only the newest position of a run of moves matters, the ones between would be drawn over anyway
+	if(Event->Type==INPUT_MOVE&&Queue->Head!=Queue->Tail)
+	{
+		InputEvent_t *Last=&Queue->Events[(Queue->Head-1)&(INPUTQUEUE_SIZE-1)];
+
+		if(Last->Type==INPUT_MOVE)
+		{
+			*Last=*Event;
+			Queue->NumMerged++;
+			return true;
+		}
+	}
+
+	// Full, dropping the newest keeps what's queued in order
+	if(Queue->Head-Queue->Tail>=INPUTQUEUE_SIZE)
+	{
+		Queue->NumDropped++;
+		return false;
+	}
+
+	Queue->Events[Queue->Head&(INPUTQUEUE_SIZE-1)]=*Event;
+	Queue->Head++;
+
+	return true;
+}
+
+bool InputQueue_Push(InputQueue_t *Queue, InputType Type, uint16_t Code, float X, float Y)
+{
+	InputEvent_t Event=
+	{
+		.Time=GetClock(),
+		.Type=(uint16_t)Type,
+		.Code=Code,
+		.X=X,
+		.Y=Y
+	};
+
+	return InputQueue_PushEvent(Queue, &Event);
+}
+
+void InputQueue_Drain(InputQueue_t *Queue, InputSnapshot_t *Snapshot)
+{
+	if(Queue==NULL||Snapshot==NULL)
+		return;
+
+	Snapshot->NumEvents=0;
+
+	while(Queue->Tail!=Queue->Head)
+	{
+		const InputEvent_t *Event=&Queue->Events[Queue->Tail&(INPUTQUEUE_SIZE-1)];
+
+		Snapshot->Events[Snapshot->NumEvents++]=*Event;
+		Snapshot->Time=Event->Time;
+
+		switch(Event->Type)
+		{
+			case INPUT_MOVE:
+				Snapshot->X=Event->X;
+				Snapshot->Y=Event->Y;
+				break;
+
+			case INPUT_BUTTON_DOWN:
+				Snapshot->X=Event->X;
+				Snapshot->Y=Event->Y;
+				Snapshot->Buttons|=1u<<Event->Code;
+				break;
+
+			case INPUT_BUTTON_UP:
+				Snapshot->X=Event->X;
+				Snapshot->Y=Event->Y;
+				Snapshot->Buttons&=~(1u<<Event->Code);
+				break;
+
+			default:
+				break;
+		}
+
+		Queue->Tail++;
+	}
+}
@@ -0,0 +1,68 @@
+#ifndef __INPUTQUEUE_H__
+#define __INPUTQUEUE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Power of two, a frame's worth of input even at high mouse rates since moves merge as they arrive
+#define INPUTQUEUE_SIZE 256
+
+typedef enum
+{
+	INPUT_MOVE,
+	INPUT_BUTTON_DOWN,
+	INPUT_BUTTON_UP,
+	INPUT_KEY_DOWN,
+	INPUT_KEY_UP,
+	INPUT_NUM_TYPE
+} InputType;
+
+typedef struct
+{
+	// When it happened, on the GetClock timeline
+	double Time;
+	uint16_t Type;
+
+	// Button number or key code
+	uint16_t Code;
+
+	// Cursor position, for moves and buttons
+	float X, Y;
+} InputEvent_t;
+
+// Window procedure pushes, the frame drains. Both on the same thread, so no locking.
+typedef struct
+{
+	InputEvent_t Events[INPUTQUEUE_SIZE];
+	uint32_t Head, Tail;
+
+	// Moves folded into the one before, and events lost to a full queue
+	uint32_t NumMerged, NumDropped;
+} InputQueue_t;
+
+// One frame's input: everything in order, then the state it left behind
+typedef struct
+{
+	InputEvent_t Events[INPUTQUEUE_SIZE];
+	uint32_t NumEvents;
+
+	// Carried over from frame to frame
+	float X, Y;
+	uint32_t Buttons;
+
+	// Newest event this frame, or the last frame's when nothing happened
+	double Time;
+} InputSnapshot_t;
+
+void InputQueue_Init(InputQueue_t *Queue);
+// Timestamps and queues an event. A move straight after another move replaces it, button and key events always queue.
+bool InputQueue_Push(InputQueue_t *Queue, InputType Type, uint16_t Code, float X, float Y);
+// Same, for events that already have a time (replays)
+bool InputQueue_PushEvent(InputQueue_t *Queue, const InputEvent_t *Event);
+bool InputQueue_IsEmpty(const InputQueue_t *Queue);
+// Most recently queued event, or NULL if there's nothing queued. Stays queued.
+const InputEvent_t *InputQueue_PeekNewest(const InputQueue_t *Queue);
+// Moves everything queued into Snapshot and updates its state, Snapshot keeps its state between calls
+void InputQueue_Drain(InputQueue_t *Queue, InputSnapshot_t *Snapshot);
+
+#endif
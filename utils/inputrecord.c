@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "clock.h"
+#include "inputqueue.h"
+#include "inputrecord.h"
+
+#define INPUTRECORD_HEADER_SIZE 16
+#define INPUTRECORD_FRAME_SIZE 6
+#define INPUTRECORD_EVENT_SIZE 6
+
+// Written a byte at a time, so recordings move between machines regardless of endianness or struct padding
+static void InputRecord_Put16(uint8_t *Data, uint16_t Value)
+{
+	Data[0]=(uint8_t)Value;
+	Data[1]=(uint8_t)(Value>>8);
+}
+
+static void InputRecord_Put32(uint8_t *Data, uint32_t Value)
+{
+	InputRecord_Put16(Data, (uint16_t)Value);
+	InputRecord_Put16(Data+2, (uint16_t)(Value>>16));
+}
+
+static uint16_t InputRecord_Get16(const uint8_t *Data)
+{
+	return (uint16_t)(Data[0]|(Data[1]<<8));
+}
+
+static uint32_t InputRecord_Get32(const uint8_t *Data)
+{
+	return (uint32_t)InputRecord_Get16(Data)|((uint32_t)InputRecord_Get16(Data+2)<<16);
+}
+
+static int16_t InputRecord_Position(float Value)
+{
+	if(Value<(float)INT16_MIN)
+		return INT16_MIN;
+
+	if(Value>(float)INT16_MAX)
+		return INT16_MAX;
+
+	return (int16_t)Value;
+}
+
+bool InputRecord_Create(InputRecord_t *Record, const char *Filename, uint32_t Width, uint32_t Height)
+{
+	if(Record==NULL||Filename==NULL)
+		return false;
+
+	memset(Record, 0, sizeof(InputRecord_t));
+
+	Record->Stream=fopen(Filename, "wb");
+
+	if(Record->Stream==NULL)
+		return false;
+
+	Record->Width=Width;
+	Record->Height=Height;
+
+	uint8_t Header[INPUTRECORD_HEADER_SIZE];
+
+	InputRecord_Put32(&Header[0], INPUTRECORD_MAGIC);
+	InputRecord_Put16(&Header[4], INPUTRECORD_VERSION);
+	InputRecord_Put16(&Header[6], 0);
+	InputRecord_Put32(&Header[8], Width);
+	InputRecord_Put32(&Header[12], Height);
+
+	if(fwrite(Header, sizeof(Header), 1, Record->Stream)!=1)
+	{
+		InputRecord_Close(Record);
+		return false;
+	}
+
+	return true;
+}
+
+bool InputRecord_Open(InputRecord_t *Record, const char *Filename)
+{
+	if(Record==NULL||Filename==NULL)
+		return false;
+
+	memset(Record, 0, sizeof(InputRecord_t));
+
+	Record->Stream=fopen(Filename, "rb");
+
+	if(Record->Stream==NULL)
+		return false;
+
+	uint8_t Header[INPUTRECORD_HEADER_SIZE];
+
+	if(fread(Header, sizeof(Header), 1, Record->Stream)!=1||InputRecord_Get32(&Header[0])!=INPUTRECORD_MAGIC||InputRecord_Get16(&Header[4])!=INPUTRECORD_VERSION)
+	{
+		InputRecord_Close(Record);
+		return false;
+	}
+
+	Record->Width=InputRecord_Get32(&Header[8]);
+	Record->Height=InputRecord_Get32(&Header[12]);
+
+	return true;
+}
+
+bool InputRecord_WriteFrame(InputRecord_t *Record, double TimeStep, const InputSnapshot_t *Snapshot)
+{
+	if(Record==NULL||Record->Stream==NULL||Snapshot==NULL)
+		return false;
+
+	// Whole frame goes out in one write
+	uint8_t Data[INPUTRECORD_FRAME_SIZE+INPUTQUEUE_SIZE*INPUTRECORD_EVENT_SIZE];
+	uint8_t *Ptr=Data;
+	const float Step=(float)TimeStep;
+	uint32_t StepBits;
+
+	memcpy(&StepBits, &Step, sizeof(uint32_t));
+
+	InputRecord_Put32(Ptr, StepBits);
+	InputRecord_Put16(Ptr+4, (uint16_t)Snapshot->NumEvents);
+	Ptr+=INPUTRECORD_FRAME_SIZE;
+
+	for(uint32_t i=0;i<Snapshot->NumEvents;i++)
+	{
+		const InputEvent_t *Event=&Snapshot->Events[i];
+
+		Ptr[0]=(uint8_t)Event->Type;
+		Ptr[1]=(uint8_t)Event->Code;
+		InputRecord_Put16(Ptr+2, (uint16_t)InputRecord_Position(Event->X));
+		InputRecord_Put16(Ptr+4, (uint16_t)InputRecord_Position(Event->Y));
+		Ptr+=INPUTRECORD_EVENT_SIZE;
+	}
+
+	if(fwrite(Data, (size_t)(Ptr-Data), 1, Record->Stream)!=1)
+		return false;
+
+	Record->NumFrames++;
+
+	return true;
+}
+
+bool InputRecord_ReadFrame(InputRecord_t *Record, double *TimeStep, InputQueue_t *Queue)
+{
+	if(Record==NULL||Record->Stream==NULL||Queue==NULL)
+		return false;
+
+	uint8_t Frame[INPUTRECORD_FRAME_SIZE];
+
+	if(fread(Frame, sizeof(Frame), 1, Record->Stream)!=1)
+		return false;
+
+	const uint32_t StepBits=InputRecord_Get32(&Frame[0]);
+	const uint32_t NumEvents=InputRecord_Get16(&Frame[4]);
+	float Step;
+
+	if(NumEvents>INPUTQUEUE_SIZE)
+		return false;
+
+	memcpy(&Step, &StepBits, sizeof(float));
+
+	if(TimeStep)
+		*TimeStep=Step;
+
+	// Stamped as they're fed back, the same way the window procedure would have
+	const double Time=GetClock();
+
+	for(uint32_t i=0;i<NumEvents;i++)
+	{
+		uint8_t Data[INPUTRECORD_EVENT_SIZE];
+
+		if(fread(Data, sizeof(Data), 1, Record->Stream)!=1||Data[0]>=INPUT_NUM_TYPE)
+			return false;
+
+		InputEvent_t Event=
+		{
+			.Time=Time,
+			.Type=Data[0],
+			.Code=Data[1],
+			.X=(float)(int16_t)InputRecord_Get16(&Data[2]),
+			.Y=(float)(int16_t)InputRecord_Get16(&Data[4])
+		};
+
+		InputQueue_PushEvent(Queue, &Event);
+	}
+
+	Record->NumFrames++;
+
+	return true;
+}
+
+void InputRecord_Close(InputRecord_t *Record)
+{
+	if(Record==NULL)
+		return;
+
+	if(Record->Stream!=NULL)
+	{
+		fclose(Record->Stream);
+		Record->Stream=NULL;
+	}
+}
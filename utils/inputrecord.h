@@ -0,0 +1,38 @@
+#ifndef __INPUTRECORD_H__
+#define __INPUTRECORD_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "inputqueue.h"
+
+// "UIRC", little endian
+#define INPUTRECORD_MAGIC 0x43524955u
+#define INPUTRECORD_VERSION 1
+
+// File layout, all little endian:
+//   Header: u32 magic, u16 version, u16 reserved, u32 width, u32 height
+//   Frame:  f32 time step, u16 event count, then per event: u8 type, u8 code, i16 x, i16 y
+// Positions are whole client pixels and codes are buttons or virtual keys, so an event fits in 6 bytes and an idle frame
+// in 6 more. Event times aren't kept, a replay runs on its own clock.
+typedef struct
+{
+	FILE *Stream;
+
+	// Size the session was recorded at, a replay needs the same layout
+	uint32_t Width, Height;
+
+	uint32_t NumFrames;
+} InputRecord_t;
+
+// Starts a new recording, writing the header
+bool InputRecord_Create(InputRecord_t *Record, const char *Filename, uint32_t Width, uint32_t Height);
+// Opens a recording for playback and reads its header
+bool InputRecord_Open(InputRecord_t *Record, const char *Filename);
+// Appends one frame: the time step it ran with and the input it drained
+bool InputRecord_WriteFrame(InputRecord_t *Record, double TimeStep, const InputSnapshot_t *Snapshot);
+// Reads the next frame, pushing its events onto Queue. False at the end of the recording or if it's damaged.
+bool InputRecord_ReadFrame(InputRecord_t *Record, double *TimeStep, InputQueue_t *Queue);
+void InputRecord_Close(InputRecord_t *Record);
+
+#endif
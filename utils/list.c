@@ -69,15 +69,20 @@ bool List_Add(List_t *List, void *Data)
 	if(List->Size>=List->bufSize)
 	{
 		// Over allocate memory to save from having to resize later
-		List->bufSize=List->Size*2;
+		size_t newBufSize=List->Size*2;
 
 		// Reallocate the buffer
-		uint8_t *Ptr=(uint8_t *)realloc(List->Buffer, List->bufSize);
+		uint8_t *Ptr=(uint8_t *)realloc(List->Buffer, newBufSize);
 
+		// Leave the list as it was, it's still valid
 		if(Ptr==NULL)
+		{
+			List->Size=oldSize;
 			return false;
+		}
 
 		List->Buffer=Ptr;
+		List->bufSize=newBufSize;
 	}
 
 	// Copy the data into the new memory
@@ -95,8 +100,8 @@ bool List_Del(List_t *List, const size_t Index)
 	if((Index*List->Stride)>=List->Size)
 		return false;
 
-	// Shift data from index to end, overwriting the item to be removed
-	memcpy(&List->Buffer[Index*List->Stride], &List->Buffer[(Index+1)*List->Stride], List->Size-(Index*List->Stride));
+	// Shift data from index to end, overwriting the item to be removed (regions overlap, and the tail is one item shorter than what's left)
+	memmove(&List->Buffer[Index*List->Stride], &List->Buffer[(Index+1)*List->Stride], List->Size-((Index+1)*List->Stride));
 	// Update list size
 	List->Size-=List->Stride;
 
@@ -0,0 +1,210 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "list.h"
+#include "stringpool.h"
+
+#define STRINGPOOL_END UINT32_MAX
+#define STRINGPOOL_INITIAL_BUCKETS 64
+
+bool StringPool_Init(StringPool_t *Pool)
+{
+	if(Pool==NULL)
+		return false;
+
+	memset(Pool, 0, sizeof(StringPool_t));
+
+	Pool->Free=STRINGPOOL_END;
+	Pool->NumBuckets=STRINGPOOL_INITIAL_BUCKETS;
+	Pool->Buckets=(uint32_t *)malloc(Pool->NumBuckets*sizeof(uint32_t));
+
+	if(Pool->Buckets==NULL)
+		return false;
+
+	for(uint32_t i=0;i<Pool->NumBuckets;i++)
+		Pool->Buckets[i]=STRINGPOOL_END;
+
+	return List_Init(&Pool->Entries, sizeof(StringPool_Entry_t), 0, NULL);
+}
+
+void StringPool_Destroy(StringPool_t *Pool)
+{
+	if(Pool==NULL)
+		return;
+
+	for(uint32_t i=0;i<List_GetCount(&Pool->Entries);i++)
+		free(((StringPool_Entry_t *)List_GetPointer(&Pool->Entries, i))->String);
+
+	List_Destroy(&Pool->Entries);
+	free(Pool->Buckets);
+
+	memset(Pool, 0, sizeof(StringPool_t));
+}
+
+static StringPool_Entry_t *StringPool_GetEntry(const StringPool_t *Pool, uint32_t Index)
+{
+	return (StringPool_Entry_t *)List_GetPointer((List_t *)&Pool->Entries, Index);
+}
+
+// FNV-1a, working out the length on the way
+static uint32_t StringPool_Hash(const char *String, uint32_t *Length)
+{
+	uint32_t Hash=2166136261u;
+	const char *ptr;
+
+	for(ptr=String;*ptr;ptr++)
+	{
+		Hash^=(uint8_t)*ptr;
+		Hash*=16777619u;
+	}
+
+	*Length=(uint32_t)(ptr-String);
+
+	return Hash;
+}
+
+// Doubles the bucket count and relinks every string, keeps chains short as the pool fills
+static bool StringPool_Grow(StringPool_t *Pool)
+{
+	const uint32_t NumBuckets=Pool->NumBuckets*2;
+	uint32_t *Buckets=(uint32_t *)malloc(NumBuckets*sizeof(uint32_t));
+
+	if(Buckets==NULL)
+		return false;
+
+	for(uint32_t i=0;i<NumBuckets;i++)
+		Buckets[i]=STRINGPOOL_END;
+
+	for(uint32_t i=0;i<List_GetCount(&Pool->Entries);i++)
+	{
+		StringPool_Entry_t *Entry=StringPool_GetEntry(Pool, i);
+
+		if(Entry->String==NULL)
+			continue;
+
+		Entry->Next=Buckets[Entry->Hash&(NumBuckets-1)];
+		Buckets[Entry->Hash&(NumBuckets-1)]=i;
+	}
+
+	free(Pool->Buckets);
+	Pool->Buckets=Buckets;
+	Pool->NumBuckets=NumBuckets;
+
+	return true;
+}
+
+uint32_t StringPool_Intern(StringPool_t *Pool, const char *String)
+{
+	if(Pool==NULL||String==NULL||*String=='\0')
+		return STRINGPOOL_NONE;
+
+	uint32_t Length;
+	const uint32_t Hash=StringPool_Hash(String, &Length);
+
+	for(uint32_t Index=Pool->Buckets[Hash&(Pool->NumBuckets-1)];Index!=STRINGPOOL_END;)
+	{
+		StringPool_Entry_t *Entry=StringPool_GetEntry(Pool, Index);
+
+		if(Entry->Hash==Hash&&Entry->Length==Length&&memcmp(Entry->String, String, Length)==0)
+		{
+			Entry->RefCount++;
+			return Index+1;
+		}
+
+		Index=Entry->Next;
+	}
+
+	// Not a big deal if this fails, the chains just get longer
+	if(Pool->NumStrings>=Pool->NumBuckets)
+		StringPool_Grow(Pool);
+
+	char *Copy=(char *)malloc(Length+1);
+
+	if(Copy==NULL)
+		return STRINGPOOL_NONE;
+
+	memcpy(Copy, String, Length+1);
+
+	uint32_t Index=Pool->Free;
+
+	if(Index!=STRINGPOOL_END)
+		Pool->Free=StringPool_GetEntry(Pool, Index)->Next;
+	else
+	{
+		StringPool_Entry_t Empty={ 0 };
+
+		if(!List_Add(&Pool->Entries, &Empty))
+		{
+			free(Copy);
+			return STRINGPOOL_NONE;
+		}
+
+		Index=(uint32_t)List_GetCount(&Pool->Entries)-1;
+	}
+
+	StringPool_Entry_t *Entry=StringPool_GetEntry(Pool, Index);
+
+	Entry->String=Copy;
+	Entry->Length=Length;
+	Entry->Hash=Hash;
+	Entry->RefCount=1;
+	Entry->Next=Pool->Buckets[Hash&(Pool->NumBuckets-1)];
+	Pool->Buckets[Hash&(Pool->NumBuckets-1)]=Index;
+	Pool->NumStrings++;
+
+	return Index+1;
+}
+
+void StringPool_Release(StringPool_t *Pool, uint32_t Handle)
+{
+	if(Pool==NULL||Handle==STRINGPOOL_NONE)
+		return;
+
+	const uint32_t Index=Handle-1;
+	StringPool_Entry_t *Entry=StringPool_GetEntry(Pool, Index);
+
+	if(Entry==NULL||Entry->String==NULL||--Entry->RefCount)
+		return;
+
+	// Unlink from its chain
+	uint32_t *Link=&Pool->Buckets[Entry->Hash&(Pool->NumBuckets-1)];
+
+	while(*Link!=Index)
+		Link=&StringPool_GetEntry(Pool, *Link)->Next;
+
+	*Link=Entry->Next;
+
+	free(Entry->String);
+	memset(Entry, 0, sizeof(StringPool_Entry_t));
+
+	Entry->Next=Pool->Free;
+	Pool->Free=Index;
+	Pool->NumStrings--;
+}
+
+const char *StringPool_GetString(const StringPool_t *Pool, uint32_t Handle)
+{
+	if(Pool==NULL||Handle==STRINGPOOL_NONE)
+		return "";
+
+	const StringPool_Entry_t *Entry=StringPool_GetEntry(Pool, Handle-1);
+
+	if(Entry==NULL||Entry->String==NULL)
+		return "";
+
+	return Entry->String;
+}
+
+uint32_t StringPool_GetLength(const StringPool_t *Pool, uint32_t Handle)
+{
+	if(Pool==NULL||Handle==STRINGPOOL_NONE)
+		return 0;
+
+	const StringPool_Entry_t *Entry=StringPool_GetEntry(Pool, Handle-1);
+
+	if(Entry==NULL)
+		return 0;
+
+	return Entry->Length;
+}
@@ -0,0 +1,45 @@
+#ifndef __STRINGPOOL_H__
+#define __STRINGPOOL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "list.h"
+
+// Handle value for "no string", reads back as an empty string. Handles are entry index+1.
+#define STRINGPOOL_NONE 0
+
+typedef struct
+{
+	// NULL when the entry is free
+	char *String;
+	uint32_t Length, Hash;
+	uint32_t RefCount;
+
+	// Next entry in the same bucket, or the next free entry
+	uint32_t Next;
+} StringPool_Entry_t;
+
+// Deduplicated, reference counted strings, each stored once with its length and hash
+typedef struct
+{
+	List_t Entries;
+	uint32_t Free;
+
+	// Power of two number of bucket chains
+	uint32_t *Buckets;
+	uint32_t NumBuckets, NumStrings;
+} StringPool_t;
+
+bool StringPool_Init(StringPool_t *Pool);
+void StringPool_Destroy(StringPool_t *Pool);
+
+// Returns a handle to String, adding it if it isn't already there, and takes a reference to it.
+// NULL and empty strings are STRINGPOOL_NONE, as is running out of memory.
+uint32_t StringPool_Intern(StringPool_t *Pool, const char *String);
+// Drops a reference from Intern, the string is freed with the last one
+void StringPool_Release(StringPool_t *Pool, uint32_t Handle);
+
+const char *StringPool_GetString(const StringPool_t *Pool, uint32_t Handle);
+uint32_t StringPool_GetLength(const StringPool_t *Pool, uint32_t Handle);
+
+#endif
@@ -0,0 +1,210 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "threads.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+// Platform wrappers, keeps the pool logic below in one piece
+#ifdef _WIN32
+#define MUTEX_LOCK(m) EnterCriticalSection(m)
+#define MUTEX_UNLOCK(m) LeaveCriticalSection(m)
+#define COND_WAIT(c, m) SleepConditionVariableCS(c, m, INFINITE)
+#define COND_SIGNAL(c) WakeConditionVariable(c)
+#define COND_BROADCAST(c) WakeAllConditionVariable(c)
+#else
+#define MUTEX_LOCK(m) pthread_mutex_lock(m)
+#define MUTEX_UNLOCK(m) pthread_mutex_unlock(m)
+#define COND_WAIT(c, m) pthread_cond_wait(c, m)
+#define COND_SIGNAL(c) pthread_cond_signal(c)
+#define COND_BROADCAST(c) pthread_cond_broadcast(c)
+#endif
+
+// Returns the value before the increment
+static uint32_t Thread_AtomicFetchInc(volatile uint32_t *Value)
+{
+#ifdef _WIN32
+	return (uint32_t)InterlockedIncrement((volatile LONG *)Value)-1;
+#else
+	return __atomic_fetch_add(Value, 1, __ATOMIC_ACQ_REL);
+#endif
+}
+
+uint32_t Thread_GetCPUCount(void)
+{
+#ifdef _WIN32
+	SYSTEM_INFO Info;
+
+	GetSystemInfo(&Info);
+
+	return Info.dwNumberOfProcessors?Info.dwNumberOfProcessors:1;
+#else
+	long Count=sysconf(_SC_NPROCESSORS_ONLN);
+
+	return Count>0?(uint32_t)Count:1;
+#endif
+}
+
+// Claims and runs indices until the batch is used up
+static void ThreadPool_RunJobs(ThreadPool_t *Pool, ThreadPoolJob Job, void *Arg, uint32_t Count)
+{
+	uint32_t Index;
+
+	while((Index=Thread_AtomicFetchInc(&Pool->Next))<Count)
+		Job(Arg, Index);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI ThreadPool_Worker(LPVOID Data)
+#else
+static void *ThreadPool_Worker(void *Data)
+#endif
+{
+	ThreadPool_t *Pool=(ThreadPool_t *)Data;
+	uint32_t Seen=0;
+
+	MUTEX_LOCK(&Pool->Mutex);
+
+	for(;;)
+	{
+		while(!Pool->Quit&&Pool->Generation==Seen)
+			COND_WAIT(&Pool->WorkCond, &Pool->Mutex);
+
+		if(Pool->Quit)
+			break;
+
+		// Grab the batch while it's consistent
+		ThreadPoolJob Job=Pool->Job;
+		void *Arg=Pool->Arg;
+		uint32_t Count=Pool->Count;
+
+		Seen=Pool->Generation;
+
+		MUTEX_UNLOCK(&Pool->Mutex);
+
+		ThreadPool_RunJobs(Pool, Job, Arg, Count);
+
+		MUTEX_LOCK(&Pool->Mutex);
+
+		// Every worker checks in once per batch, so none can wander into the next one with a stale job
+		if(++Pool->Finished==Pool->NumThreads-1)
+			COND_SIGNAL(&Pool->DoneCond);
+	}
+
+	MUTEX_UNLOCK(&Pool->Mutex);
+
+	return 0;
+}
+
+bool ThreadPool_Init(ThreadPool_t *Pool, uint32_t NumThreads)
+{
+	if(Pool==NULL)
+		return false;
+
+	memset(Pool, 0, sizeof(ThreadPool_t));
+
+	if(NumThreads<1)
+		NumThreads=1;
+
+	if(NumThreads>THREADPOOL_MAX_THREADS)
+		NumThreads=THREADPOOL_MAX_THREADS;
+
+#ifdef _WIN32
+	InitializeCriticalSection(&Pool->Mutex);
+	InitializeConditionVariable(&Pool->WorkCond);
+	InitializeConditionVariable(&Pool->DoneCond);
+#else
+	pthread_mutex_init(&Pool->Mutex, NULL);
+	pthread_cond_init(&Pool->WorkCond, NULL);
+	pthread_cond_init(&Pool->DoneCond, NULL);
+#endif
+
+	// The dispatching thread is the first "worker"
+	Pool->NumThreads=1;
+
+	for(uint32_t i=0;i<NumThreads-1;i++)
+	{
+#ifdef _WIN32
+		Pool->Threads[i]=CreateThread(NULL, 0, ThreadPool_Worker, Pool, 0, NULL);
+
+		if(Pool->Threads[i]==NULL)
+			break;
+#else
+		if(pthread_create(&Pool->Threads[i], NULL, ThreadPool_Worker, Pool))
+			break;
+#endif
+
+		Pool->NumThreads++;
+	}
+
+	return true;
+}
+
+void ThreadPool_Destroy(ThreadPool_t *Pool)
+{
+	// Never initialized (or already destroyed)
+	if(Pool==NULL||!Pool->NumThreads)
+		return;
+
+	MUTEX_LOCK(&Pool->Mutex);
+	Pool->Quit=true;
+	COND_BROADCAST(&Pool->WorkCond);
+	MUTEX_UNLOCK(&Pool->Mutex);
+
+	for(uint32_t i=0;i+1<Pool->NumThreads;i++)
+	{
+#ifdef _WIN32
+		WaitForSingleObject(Pool->Threads[i], INFINITE);
+		CloseHandle(Pool->Threads[i]);
+#else
+		pthread_join(Pool->Threads[i], NULL);
+#endif
+	}
+
+#ifdef _WIN32
+	DeleteCriticalSection(&Pool->Mutex);
+#else
+	pthread_cond_destroy(&Pool->DoneCond);
+	pthread_cond_destroy(&Pool->WorkCond);
+	pthread_mutex_destroy(&Pool->Mutex);
+#endif
+
+	memset(Pool, 0, sizeof(ThreadPool_t));
+}
+
+void ThreadPool_Dispatch(ThreadPool_t *Pool, ThreadPoolJob Job, void *Arg, uint32_t Count)
+{
+	if(Pool==NULL||Job==NULL||!Count)
+		return;
+
+	// No workers, or not worth waking them
+	if(Pool->NumThreads<=1||Count==1)
+	{
+		for(uint32_t i=0;i<Count;i++)
+			Job(Arg, i);
+
+		return;
+	}
+
+	MUTEX_LOCK(&Pool->Mutex);
+	Pool->Job=Job;
+	Pool->Arg=Arg;
+	Pool->Count=Count;
+	Pool->Next=0;
+	Pool->Finished=0;
+	Pool->Generation++;
+	COND_BROADCAST(&Pool->WorkCond);
+	MUTEX_UNLOCK(&Pool->Mutex);
+
+	ThreadPool_RunJobs(Pool, Job, Arg, Count);
+
+	// Every index has been claimed at this point, wait for the workers to finish theirs
+	MUTEX_LOCK(&Pool->Mutex);
+
+	while(Pool->Finished<Pool->NumThreads-1)
+		COND_WAIT(&Pool->DoneCond, &Pool->Mutex);
+
+	MUTEX_UNLOCK(&Pool->Mutex);
+}
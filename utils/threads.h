@@ -0,0 +1,50 @@
+#ifndef __THREADS_H__
+#define __THREADS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+// Upper bound on workers, more than this is just contention for our workloads
+#define THREADPOOL_MAX_THREADS 64
+
+typedef void (*ThreadPoolJob)(void *Arg, uint32_t Index);
+
+typedef struct
+{
+#ifdef _WIN32
+	CRITICAL_SECTION Mutex;
+	CONDITION_VARIABLE WorkCond, DoneCond;
+	HANDLE Threads[THREADPOOL_MAX_THREADS];
+#else
+	pthread_mutex_t Mutex;
+	pthread_cond_t WorkCond, DoneCond;
+	pthread_t Threads[THREADPOOL_MAX_THREADS];
+#endif
+
+	// Number of threads doing work, including the thread calling ThreadPool_Dispatch
+	uint32_t NumThreads;
+
+	// Current batch, protected by the mutex except for Next which is claimed atomically
+	ThreadPoolJob Job;
+	void *Arg;
+	uint32_t Count;
+	volatile uint32_t Next;
+	uint32_t Finished;
+	uint32_t Generation;
+	bool Quit;
+} ThreadPool_t;
+
+uint32_t Thread_GetCPUCount(void);
+
+bool ThreadPool_Init(ThreadPool_t *Pool, uint32_t NumThreads);
+void ThreadPool_Destroy(ThreadPool_t *Pool);
+// Runs Job(Arg, 0..Count-1) spread over the pool and the calling thread, returns once every index is done.
+void ThreadPool_Dispatch(ThreadPool_t *Pool, ThreadPoolJob Job, void *Arg, uint32_t Count);
+
+#endif